@@ -28,33 +28,70 @@ class Creator(nc.Creator):
         self.minz = None
         self.path = None
         self.pdcf = None
+        self.pdcf_cutter = None
         self.material_allowance = 0.0
+        self.moves = []     # moves waiting to be projected and passed on to the original creator
+        self.drops = {}     # (x, y) => height the cutter drops to from minz
 
     ############################################################################
     ##  Shift in Z
     
     def setPdcfIfNotSet(self):
-        if self.pdcf == None:
+        if self.pdcf == None or self.pdcf_cutter is not self.cutter:
             self.pdcf = ocl.PathDropCutter()
             self.pdcf.setSTL(self.stl)
             self.pdcf.setCutter(self.cutter)
             self.pdcf.setSampling(0.1)
             self.pdcf.setZ(self.minz)
-                    
-    def z2(self, z):
-        path = ocl.Path()
-        # use a line with no length
-        path.append(ocl.Line(ocl.Point(self.x, self.y, self.z), ocl.Point(self.x, self.y, self.z)))
+            self.pdcf_cutter = self.cutter
+            self.drops = {}
+
+    def drop(self, x, y):
+        # height the cutter drops to at x, y, starting from minz
         self.setPdcfIfNotSet()
-        if (self.z>self.minz):
-            self.pdcf.setZ(self.z)  # Adjust Z if we have gotten a higher limit (Fix pocketing loosing steps when using attach?)
-        else:
-            self.pdcf.setZ(self.minz) # Else use minz
-        self.pdcf.setPath(path)
-        self.pdcf.run()
-        plist = self.pdcf.getCLPoints()
-        p = plist[0]
-        return p.z + self.material_allowance
+        key = (x, y)
+        if key not in self.drops:
+            self.drop_all([key])
+        return self.drops[key]
+
+    def drop_all(self, points):
+        # drop the cutter at all the points that haven't been done yet in one go
+        self.setPdcfIfNotSet()
+        todo = []       # in the order they were asked for
+        queued = set()
+        for key in points:
+            if key in self.drops or key in queued: continue
+            todo.append(key)
+            queued.add(key)
+        if len(todo) == 0: return
+
+        if hasattr(ocl, 'BatchDropCutter'):
+            bdc = ocl.BatchDropCutter()
+            bdc.setSTL(self.stl)
+            bdc.setCutter(self.cutter)
+            for key in todo:
+                bdc.appendPoint(ocl.CLPoint(key[0], key[1], self.minz))
+            bdc.run()
+            plist = bdc.getCLPoints()
+            for i in range(0, len(todo)):
+                self.drops[todo[i]] = max(plist[i].z, self.minz)
+            return
+
+        self.pdcf.setZ(self.minz)
+        for key in todo:
+            # use a line with no length
+            path = ocl.Path()
+            path.append(ocl.Line(ocl.Point(key[0], key[1], self.minz), ocl.Point(key[0], key[1], self.minz)))
+            self.pdcf.setPath(path)
+            self.pdcf.run()
+            self.drops[key] = self.pdcf.getCLPoints()[0].z
+
+    def z2(self, z):
+        # the drop cutter only ever lifts the cutter from the Z it starts at, so the result is the
+        # drop from minz or the current Z, whichever is higher
+        zlimit = self.z
+        if zlimit < self.minz: zlimit = self.minz
+        return max(self.drop(self.x, self.y), zlimit) + self.material_allowance
 
     ############################################################################
     ##  Programs
@@ -187,23 +224,44 @@ class Creator(nc.Creator):
     ##  Moves
 
     def rapid(self, x=None, y=None, z=None, a=None, b=None, c=None):
-        self.cut_path()
-        self.original.rapid(x, y, z, a, b, c)
+        self.end_path()
+        self.moves.append(('rapid', x, y, z, a, b, c))
         if x != None: self.x = x * units
         if y != None: self.y = y * units
         if z != None: self.z = z * units
-        
-    def cut_path(self):
+
+    def end_path(self):
+        # the path is dropped from the Z we're at when it finishes
         if self.path == None: return
+        zlimit = self.z
+        if zlimit < self.minz: zlimit = self.minz
+        self.moves.append(('path', self.path, zlimit))
+        self.path = None
+
+    def cut_path(self):
+        # project all the moves collected since the last time and pass them on to the original creator
+        self.end_path()
+        if len(self.moves) == 0: return
+        moves = self.moves
+        self.moves = []
+
+        # all the plunges are dropped in one batch
+        self.drop_all([(m[1], m[2]) for m in moves if m[0] == 'z'])
+
+        for m in moves:
+            if m[0] == 'rapid':
+                self.original.rapid(m[1], m[2], m[3], m[4], m[5], m[6])
+            elif m[0] == 'z':
+                self.original.feed(m[1]/units, m[2]/units, (max(self.drops[(m[1], m[2])], m[3]) + self.material_allowance)/units)
+            else:
+                self.project_path(m[1], m[2])
+
+    def project_path(self, path, zlimit):
         self.setPdcfIfNotSet()
-        
-        if (self.z>self.minz):
-            self.pdcf.setZ(self.z)  # Adjust Z if we have gotten a higher limit (Fix pocketing loosing steps when using attach?)
-        else:
-            self.pdcf.setZ(self.minz) # Else use minz
-            
+        self.pdcf.setZ(zlimit)
+
        # get the points on the surface
-        self.pdcf.setPath(self.path)
+        self.pdcf.setPath(path)
         self.pdcf.run()
         plist = self.pdcf.getCLPoints()
         
@@ -220,8 +278,6 @@ class Creator(nc.Creator):
             if i > 0:
                 self.original.feed(p.x/units, p.y/units, p.z/units + self.material_allowance)
             i = i + 1
-            
-        self.path = ocl.Path()
 
     def feed(self, x=None, y=None, z=None):
         px = self.x
@@ -236,8 +292,10 @@ class Creator(nc.Creator):
             return
         if px == self.x and py == self.y:
             # z move only
-            self.cut_path()
-            self.original.feed(self.x/units, self.y/units, self.z2(self.z)/units)
+            self.end_path()
+            zlimit = self.z
+            if zlimit < self.minz: zlimit = self.minz
+            self.moves.append(('z', self.x, self.y, zlimit))
             return
             
         # add a line to the path
@@ -0,0 +1,24 @@
+################################################################################
+# emc2_native.py
+#
+# NC code creator that writes exactly what emc2.py writes, using the same C++
+# code as iso_native.py.  Without the 'nciso' extension, emc2.py is used instead.
+
+import nc
+import iso_native
+
+# emc2.py writes NC code for these, which the native creator doesn't.
+not_native = ['measure_and_offset_tool', 'probe_grid', 'report_probe_results',
+              'open_log_file', 'log_coordinate', 'close_log_file']
+
+if iso_native.nciso != None:
+    class Creator(iso_native.Creator):
+        def __init__(self):
+            iso_native.Creator.__init__(self, iso_native.nciso.EMC2)
+
+    for name in not_native:
+        setattr(Creator, name, iso_native.not_supported(name))
+
+    nc.creator = Creator()
+else:
+    import emc2
@@ -215,10 +215,22 @@ class Creator(nc.Creator):
     def sub_begin(self, id, name=''):
         self.write((self.PROGRAM() % id) + self.SPACE() + (self.COMMENT(name)))
         self.write('\n')
+        # A subroutine can be called from anywhere so don't rely on any modal codes from before it.
+        self.reset_modal()
 
     def sub_call(self, id):
         self.write_blocknum()
         self.write(self.SPACE() + (self.SUBPROG_CALL() % id) + '\n')
+        # Nor rely on those left behind by it.
+        self.reset_modal()
+
+    def reset_modal(self):
+        self.prev_f = ''
+        self.prev_g0123 = ''
+        self.prev_drill = ''
+        self.prev_retract = ''
+        self.prev_z = ''
+        self.g_plane.previous = None
 
     def sub_end(self):
         self.write_blocknum()
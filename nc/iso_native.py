@@ -0,0 +1,51 @@
+################################################################################
+# iso_native.py
+#
+# NC code creator that writes exactly what iso.py writes, but does it in C++
+# (src/IsoCreator.cpp) so that long programs don't spend their time formatting
+# numbers in Python.  It needs the 'nciso' extension module, built with HeeksCNC
+# and installed next to this file.  Without it, iso.py is used instead.
+#
+# Only the calls used for cutting are written natively.  The probing, tapping
+# and boring routines raise NotImplementedError rather than being silently left
+# out of the program; use the Python post-processor for those.
+
+import nc
+
+try:
+    import nciso
+except ImportError:
+    nciso = None
+
+# iso.py writes nothing for these.
+ignored = ['offset_radius', 'offset_length', 'measure_and_offset_tool', 'datum_shift', 'datum_set',
+           'rapid_home', 'rapid_unhome', 'pattern', 'pocket', 'profile', 'bore', 'insert', 'block_delete',
+           'probe_grid', 'report_probe_results', 'open_log_file', 'log_coordinate', 'close_log_file']
+
+not_native = ['gearrange', 'boring', 'tap', 'probe_single_point', 'probe_downward_point',
+              'rapid_to_midpoint', 'rapid_to_intersection', 'rapid_to_rotated_coordinate', 'set_path_control_mode']
+
+def ignore(self, *args, **kwargs):
+    pass
+
+def not_supported(name):
+    def call(self, *args, **kwargs):
+        raise NotImplementedError(name + '() is not written by the native NC code creator; choose the Python machine instead')
+    return call
+
+if nciso != None:
+    class Creator(nciso.Creator):
+        def __init__(self, dialect = nciso.ISO):
+            nciso.Creator.__init__(self, dialect)
+
+        def variable(self, id):
+            return '#%i' % id
+
+    for name in ignored:
+        setattr(Creator, name, ignore)
+    for name in not_native:
+        setattr(Creator, name, not_supported(name))
+
+    nc.creator = Creator()
+else:
+    import iso
@@ -0,0 +1,460 @@
+################################################################################
+# level.py
+#
+# NC code creator for following a probed height map
+#
+# Every move is passed on to the original creator with its Z coordinate raised or
+# lowered by the height of the probed surface below it.  The surface is
+# interpolated bilinearly between a grid of probed points.  Feed moves are split
+# where they cross the grid lines (and again if the surface bends too much within a
+# cell) and arcs (whether given by their centre or their radius) are broken into feed
+# moves so that each piece follows the surface.
+#
+# The height map's points must be in the same units and coordinate system as the
+# program.  Heights are relative to the surface at the fixture's origin (where the
+# Z axis would have been touched off).
+
+import nc
+import math
+
+levelled = False
+
+################################################################################
+class HeightMap:
+
+    def __init__(self, points, tolerance):
+        self.tolerance = tolerance
+        self.xs = self.grid_lines([p[0] for p in points])
+        self.ys = self.grid_lines([p[1] for p in points])
+        self.heights = None
+        self.plane = None
+
+        heights = {}
+        for p in points:
+            heights[(self.nearest(self.xs, p[0]), self.nearest(self.ys, p[1]))] = p[2]
+
+        if len(self.xs) >= 2 and len(self.ys) >= 2 and len(heights) == len(self.xs) * len(self.ys):
+            self.heights = [[heights[(ix, iy)] for iy in range(0, len(self.ys))] for ix in range(0, len(self.xs))]
+            self.dx = self.spacing(self.xs)
+            self.dy = self.spacing(self.ys)
+        else:
+            # not a complete grid. Use the plane that best fits the points.
+            self.plane = self.fit_plane(points)
+
+        self.reference = 0.0
+        self.reference = self.height(0.0, 0.0)
+
+    def grid_lines(self, values):
+        # the distinct values, merging any closer together than the tolerance
+        lines = []
+        for v in sorted(values):
+            if len(lines) == 0 or v - lines[-1] > self.tolerance:
+                lines.append(v)
+        return lines
+
+    def nearest(self, lines, v):
+        best = 0
+        for i in range(1, len(lines)):
+            if math.fabs(lines[i] - v) < math.fabs(lines[best] - v): best = i
+        return best
+
+    def spacing(self, lines):
+        # the gap between grid lines if they're evenly spaced, so cells can be found without searching
+        d = (lines[-1] - lines[0]) / (len(lines) - 1)
+        for i in range(1, len(lines)):
+            if math.fabs(lines[i] - lines[i-1] - d) > self.tolerance: return None
+        return d
+
+    def fit_plane(self, points):
+        # least squares fit of z = a + b * x + c * y
+        n = float(len(points))
+        if n == 0: return (0.0, 0.0, 0.0)
+        mx = sum([p[0] for p in points]) / n
+        my = sum([p[1] for p in points]) / n
+        mz = sum([p[2] for p in points]) / n
+        sxx = sum([(p[0] - mx) * (p[0] - mx) for p in points])
+        syy = sum([(p[1] - my) * (p[1] - my) for p in points])
+        sxy = sum([(p[0] - mx) * (p[1] - my) for p in points])
+        sxz = sum([(p[0] - mx) * (p[2] - mz) for p in points])
+        syz = sum([(p[1] - my) * (p[2] - mz) for p in points])
+        det = sxx * syy - sxy * sxy
+        if math.fabs(det) < 1e-12:
+            return (mz, 0.0, 0.0)
+        b = (sxz * syy - syz * sxy) / det
+        c = (syz * sxx - sxz * sxy) / det
+        return (mz - b * mx - c * my, b, c)
+
+    def cell(self, lines, d, v):
+        # index of the grid line at or below v, clamped so there's always a line above it
+        if d != None:
+            i = int(math.floor((v - lines[0]) / d))
+        else:
+            lo = 0
+            hi = len(lines) - 1
+            while hi - lo > 1:
+                mid = (lo + hi) // 2
+                if lines[mid] <= v: lo = mid
+                else: hi = mid
+            i = lo
+        if i < 0: return 0
+        if i > len(lines) - 2: return len(lines) - 2
+        return i
+
+    def height(self, x, y):
+        if self.plane != None:
+            return self.plane[0] + self.plane[1] * x + self.plane[2] * y - self.reference
+
+        # outside the grid the surface carries on at the height of its edge
+        ix = self.cell(self.xs, self.dx, x)
+        iy = self.cell(self.ys, self.dy, y)
+        u = (min(max(x, self.xs[0]), self.xs[-1]) - self.xs[ix]) / (self.xs[ix+1] - self.xs[ix])
+        v = (min(max(y, self.ys[0]), self.ys[-1]) - self.ys[iy]) / (self.ys[iy+1] - self.ys[iy])
+        h = self.heights
+        z = (h[ix][iy] * (1.0 - u) + h[ix+1][iy] * u) * (1.0 - v) + (h[ix][iy+1] * (1.0 - u) + h[ix+1][iy+1] * u) * v
+        return z - self.reference
+
+    def crossings(self, lines, d, a, b):
+        # the fractions along a line from a to b where it crosses the grid lines.
+        # Only the lines between the cells at each end are looked at (one more either side
+        # in case of rounding), so a short move doesn't look at the whole grid.
+        if self.plane != None or a == b: return []
+        lo = min(a, b)
+        hi = max(a, b)
+        if hi <= lines[0] or lo >= lines[-1]: return []
+        first = max(self.cell(lines, d, lo) - 1, 0)
+        last = min(self.cell(lines, d, hi) + 2, len(lines) - 1)
+        result = []
+        for v in lines[first:last + 1]:
+            if v > lo and v < hi: result.append((v - a) / (b - a))
+        return result
+
+################################################################################
+class Creator(nc.Creator):
+
+    def __init__(self, original, height_map):
+        nc.Creator.__init__(self)
+
+        self.original = original
+        self.height_map = height_map
+        self.x = None
+        self.y = None
+        self.z = None
+
+    ############################################################################
+    ##  Levelled moves
+
+    def level(self, x, y, z):
+        return z + self.height_map.height(x, y)
+
+    def feed_to(self, x, y, z):
+        # split the line where it crosses the grid, and then wherever the surface bends away from it
+        if self.x == None or self.y == None or self.z == None or (x == self.x and y == self.y):
+            self.original.feed(x, y, self.level(x, y, z))
+            return
+
+        m = self.height_map
+        fractions = m.crossings(m.xs, m.dx, self.x, x) + m.crossings(m.ys, m.dy, self.y, y)
+        fractions.sort()
+        fractions.append(1.0)
+
+        x0 = self.x
+        y0 = self.y
+        z0 = self.z
+        t0 = 0.0
+        for t1 in fractions:
+            if t1 - t0 < 1e-9: continue
+            x1 = x0 + (x - x0) * t1
+            y1 = y0 + (y - y0) * t1
+            h1 = m.height(x1, y1)
+
+            # within a cell the surface along a line is a parabola. Its deviation from
+            # the chord is four times what it is for a piece half as long.
+            t = (t0 + t1) / 2
+            deviation = math.fabs(m.height(x0 + (x - x0) * t, y0 + (y - y0) * t) - (m.height(x0 + (x - x0) * t0, y0 + (y - y0) * t0) + h1) / 2)
+            pieces = 1
+            if deviation > m.tolerance: pieces = int(math.ceil(math.sqrt(deviation / m.tolerance)))
+
+            for i in range(1, pieces + 1):
+                s = t0 + (t1 - t0) * i / pieces
+                px = x0 + (x - x0) * s
+                py = y0 + (y - y0) * s
+                self.original.feed(px, py, z0 + (z - z0) * s + m.height(px, py))
+            t0 = t1
+
+    def rapid(self, x=None, y=None, z=None, a=None, b=None, c=None, machine_coordinates=None):
+        if machine_coordinates:
+            # the machine's coordinates don't move with the work
+            self.original.rapid(x, y, z, a, b, c, machine_coordinates)
+            if z != None: self.z = None
+            return
+
+        if x != None: self.x = x
+        if y != None: self.y = y
+        if z != None: self.z = z
+        if self.x == None or self.y == None or self.z == None:
+            self.original.rapid(x, y, z, a, b, c)
+            return
+        self.original.rapid(self.x, self.y, self.level(self.x, self.y, self.z), a, b, c)
+
+    def feed(self, x=None, y=None, z=None):
+        if x == None: x = self.x
+        if y == None: y = self.y
+        if z == None: z = self.z
+        if x == None or y == None or z == None:
+            self.original.feed(x, y, z)
+        else:
+            self.feed_to(x, y, z)
+        self.x = x
+        self.y = y
+        self.z = z
+
+    def centre(self, x, y, r, ccw):
+        # the centre of an arc given by its radius. A positive radius means the shorter way
+        # round (so the centre is on the left of the chord going anticlockwise), a negative one
+        # the longer way.
+        dx = x - self.x
+        dy = y - self.y
+        chord = math.sqrt(dx * dx + dy * dy)
+        if chord < 1e-12: raise ValueError('level: an arc given by its radius must not end where it starts')
+        half = chord / 2
+        if math.fabs(r) < half:
+            if half - math.fabs(r) > self.height_map.tolerance: raise ValueError('level: the arc\'s radius is too small to reach its end point')
+            r = math.copysign(half, r)
+        offset = math.sqrt(r * r - half * half)
+        if ccw != (r > 0): offset = -offset
+        return (self.x + dx / 2 - dy / chord * offset, self.y + dy / 2 + dx / chord * offset)
+
+    def arc(self, x=None, y=None, z=None, i=None, j=None, k=None, r=None, ccw = True):
+        if x == None: x = self.x
+        if y == None: y = self.y
+        if z == None: z = self.z
+        if self.x == None or self.y == None or self.z == None:
+            # we don't know where the arc starts so it can't be levelled any more than a feed can
+            if ccw: self.original.arc_ccw(x, y, z, i, j, k, r)
+            else: self.original.arc_cw(x, y, z, i, j, k, r)
+            self.x = x
+            self.y = y
+            self.z = z
+            return
+
+        if i == None or j == None:
+            if r == None: raise ValueError('level: an arc needs its centre or its radius')
+            i, j = self.centre(x, y, r, ccw)
+
+        # break the arc into lines no further than the tolerance from it
+        radius = math.sqrt((self.x - i) * (self.x - i) + (self.y - j) * (self.y - j))
+        start = math.atan2(self.y - j, self.x - i)
+        end = math.atan2(y - j, x - i)
+        if ccw:
+            if end <= start + 1e-9: end = end + 2 * math.pi
+        else:
+            if end >= start - 1e-9: end = end - 2 * math.pi
+        step = math.pi / 2
+        if radius > self.height_map.tolerance:
+            step = min(step, 2 * math.acos(1 - self.height_map.tolerance / radius))
+        pieces = int(math.ceil(math.fabs(end - start) / step))
+        if pieces < 1: pieces = 1
+
+        z0 = self.z
+        for n in range(1, pieces + 1):
+            if n == pieces:
+                self.feed(x, y, z)
+            else:
+                angle = start + (end - start) * n / pieces
+                self.feed(i + radius * math.cos(angle), j + radius * math.sin(angle), z0 + (z - z0) * n / pieces)
+
+    def arc_cw(self, x=None, y=None, z=None, i=None, j=None, k=None, r=None):
+        self.arc(x, y, z, i, j, k, r, False)
+
+    def arc_ccw(self, x=None, y=None, z=None, i=None, j=None, k=None, r=None):
+        self.arc(x, y, z, i, j, k, r, True)
+
+    ############################################################################
+    ##  Programs
+
+    def program_begin(self, id, name=''):
+        self.original.program_begin(id, name)
+
+    def program_stop(self, optional=False):
+        self.original.program_stop(optional)
+
+    def program_end(self):
+        self.original.program_end()
+
+    def flush_nc(self):
+        self.original.flush_nc()
+
+    ############################################################################
+    ##  Subprograms
+
+    def sub_begin(self, id, name=''):
+        self.original.sub_begin(id, name)
+
+    def sub_call(self, id):
+        self.original.sub_call(id)
+        self.x = None
+        self.y = None
+        self.z = None
+
+    def sub_end(self):
+        self.original.sub_end()
+
+    ############################################################################
+    ##  Settings
+
+    def imperial(self):
+        self.original.imperial()
+
+    def metric(self):
+        self.original.metric()
+
+    def absolute(self):
+        self.original.absolute()
+
+    def incremental(self):
+        self.original.incremental()
+
+    def polar(self, on=True):
+        self.original.polar(on)
+
+    def set_plane(self, plane):
+        self.original.set_plane(plane)
+
+    def set_temporary_origin(self, x=None, y=None, z=None, a=None, b=None, c=None):
+        self.original.set_temporary_origin(x,y,z,a,b,c)
+
+    def remove_temporary_origin(self):
+        self.original.remove_temporary_origin()
+
+    ############################################################################
+    ##  Tools
+
+    def tool_change(self, id):
+        self.original.tool_change(id)
+
+    def tool_defn(self, id, name='', radius=None, length=None, gradient=None):
+        self.original.tool_defn(id, name, radius, length, gradient)
+
+    def offset_radius(self, id, radius=None):
+        self.original.offset_radius(id, radius)
+
+    def offset_length(self, id, length=None):
+        self.original.offset_length(id, length)
+
+    ############################################################################
+    ##  Datums
+
+    def datum_shift(self, x=None, y=None, z=None, a=None, b=None, c=None):
+        self.original.datum_shift(x, y, z, a, b, c)
+
+    def datum_set(self, x=None, y=None, z=None, a=None, b=None, c=None):
+        self.original.datum_set(x, y, z, a, b, c)
+
+    def workplane(self, id):
+        self.original.workplane(id)
+
+    ############################################################################
+    ##  Rates + Modes
+
+    def feedrate(self, f):
+        self.original.feedrate(f)
+
+    def feedrate_hv(self, fh, fv):
+        self.original.feedrate_hv(fh, fv)
+
+    def spindle(self, s, clockwise=True):
+        self.original.spindle(s, clockwise)
+
+    def coolant(self, mode=0):
+        self.original.coolant(mode)
+
+    def gearrange(self, gear=0):
+        self.original.gearrange(gear)
+
+    ############################################################################
+    ##  Moves
+
+    def dwell(self, t):
+        self.original.dwell(t)
+
+    def rapid_home(self, x=None, y=None, z=None, a=None, b=None, c=None):
+        self.original.rapid_home(x, y, z, a, b, c)
+        self.x = None
+        self.y = None
+        self.z = None
+
+    def rapid_unhome(self):
+        self.original.rapid_unhome()
+
+    def set_machine_coordinates(self):
+        self.original.set_machine_coordinates()
+
+    ############################################################################
+    ##  Cutter radius compensation
+
+    def use_CRC(self):
+        return self.original.use_CRC()
+
+    def start_CRC(self, left = True, radius = 0.0):
+        self.original.start_CRC(left, radius)
+
+    def end_CRC(self):
+        self.original.end_CRC()
+
+    ############################################################################
+    ##  Cycles
+
+    def pattern(self):
+        self.original.pattern()
+
+    def pocket(self):
+        self.original.pocket()
+
+    def profile(self):
+        self.original.profile()
+
+    def drill(self, x=None, y=None, z=None, depth=None, standoff=None, dwell=None, peck_depth=None, retract_mode=None, spindle_mode=None, clearance_height=None):
+        # the whole cycle moves up or down with the surface at the hole
+        if x != None: self.x = x
+        if y != None: self.y = y
+        if self.x != None and self.y != None:
+            h = self.height_map.height(self.x, self.y)
+            if z != None: z = z + h
+            if clearance_height != None: clearance_height = clearance_height + h
+        self.original.drill(x, y, z, depth, standoff, dwell, peck_depth, retract_mode, spindle_mode, clearance_height)
+        self.z = None
+
+    ############################################################################
+    ##  Misc
+
+    def comment(self, text):
+        self.original.comment(text)
+
+    def variable(self, id):
+        self.original.variable(id)
+
+    def variable_set(self, id, value):
+        self.original.variable_set(id, value)
+
+################################################################################
+
+def level_begin(points, tolerance):
+    global levelled
+    if levelled == True:
+        level_end()
+    nc.creator = Creator(nc.creator, HeightMap(points, tolerance))
+    levelled = True
+
+def level_end():
+    global levelled
+    if levelled == True:
+        # another creator (e.g. attach.py's) may have been put in front of ours since level_begin()
+        outer = None
+        c = nc.creator
+        while not isinstance(c, Creator) and hasattr(c, 'original'):
+            outer = c
+            c = c.original
+        if isinstance(c, Creator):
+            if outer == None: nc.creator = c.original
+            else: outer.original = c.original
+    levelled = False
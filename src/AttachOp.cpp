@@ -16,14 +16,13 @@
 #include "PythonStuff.h"
 #include "MachineState.h"
 #include "Reselect.h"
+#include "Tessellation.h"
 
 #include <wx/stdpaths.h>
 #include <wx/filename.h>
 #include <sstream>
 #include <iomanip>
 
-int CAttachOp::number_for_stl_file = 1;
-
 CAttachOp::CAttachOp():COp(GetTypeString(), 0, AttachOpType), m_tolerance(0.01), m_min_z(0.0)
 {
 }
@@ -100,7 +99,6 @@ Python CAttachOp::AppendTextToProgram(CMachineState *pMachineState)
 
 	//write stl file
 	std::list<HeeksObj*> solids;
-	std::list<HeeksObj*> copies_to_delete;
 #ifdef OP_SKETCHES_AS_CHILDREN
     for (HeeksObj *object = GetFirstChild(); object != NULL; object = GetNextChild())
     {
@@ -116,49 +114,16 @@ Python CAttachOp::AppendTextToProgram(CMachineState *pMachineState)
 #endif
 		if (object != NULL)
 		{
-			if(1/* to do pMachineState->Fixture().GetMatrix() == gp_Trsf()*/)
-			{
-				solids.push_back(object);
-			}
-			else
-			{
-				// Need to rotate a COPY of the solid by the fixture settings.
-				HeeksObj* copy = object->MakeACopy();
-				if (copy != NULL)
-				{
-					double m[16];	// A different form of the transformation matrix.
-					CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::YZ), m );
-					copy->ModifyByMatrix(m);
-
-					CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::XZ), m );
-					copy->ModifyByMatrix(m);
-
-					CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::XY), m );
-					copy->ModifyByMatrix(m);
-
-					solids.push_back(copy);
-					copies_to_delete.push_back(copy);
-				}
-			}
+			solids.push_back(object);
 		} // End if - then
 	} // End for
 
-
-    wxStandardPaths standard_paths;
-    wxFileName filepath( standard_paths.GetTempDir().c_str(), wxString::Format(_T("surface%d.stl"), number_for_stl_file).c_str() );
-	number_for_stl_file++;
-
-	heeksCAD->SaveSTLFile(solids, filepath.GetFullPath(), 0.01);
-
-	// We don't need the duplicate solids any more.  Delete them.
-	for (std::list<HeeksObj*>::iterator l_itSolid = copies_to_delete.begin(); l_itSolid != copies_to_delete.end(); l_itSolid++)
-	{
-		delete *l_itSolid;
-	} // End for
+	// The triangles are rotated by the fixture settings rather than copies of the solids.
+	wxString filepath = CTessellation::STLFile( solids, m_tolerance, CTessellation::FixtureMatrix( pMachineState->Fixture() ) );
 
 	python << _T("nc.attach.units = ") << theApp.m_program->m_units << _T("\n");
 	python << _T("nc.attach.attach_begin()\n");
-	python << _T("nc.nc.creator.stl = ocl_funcs.STLSurfFromFile(") << PythonString(filepath.GetFullPath()) << _T(")\n");
+	python << _T("nc.nc.creator.stl = ocl_funcs.STLSurfFromFile(") << PythonString(filepath) << _T(")\n");
 	python << _T("nc.nc.creator.minz = ") << m_min_z << _T("\n");
 	python << _T("nc.nc.creator.material_allowance = ") << m_material_allowance << _T("\n");
 
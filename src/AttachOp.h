@@ -14,7 +14,6 @@ public:
 	double m_tolerance;
 	double m_min_z;
 	double m_material_allowance;
-	static int number_for_stl_file;
 
 	CAttachOp();
 	CAttachOp(const std::list<int> &solids, double tol, double min_z);
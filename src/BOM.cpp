@@ -14,15 +14,71 @@
 #include "interface/PropertyLength.h"
 #include "interface/Tool.h"
 #include "TrsfNCCode.h"
+#include "CNCConfig.h"
+#include "Program.h"
+#include "ShapeNester.h"
+#include "WorkerThreads.h"
+
+#include <limits.h>
+#include <math.h>
+#include <map>
 
 using namespace std;
 extern CHeeksCADInterface* heeksCAD;
 
-CBOM::CBOM(wxString path):m_max_levels(2),m_gap(0)
+CBOM::CBOM(wxString path):m_gap(0)
 {
 	Load(path);
 }
 
+CBOM::CBOM(const CBOM & rhs):ObjList(rhs),rects(rhs.rects),m_gap(rhs.m_gap)
+{
+	Remap(rhs);
+}
+
+CBOM & CBOM::operator= (const CBOM & rhs)
+{
+	if (this != &rhs)
+	{
+		ObjList::operator=(rhs);
+		rects = rhs.rects;
+		m_gap = rhs.m_gap;
+		Remap(rhs);
+	}
+
+	return(*this);
+}
+
+/**
+	Our children have just been copied from those of rhs (in the same order).  The copies that
+	share NC code still point at rhs's sources, and the rectangles at rhs's children.  Point
+	them at our own instead.
+ */
+void CBOM::Remap(const CBOM & rhs)
+{
+	std::map<const CTrsfNCCode *, CTrsfNCCode *> copies;
+	CBOM & original = (CBOM &) rhs;
+	for (HeeksObj *from = original.GetFirstChild(), *to = GetFirstChild(); (from != NULL) && (to != NULL); from = original.GetNextChild(), to = GetNextChild())
+	{
+		if ((from->GetType() == TrsfNCCodeType) && (to->GetType() == TrsfNCCodeType))
+		{
+			copies[(CTrsfNCCode *) from] = (CTrsfNCCode *) to;
+		}
+	}
+
+	for (std::map<const CTrsfNCCode *, CTrsfNCCode *>::iterator l_itCopy = copies.begin(); l_itCopy != copies.end(); l_itCopy++)
+	{
+		std::map<const CTrsfNCCode *, CTrsfNCCode *>::iterator l_itSource = copies.find(l_itCopy->first->Source());
+		if (l_itSource != copies.end()) l_itCopy->second->SetSource(l_itSource->second);
+	}
+
+	for (Rectangles_t::iterator l_itRect = rects.begin(); l_itRect != rects.end(); l_itRect++)
+	{
+		std::map<const CTrsfNCCode *, CTrsfNCCode *>::iterator l_itCode = copies.find(l_itRect->m_code);
+		l_itRect->m_code = (l_itCode != copies.end()) ? l_itCode->second : NULL;
+	}
+}
+
 CBOM::~CBOM()
 {
 
@@ -47,12 +103,16 @@ void CBOM::Load(wxString path)
 		wxString filename = str.substr(0,comma);
 		wxString counts = str.substr(comma+1,str.Length()-comma);
 		int count = wxAtoi(counts);
+		if (count <= 0) continue;
+
+		// Only backplot the part once.  The other copies share its NC code.
+		CTrsfNCCode* source = new CTrsfNCCode();
+		Add(source,NULL);
+		HeeksPyBackplot(theApp.m_program, source, filename);
 
-		for(int i=0; i < count; i++)
+		for(int i=1; i < count; i++)
 		{
-			CTrsfNCCode* code = new CTrsfNCCode();
-			Add(code,NULL);
-			HeeksPyBackplot(theApp.m_program, code, filename);
+			Add(new CTrsfNCCode(source),NULL);
 		}
 	}
 }
@@ -94,240 +154,355 @@ HeeksObj* CBOM::ReadFromXMLElement(TiXmlElement* pElem)
 	return NULL;
 }
 
-struct ByHeight
+/**
+	The CMaxRects class packs rectangles into a bin of fixed width and height using the
+	MaxRects algorithm.  It keeps a list of the maximal free rectangles (which may overlap
+	each other) left in the bin.  Each rectangle is placed in whichever free rectangle scores
+	best by the chosen heuristic, and every free rectangle it overlaps is then split into
+	the (up to four) maximal pieces that remain.
+ */
+class CMaxRects
 {
- /*    bool operator()(const NCRect &pStart, const NCRect& pEnd)
-     {
-		 if( pStart.m_height == pEnd.m_height)
-			 return pStart.m_width < pEnd.m_width;
-		 return pStart.m_height < pEnd.m_height;
-     }*/
-	 bool operator()(const NCRect &pEnd, const NCRect& pStart)
-     {
-		 if( pStart.m_height == pEnd.m_height)
-			 return pStart.m_width < pEnd.m_width;
-		 return pStart.m_height < pEnd.m_height;
-     }
-};
+public:
+	typedef enum
+	{
+		eBestShortSideFit = 0,
+		eBestLongSideFit,
+		eBestAreaFit,
+		eBottomLeft,
+		eContactPoint,
+		eNumHeuristics
+	} eHeuristic_t;
+
+	CMaxRects( const int width, const int height, const eHeuristic_t heuristic ) : m_width(width), m_height(height), m_heuristic(heuristic)
+	{
+		m_free.push_back(NCRect(0, 0, width, height, NULL));
+	}
 
-double CBOM::SolutionDensity(int xmin1, int xmax1, int ymin1, int ymax1,
-            int xmin2, int xmax2, int ymin2, int ymax2,
-			Rectangles_t &rects, bool* is_positioned)
-{
-            NCRect rect1(xmin1, ymin1, xmax1 - xmin1, ymax1 - ymin1,NULL);
-            NCRect rect2(xmin2, ymin2, xmax2 - xmin2, ymax2 - ymin2,NULL);
-            int area_covered = 0;
-            for (unsigned int i = 0; i <= rects.size() - 1; i++)
-            {
-                if (is_positioned[i] &&
-                    (rects[i].IntersectsWith(rect1) ||
-                     rects[i].IntersectsWith(rect2)))
-                {
-                    area_covered += rects[i].m_width * rects[i].m_height;
-                }
-            }
-
-            double denom = rect1.m_width * rect1.m_height + rect2.m_width * rect2.m_height;
-            if (fabs(denom) < 0.001) return 0;
-
-            double density = area_covered / denom;
-			//return density;
-			return density * density * area_covered;
-        }
+	bool Insert( NCRect & rect );
 
+private:
+	bool Score( const NCRect & free, const int width, const int height, int *pPrimary, int *pSecondary ) const;
+	int ContactScore( const int x, const int y, const int width, const int height ) const;
+	void Split( const NCRect & free, const NCRect & used, CBOM::Rectangles_t & pieces ) const;
+	static bool Contains( const NCRect & outer, const NCRect & inner );
 
-int CBOM::FillBoundedArea(int xmin, int xmax, int ymin, int ymax,
-						int &num_unpositioned, Rectangles_t &rects, bool *is_positioned, int level, bool test)
-{
-	// See if every rectangle has been positioned.
-    if (num_unpositioned <= 0) return xmin;
-
-	if(level > m_max_levels && test)
-		return xmin;
-
-	int xmaxret=xmin;
-
-    // Save a copy of the solution so far.
-    int best_num_unpositioned = num_unpositioned;
-    Rectangles_t best_rects = rects;
-	bool *best_is_positioned = new bool[rects.size()];
-	memcpy(best_is_positioned,is_positioned,sizeof(bool) * rects.size());
-
-    // Currently we have no solution for this area.
-    double best_density = 0;
-
-	bool used_test2=false;
-	bool used_test1=false;
-	int best_index=0;
-
-    // Some rectangles have not been positioned.
-    // Loop through the available rectangles.
-    for (unsigned int i = 0; i <= rects.size() - 1; i++)
-    {
-    // See if this rectangle is not position and will fit.
-		if ((!is_positioned[i]) &&
-                    (rects[i].m_width <= xmax - xmin) &&
-                    (rects[i].m_height <= ymax - ymin))
-		{
-			// It will fit. Try it.
-            // **************************************************
-            // Divide the remaining area horizontally.
-            int test1_num_unpositioned = num_unpositioned - 1;
-            Rectangles_t test1_rects = rects;
-			bool *test1_is_positioned = new bool[rects.size()];
-			memcpy(test1_is_positioned,is_positioned,sizeof(bool) * rects.size());
-
-            test1_rects[i].m_x = xmin;
-            test1_rects[i].m_y = ymin;
-            test1_is_positioned[i] = true;
-
-            // Fill the area on the right.
-            int test1_xmax1 = FillBoundedArea(xmin + rects[i].m_width, xmax, ymin, ymin + rects[i].m_height,
-                        test1_num_unpositioned, test1_rects, test1_is_positioned,level+1, true);
-            // Fill the area on the bottom.
-            int test1_xmax2 = FillBoundedArea(xmin, xmax, ymin + rects[i].m_height, ymax,
-                        test1_num_unpositioned, test1_rects, test1_is_positioned,level+1, true);
-
-            // Learn about the test solution.
-    /*       double test1_density =
-                        SolutionDensity(
-                            xmin + rects[i].m_width, max(test1_xmax1,test1_xmax2), ymin, ymin + rects[i].m_height,
-                            xmin, max(test1_xmax1,test1_xmax2), ymin + rects[i].m_height, ymax,
-                            test1_rects, test1_is_positioned); */
-
-            double test1_density =
-                        SolutionDensity(
-                            xmin, max(test1_xmax1,test1_xmax2), ymin, ymax,
-                            xmin, max(test1_xmax1,test1_xmax2), ymin, ymax,
-                            test1_rects, test1_is_positioned);
-
-
-            // See if this is better than the current best solution.
-            if (test1_density >= best_density)
-            {
-				// The test is better. Save it.
-                best_density = test1_density;
-                best_rects = test1_rects;
-                best_is_positioned = test1_is_positioned;
-                best_num_unpositioned = test1_num_unpositioned;
-				xmaxret = max(test1_xmax1,test1_xmax2);
-
-				used_test2 = false;
-				used_test1 = true;
-				best_index = i;
-            }
-
-            // **************************************************
-            // Divide the remaining area vertically.
-            int test2_num_unpositioned = num_unpositioned - 1;
-			Rectangles_t test2_rects = rects;
- 			bool *test2_is_positioned = new bool[rects.size()];
-			memcpy(test2_is_positioned,is_positioned,sizeof(bool) * rects.size());
-
-			test2_rects[i].m_x = xmin;
-            test2_rects[i].m_y = ymin;
-            test2_is_positioned[i] = true;
-
-            // Fill the area on the right.
-            int test2_xmax1 = FillBoundedArea(xmin + rects[i].m_width, xmax, ymin, ymax,
-                        test2_num_unpositioned, test2_rects, test2_is_positioned,level+1, true);
-            // Fill the area on the bottom.
-            int test2_xmax2 = FillBoundedArea(xmin, xmin + rects[i].m_width, ymin + rects[i].m_height, ymax,
-                        test2_num_unpositioned, test2_rects, test2_is_positioned,level+1, true);
-
-            // Learn about the test solution.
-/*            double test2_density =
-                        SolutionDensity(
-                            xmin + rects[i].m_width, max(test2_xmax1,test2_xmax2), ymin, ymax,
-                            xmin, max(test2_xmax1,test2_xmax2), ymin + rects[i].m_height, ymax,
-                            test2_rects, test2_is_positioned);*/
-			double test2_density =
-                        SolutionDensity(
-                            xmin, max(test2_xmax1,test2_xmax2), ymin, ymax,
-                            xmin, max(test2_xmax1,test2_xmax2), ymin, ymax,
-                            test2_rects, test2_is_positioned);
-
-            // See if this is better than the current best solution.
-            if (test2_density >= best_density)
-            {
-				// The test is better. Save it.
-                best_density = test2_density;
-                best_rects = test2_rects;
-                best_is_positioned = test2_is_positioned;
-                best_num_unpositioned = test2_num_unpositioned;
-				xmaxret = max(test2_xmax1,test2_xmax2);
-
-				best_index = i;
-				used_test2 = true;
-             }
-		} // End trying this rectangle.
-	} // End looping through the rectangles.
+	int m_width;
+	int m_height;
+	eHeuristic_t m_heuristic;
+	CBOM::Rectangles_t m_free;
+	CBOM::Rectangles_t m_used;
+}; // End CMaxRects class definition.
+
+/* static */ bool CMaxRects::Contains( const NCRect & outer, const NCRect & inner )
+{
+	return((inner.m_x >= outer.m_x) && (inner.m_y >= outer.m_y) &&
+		   (inner.m_x + inner.m_width <= outer.m_x + outer.m_width) &&
+		   (inner.m_y + inner.m_height <= outer.m_y + outer.m_height));
+}
+
+/**
+	The length of the edges of this position that touch the sides of the bin or the rectangles
+	already placed.  More is better.
+ */
+int CMaxRects::ContactScore( const int x, const int y, const int width, const int height ) const
+{
+	int score = 0;
+	if ((x == 0) || (x + width == m_width)) score += height;
+	if ((y == 0) || (y + height == m_height)) score += width;
 
-	//Really calculate the best position we found
-	if(!test)
+	for (CBOM::Rectangles_t::const_iterator l_itUsed = m_used.begin(); l_itUsed != m_used.end(); l_itUsed++)
 	{
-		if(used_test2)
+		if ((l_itUsed->m_x == x + width) || (l_itUsed->m_x + l_itUsed->m_width == x))
 		{
-			int i=best_index;
-            int test2_num_unpositioned = num_unpositioned - 1;
-			Rectangles_t test2_rects = rects;
- 			bool *test2_is_positioned = new bool[rects.size()];
-			memcpy(test2_is_positioned,is_positioned,sizeof(bool) * rects.size());
-
-			test2_rects[i].m_x = xmin;
-            test2_rects[i].m_y = ymin;
-            test2_is_positioned[i] = true;
-
-            // Fill the area on the right.
-            FillBoundedArea(xmin + rects[i].m_width, xmax, ymin, ymax,
-                        test2_num_unpositioned, test2_rects, test2_is_positioned,level+1, false);
-            // Fill the area on the bottom.
-            FillBoundedArea(xmin, xmin + rects[i].m_width, ymin + rects[i].m_height, ymax,
-                        test2_num_unpositioned, test2_rects, test2_is_positioned,level+1, false);
-
-
-            best_rects = test2_rects;
-            best_is_positioned = test2_is_positioned;
-            best_num_unpositioned = test2_num_unpositioned;
+			int overlap = min(y + height, l_itUsed->m_y + l_itUsed->m_height) - max(y, l_itUsed->m_y);
+			if (overlap > 0) score += overlap;
 		}
-		else if(used_test1)
+		if ((l_itUsed->m_y == y + height) || (l_itUsed->m_y + l_itUsed->m_height == y))
 		{
-			int i=best_index;
-			int test1_num_unpositioned = num_unpositioned - 1;
-            Rectangles_t test1_rects = rects;
-			bool *test1_is_positioned = new bool[rects.size()];
-			memcpy(test1_is_positioned,is_positioned,sizeof(bool) * rects.size());
-
-            test1_rects[i].m_x = xmin;
-            test1_rects[i].m_y = ymin;
-            test1_is_positioned[i] = true;
-
-            // Fill the area on the right.
-            FillBoundedArea(xmin + rects[i].m_width, xmax, ymin, ymin + rects[i].m_height,
-                        test1_num_unpositioned, test1_rects, test1_is_positioned,level+1, false);
-            // Fill the area on the bottom.
-            FillBoundedArea(xmin, xmax, ymin + rects[i].m_height, ymax,
-                        test1_num_unpositioned, test1_rects, test1_is_positioned,level+1, false);
-
-            best_rects = test1_rects;
-            best_is_positioned = test1_is_positioned;
-            best_num_unpositioned = test1_num_unpositioned;
-
+			int overlap = min(x + width, l_itUsed->m_x + l_itUsed->m_width) - max(x, l_itUsed->m_x);
+			if (overlap > 0) score += overlap;
 		}
 	}
 
-    // Return the best solution we found.
-	memcpy(is_positioned,best_is_positioned,sizeof(bool)*rects.size());
-    num_unpositioned = best_num_unpositioned;
-    rects = best_rects;
+	return(score);
+}
+
+/**
+	Score placing a rectangle of this size at the bottom left of this free rectangle.  Lower
+	scores are better.  Returns false if it doesn't fit.
+ */
+bool CMaxRects::Score( const NCRect & free, const int width, const int height, int *pPrimary, int *pSecondary ) const
+{
+	if ((width > free.m_width) || (height > free.m_height)) return(false);
+
+	int leftover_x = free.m_width - width;
+	int leftover_y = free.m_height - height;
+
+	switch (m_heuristic)
+	{
+	case eBestShortSideFit:
+		*pPrimary = min(leftover_x, leftover_y);
+		*pSecondary = max(leftover_x, leftover_y);
+		break;
+
+	case eBestLongSideFit:
+		*pPrimary = max(leftover_x, leftover_y);
+		*pSecondary = min(leftover_x, leftover_y);
+		break;
+
+	case eBestAreaFit:
+		*pPrimary = free.m_width * free.m_height - width * height;
+		*pSecondary = min(leftover_x, leftover_y);
+		break;
+
+	case eBottomLeft:
+		*pPrimary = free.m_y + height;
+		*pSecondary = free.m_x;
+		break;
+
+	case eContactPoint:
+	default:
+		*pPrimary = -ContactScore(free.m_x, free.m_y, width, height);
+		*pSecondary = free.m_y + height;
+		break;
+	} // End switch
+
+	return(true);
+}
 
-	return xmaxret;
+/**
+	Add the maximal free rectangles that are left of 'free' once 'used' has been taken out of it.
+ */
+void CMaxRects::Split( const NCRect & free, const NCRect & used, CBOM::Rectangles_t & pieces ) const
+{
+	if ((used.m_x >= free.m_x + free.m_width) || (used.m_x + used.m_width <= free.m_x) ||
+		(used.m_y >= free.m_y + free.m_height) || (used.m_y + used.m_height <= free.m_y))
+	{
+		// They don't overlap.
+		pieces.push_back(free);
+		return;
+	}
+
+	if (used.m_x > free.m_x)
+		pieces.push_back(NCRect(free.m_x, free.m_y, used.m_x - free.m_x, free.m_height, NULL));
+	if (used.m_x + used.m_width < free.m_x + free.m_width)
+		pieces.push_back(NCRect(used.m_x + used.m_width, free.m_y, free.m_x + free.m_width - used.m_x - used.m_width, free.m_height, NULL));
+	if (used.m_y > free.m_y)
+		pieces.push_back(NCRect(free.m_x, free.m_y, free.m_width, used.m_y - free.m_y, NULL));
+	if (used.m_y + used.m_height < free.m_y + free.m_height)
+		pieces.push_back(NCRect(free.m_x, used.m_y + used.m_height, free.m_width, free.m_y + free.m_height - used.m_y - used.m_height, NULL));
 }
 
+/**
+	Position the rectangle in the bin.  Returns false (and leaves it alone) if there's no room for it.
+ */
+bool CMaxRects::Insert( NCRect & rect )
+{
+	CBOM::Rectangles_t::size_type best = m_free.size();
+	int best_primary = 0, best_secondary = 0;
+	for (CBOM::Rectangles_t::size_type i = 0; i < m_free.size(); i++)
+	{
+		int primary, secondary;
+		if (! Score(m_free[i], rect.m_width, rect.m_height, &primary, &secondary)) continue;
+
+		if ((best == m_free.size()) || (primary < best_primary) ||
+			((primary == best_primary) && (secondary < best_secondary)))
+		{
+			best = i;
+			best_primary = primary;
+			best_secondary = secondary;
+		}
+	}
+
+	if (best == m_free.size()) return(false);
+
+	rect.m_x = m_free[best].m_x;
+	rect.m_y = m_free[best].m_y;
+	m_used.push_back(rect);
+
+	// Split every free rectangle that the new one overlaps.  The pieces can only be contained
+	// by (or contain) other free rectangles so only they need checking against the rest.
+	CBOM::Rectangles_t untouched;
+	CBOM::Rectangles_t pieces;
+	for (CBOM::Rectangles_t::const_iterator l_itFree = m_free.begin(); l_itFree != m_free.end(); l_itFree++)
+	{
+		CBOM::Rectangles_t::size_type before = pieces.size();
+		Split(*l_itFree, rect, pieces);
+		if ((pieces.size() == before + 1) && (pieces.back() == *l_itFree))
+		{
+			untouched.push_back(*l_itFree);
+			pieces.pop_back();
+		}
+	}
+
+	std::vector<bool> redundant(pieces.size(), false);
+	for (CBOM::Rectangles_t::size_type i = 0; i < pieces.size(); i++)
+	{
+		for (CBOM::Rectangles_t::const_iterator l_itFree = untouched.begin(); (l_itFree != untouched.end()) && (! redundant[i]); l_itFree++)
+		{
+			if (Contains(*l_itFree, pieces[i])) redundant[i] = true;
+		}
+
+		for (CBOM::Rectangles_t::size_type j = 0; (j < pieces.size()) && (! redundant[i]); j++)
+		{
+			if ((i == j) || (redundant[j])) continue;
+			if (Contains(pieces[j], pieces[i])) redundant[i] = true;
+		}
+	}
+
+	m_free = untouched;
+	for (CBOM::Rectangles_t::size_type i = 0; i < pieces.size(); i++)
+	{
+		if (! redundant[i]) m_free.push_back(pieces[i]);
+	}
+
+	return(true);
+}
+
+struct ByHeight
+{
+	bool operator()(const NCRect &lhs, const NCRect& rhs) const
+	{
+		if (lhs.m_height != rhs.m_height) return lhs.m_height > rhs.m_height;
+		return lhs.m_width > rhs.m_width;
+	}
+};
+
+struct ByWidth
+{
+	bool operator()(const NCRect &lhs, const NCRect& rhs) const
+	{
+		if (lhs.m_width != rhs.m_width) return lhs.m_width > rhs.m_width;
+		return lhs.m_height > rhs.m_height;
+	}
+};
+
+struct ByArea
+{
+	bool operator()(const NCRect &lhs, const NCRect& rhs) const
+	{
+		if (lhs.m_width * lhs.m_height != rhs.m_width * rhs.m_height) return lhs.m_width * lhs.m_height > rhs.m_width * rhs.m_height;
+		return lhs.m_height > rhs.m_height;
+	}
+};
+
+struct ByLongestSide
+{
+	bool operator()(const NCRect &lhs, const NCRect& rhs) const
+	{
+		if (max(lhs.m_width, lhs.m_height) != max(rhs.m_width, rhs.m_height)) return max(lhs.m_width, lhs.m_height) > max(rhs.m_width, rhs.m_height);
+		return min(lhs.m_width, lhs.m_height) > min(rhs.m_width, rhs.m_height);
+	}
+};
+
+/**
+	Pack the rectangles (already in the order they're to be tried) into a strip bin_width wide
+	using one MaxRects heuristic.  The strip is given a height just big enough for the total
+	area and then made taller until everything fits.  Returns the height used (or -1 if we ran
+	out of time).  Rectangles wider than the strip are stacked above everything else.
+ */
+static int PackStrip( CBOM::Rectangles_t & rects, const int bin_width, const CMaxRects::eHeuristic_t heuristic, const wxStopWatch & watch, const long time_budget )
+{
+	long total_area = 0;
+	int tallest = 0;
+	int sum_of_heights = 0;
+	for (CBOM::Rectangles_t::const_iterator l_itRect = rects.begin(); l_itRect != rects.end(); l_itRect++)
+	{
+		if (l_itRect->m_width > bin_width) continue;
+		total_area += long(l_itRect->m_width) * long(l_itRect->m_height);
+		tallest = max(tallest, l_itRect->m_height);
+		sum_of_heights += l_itRect->m_height;
+	}
+
+	int bin_height = max(tallest, int(total_area / max(bin_width, 1)));
+	while (true)
+	{
+		CMaxRects bin(bin_width, bin_height, heuristic);
+		bool all_fit = true;
+		for (CBOM::Rectangles_t::iterator l_itRect = rects.begin(); (l_itRect != rects.end()) && all_fit; l_itRect++)
+		{
+			if (l_itRect->m_width > bin_width) continue;
+			all_fit = bin.Insert(*l_itRect);
+		}
+
+		if (all_fit) break;
+		if (bin_height >= sum_of_heights) break;	// Can't happen.  Every rectangle fits in a single column.
+		if (watch.Time() > time_budget) return(-1);
+
+		bin_height = min(sum_of_heights, bin_height + max(1, bin_height / 20));
+	}
+
+	int used_height = 0;
+	for (CBOM::Rectangles_t::const_iterator l_itRect = rects.begin(); l_itRect != rects.end(); l_itRect++)
+	{
+		if (l_itRect->m_width <= bin_width) used_height = max(used_height, l_itRect->m_y + l_itRect->m_height);
+	}
+
+	for (CBOM::Rectangles_t::iterator l_itRect = rects.begin(); l_itRect != rects.end(); l_itRect++)
+	{
+		if (l_itRect->m_width > bin_width)
+		{
+			l_itRect->m_x = 0;
+			l_itRect->m_y = used_height;
+			used_height += l_itRect->m_height;
+		}
+	}
+
+	return(used_height);
+}
+
+/**
+	Some of Pack()'s passes, each of which packs its own copy of the rectangles with one
+	heuristic and one order and leaves the result in its own slot.  The passes are shared out
+	between the jobs, which run on worker threads.
+ */
+class CPackJob : public CWorkerJob
+{
+public:
+	class CPass
+	{
+	public:
+		CPass() : m_heuristic(CMaxRects::eBestShortSideFit), m_pOrder(NULL), m_time_budget(0), m_height(-1) { }
+
+		CMaxRects::eHeuristic_t m_heuristic;
+		const CBOM::Rectangles_t *m_pOrder;	// The rectangles in the order they're to be tried.
+		long m_time_budget;					// milliseconds
+		CBOM::Rectangles_t m_rects;			// The packed rectangles.
+		int m_height;						// The height used, or -1 if the pass didn't finish in time.
+	}; // End CPass class definition.
+
+	CPackJob() : m_pPasses(NULL), m_first(0), m_step(1), m_bin_width(0), m_pWatch(NULL) { }
+
+	virtual void Run()
+	{
+		for (std::vector<CPass>::size_type i = m_first; i < m_pPasses->size(); i += m_step)
+		{
+			CPass & pass = (*m_pPasses)[i];
+			if (m_pWatch->Time() > pass.m_time_budget) continue;
+
+			pass.m_rects = *(pass.m_pOrder);
+			pass.m_height = PackStrip(pass.m_rects, m_bin_width, pass.m_heuristic, *m_pWatch, pass.m_time_budget);
+		}
+	}
+
+	std::vector<CPass> *m_pPasses;
+	std::vector<CPass>::size_type m_first;	// This job does passes m_first, m_first + m_step, m_first + 2 * m_step...
+	std::vector<CPass>::size_type m_step;
+	int m_bin_width;
+	const wxStopWatch *m_pWatch;
+}; // End CPackJob class definition.
+
+/**
+	Arrange the NC code blocks in a panel bin_width wide so that they use as little of its
+	length as possible.  Each MaxRects heuristic is tried with the parts sorted in each of
+	several orders, until either all combinations are done or the time budget (BOMPackSeconds)
+	runs out.  The combinations are independent so they're shared between worker threads.
+	The arrangement that uses the most of the sheet (i.e. the shortest one) is kept.
+ */
 void CBOM::Pack(double bin_width, double height, int gap)
 {
 	m_gap = gap;
-	Rectangles_t best_rects;
 	rects.clear();
 	HeeksObj* child = GetFirstChild();
 	while(child)
@@ -336,47 +511,67 @@ void CBOM::Pack(double bin_width, double height, int gap)
 		CBox box;
 		code->GetBox(box);
 		//Figure out how to translate later
-		NCRect ncrect(0,0,box.Width()+gap,box.Height()+gap,code);
-		best_rects.push_back(ncrect);
+		NCRect ncrect(0,0,int(box.Width())+gap,int(box.Height())+gap,code);
 		rects.push_back(ncrect);
 		child = GetNextChild();
 	}
 
+	if (rects.size() == 0) return;
 
-	// Sort by height.
-	std::sort(best_rects.begin(),best_rects.end(),ByHeight());
+	CNCConfig config(CProgram::ConfigScope());
+	double seconds;
+	config.Read(_T("BOMPackSeconds"), &seconds, 5.0);
+	long time_budget = long(seconds * 1000.0);
 
+	std::vector<Rectangles_t> orders(4, rects);
+	std::stable_sort(orders[0].begin(), orders[0].end(), ByHeight());
+	std::stable_sort(orders[1].begin(), orders[1].end(), ByArea());
+	std::stable_sort(orders[2].begin(), orders[2].end(), ByWidth());
+	std::stable_sort(orders[3].begin(), orders[3].end(), ByLongestSide());
 
-	// Make variables to track and record the best solution.
-	bool* is_positioned = new bool[best_rects.size()];
-	for(unsigned int i=0; i < best_rects.size(); i++)
-		is_positioned[i] = false;
-	int num_unpositioned = rects.size();
-	// Fill by stripes.
-	int max_y = 0;
-    for (unsigned int i = 0; i <= rects.size() - 1; i++)
+	std::vector<CPackJob::CPass> passes;
+	for (int heuristic = 0; heuristic < int(CMaxRects::eNumHeuristics); heuristic++)
 	{
-		// See if this rectangle is positioned.
-		if (!is_positioned[i])
+		for (std::vector<Rectangles_t>::const_iterator l_itOrder = orders.begin(); l_itOrder != orders.end(); l_itOrder++)
 		{
-			// Start a new stripe.
-			num_unpositioned -= 1;
-			is_positioned[i] = true;
-			best_rects[i].m_x = 0;
-			best_rects[i].m_y = max_y;
+			CPackJob::CPass pass;
+			pass.m_heuristic = CMaxRects::eHeuristic_t(heuristic);
+			pass.m_pOrder = &(*l_itOrder);
 
-			FillBoundedArea(
-                        best_rects[i].m_width, bin_width, max_y,
-                        max_y + best_rects[i].m_height,
-                        num_unpositioned, best_rects, is_positioned,0, false);
+			// Always finish at least one arrangement, no matter how long it takes.
+			pass.m_time_budget = (passes.size() == 0)?LONG_MAX:time_budget;
+			passes.push_back(pass);
+		}
+	}
+
+	wxStopWatch watch;
+	std::vector<CPackJob> jobs(min((unsigned int) passes.size(), CWorkerThreads::Count()));
+	std::vector<CWorkerJob *> job_pointers;
+	for (std::vector<CPackJob>::size_type i = 0; i < jobs.size(); i++)
+	{
+		jobs[i].m_pPasses = &passes;
+		jobs[i].m_first = i;
+		jobs[i].m_step = jobs.size();
+		jobs[i].m_bin_width = int(bin_width);
+		jobs[i].m_pWatch = &watch;
+		job_pointers.push_back(&(jobs[i]));
+	}
+	CWorkerThreads::Run(job_pointers);
 
-            if (num_unpositioned == 0) break;
-				max_y += best_rects[i].m_height;
-         }
-     }
+	// Pick the best in the same order as the passes were listed, so ties go the same way every time.
+	Rectangles_t best_rects;
+	int best_height = -1;
+	for (std::vector<CPackJob::CPass>::const_iterator l_itPass = passes.begin(); l_itPass != passes.end(); l_itPass++)
+	{
+		if ((l_itPass->m_height >= 0) && ((best_height < 0) || (l_itPass->m_height < best_height)))
+		{
+			best_height = l_itPass->m_height;
+			best_rects = l_itPass->m_rects;
+		}
+	}
 
-     // Save the best solution.
-     rects = best_rects;
+	// Save the best solution.
+	rects = best_rects;
 
 	 //Apply to the NCCODE
 	 for(unsigned int i=0; i < rects.size(); i++)
@@ -389,6 +584,40 @@ void CBOM::Pack(double bin_width, double height, int gap)
 	 }
 }
 
+/**
+	Arrange the NC code blocks in a panel bin_width wide by the shapes they cut rather than by
+	their bounding boxes, turning them to whichever of the BOMNestRotations rotation steps fits
+	best.  The rectangles are set to the bounding boxes of the nested outlines.
+ */
+void CBOM::Nest(double bin_width, int gap)
+{
+	m_gap = gap;
+	rects.clear();
+
+	CNCConfig config(CProgram::ConfigScope());
+	int rotations;
+	config.Read(_T("BOMNestRotations"), &rotations, 4);
+
+	CShapeNester nester(bin_width, gap, rotations);
+	for (HeeksObj *child = GetFirstChild(); child != NULL; child = GetNextChild())
+	{
+		nester.Add((CTrsfNCCode *) child);
+	}
+
+	nester.Nest();
+
+	for (HeeksObj *child = GetFirstChild(); child != NULL; child = GetNextChild())
+	{
+		CTrsfNCCode *code = (CTrsfNCCode *) child;
+		CBox box;
+		nester.GetBox(code, box);
+
+		int x = int(floor(box.MinX() + 0.5));
+		int y = int(floor(box.MinY() + 0.5));
+		rects.push_back(NCRect(x, y, int(floor(box.MaxX() + 0.5)) - x, int(floor(box.MaxY() + 0.5)) - y, code));
+	}
+}
+
 void CBOM::Regurgitate()
 {
     //Options
@@ -480,6 +709,20 @@ class PackTool: public Tool{
 	wxString BitmapPath(){ return _T("setinactive");}
 };
 
+class NestTool: public Tool{
+	// Tool's virtual functions
+	const wxChar* GetTitle(){return _("Nest BOM (true shape)");}
+	void Run()
+	{
+		double width=24;
+		double gap = 2;
+		heeksCAD->InputDouble(_("Enter width of panel in inches"),_("width"),width);
+		heeksCAD->InputDouble(_("Enter gap in millimeters"),_("gap"),gap);
+		BOMForTool->Nest(width*25.4,(int)gap);
+	}
+	wxString BitmapPath(){ return _T("setinactive");}
+};
+
 class RegurgitateTool: public Tool{
 	// Tool's virtual functions
 	const wxChar* GetTitle(){return _("Output NC");}
@@ -491,12 +734,14 @@ class RegurgitateTool: public Tool{
 };
 
 static PackTool pack_tool;
+static NestTool nest_tool;
 static RegurgitateTool regurgitate_tool;
 
 void CBOM::GetTools(std::list<Tool*>* t_list, const wxPoint* p)
 {
 	BOMForTool = this;
 	t_list->push_back(&pack_tool);
+	t_list->push_back(&nest_tool);
 	t_list->push_back(&regurgitate_tool);
 
 	HeeksObj::GetTools(t_list, p);
@@ -513,7 +758,6 @@ bool NCRect::operator==( const NCRect & rhs ) const
 
 bool CBOM::operator==( const CBOM & rhs ) const
 {
-	if (m_max_levels != rhs.m_max_levels) return(false);
 	if (m_gap != rhs.m_gap) return(false);
 
 	if (rects.size() != rhs.rects.size())
@@ -36,12 +36,14 @@ class CBOM:public ObjList
 public:
 	typedef std::vector<NCRect> Rectangles_t;
 	Rectangles_t rects;
-	int m_max_levels;
 	int m_gap;
 
 	CBOM(wxString path);
+	CBOM(const CBOM & rhs);
 	~CBOM();
 
+	CBOM & operator= (const CBOM & rhs);
+
 	bool operator==(const CBOM & rhs) const;
 	bool operator!=(const CBOM & rhs) const { return(! (*this == rhs)); }
 
@@ -49,12 +51,8 @@ public:
 
 	void Load(wxString path);
 	void Pack(double width, double height, int gap);
+	void Nest(double width, int gap);
 	void Regurgitate();
-	int FillBoundedArea(int x_min, int x_max, int y_min, int y_max,
-						int &num_unpositioned, std::vector<NCRect>&best_rects, bool *is_positioned, int level, bool test);
-	double SolutionDensity(int xmin1, int xmax1, int ymin1, int ymax1,
-            int xmin2, int xmax2, int ymin2, int ymax2,
-			std::vector<NCRect>&rects, bool* is_positioned);
 
 	// HeeksObj's virtual functions
 	int GetType()const{return ProgramType;}
@@ -68,4 +66,7 @@ public:
 	static HeeksObj* ReadFromXMLElement(TiXmlElement* pElem);
 	void GetTools(std::list<Tool*>* t_list, const wxPoint* p);
 	void glCommands(bool select, bool marked, bool no_color);
+
+private:
+	void Remap(const CBOM & rhs);
 };
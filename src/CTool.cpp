@@ -493,6 +493,7 @@ static void on_set_type(int zero_based_choice, HeeksObj* object)
 	if (zero_based_choice < 0) return;	// An error has occured.
 
 	((CTool*)object)->m_params.m_type = tool_types_for_on_set_type[zero_based_choice].first;
+	if (TOOLS) TOOLS->InvalidateIndex();	// The tools are also indexed by type.
 	((CTool*)object)->ResetParametersToReasonableValues();
 	heeksCAD->RefreshProperties();
 	object->KillGLLists();
@@ -1232,7 +1233,11 @@ Python CTool::AppendTextToProgram()
 }
 
 
-static void on_set_tool_number(const int value, HeeksObj* object){((CTool*)object)->m_tool_number = value;}
+static void on_set_tool_number(const int value, HeeksObj* object)
+{
+	((CTool*)object)->m_tool_number = value;
+	if (TOOLS) TOOLS->InvalidateIndex();
+}
 
 /**
 	NOTE: The m_title member is a special case.  The HeeksObj code looks for a 'GetShortString()' method.  If found, it
@@ -1276,6 +1281,8 @@ CTool & CTool::operator= ( const CTool & rhs )
         }
 
         HeeksObj::operator=( rhs );
+
+        if (TOOLS) TOOLS->InvalidateIndex();	// Our tool number and type may have changed.
     }
 
     return(*this);
@@ -1407,6 +1414,7 @@ HeeksObj* CTool::ReadFromXMLElement(TiXmlElement* element)
 		std::string name(pElem->Value());
 		if(name == "params"){
 			new_object->m_params.ReadParametersFromXMLElement(pElem);
+			if (TOOLS) TOOLS->InvalidateIndex();	// Its type has changed.
 			if(new_object->m_params.m_automatically_generate_title == 0)new_object->m_title.assign(title);
 		}
 	}
@@ -1426,27 +1434,13 @@ void CTool::OnEditString(const wxChar* str)
 
 CTool *CTool::Find( const int tool_number )
 {
-	int id = FindTool( tool_number );
-	if (id <= 0) return(NULL);
-	return((CTool *) heeksCAD->GetIDObject( ToolType, id ));
+	if (TOOLS) return(TOOLS->Find( tool_number ));
+	return(NULL);
 } // End Find() method
 
 CTool::ToolNumber_t CTool::FindFirstByType( const CToolParams::eToolType type )
 {
-
-	if (TOOLS)
-	{
-		HeeksObj* tool_list = TOOLS;
-		for(HeeksObj* ob = tool_list->GetFirstChild(); ob; ob = tool_list->GetNextChild())
-		{
-			if (ob->GetType() != ToolType) continue;
-			if ((ob != NULL) && (((CTool *) ob)->m_params.m_type == type))
-			{
-				return(((CTool *)ob)->m_tool_number);
-			} // End if - then
-		} // End for
-	} // End if - then
-
+	if (TOOLS) return(TOOLS->FindFirstByType( type ));
 	return(-1);
 }
 
@@ -1456,23 +1450,9 @@ CTool::ToolNumber_t CTool::FindFirstByType( const CToolParams::eToolType type )
  */
 int CTool::FindTool( const int tool_number )
 {
-
-	if (TOOLS)
-	{
-		HeeksObj* tool_list = TOOLS;
-
-		for(HeeksObj* ob = tool_list->GetFirstChild(); ob; ob = tool_list->GetNextChild())
-		{
-			if (ob->GetType() != ToolType) continue;
-			if ((ob != NULL) && (((CTool *) ob)->m_tool_number == tool_number))
-			{
-				return(ob->m_id);
-			} // End if - then
-		} // End for
-	} // End if - then
-
-	return(-1);
-
+	CTool *pTool = Find( tool_number );
+	if (pTool == NULL) return(-1);
+	return(pTool->m_id);
 } // End FindTool() method
 
 
@@ -1485,17 +1465,10 @@ std::vector< std::pair< int, wxString > > CTool::FindAllTools()
 
 	if (TOOLS)
 	{
-		HeeksObj* tool_list = TOOLS;
-
-		for(HeeksObj* ob = tool_list->GetFirstChild(); ob; ob = tool_list->GetNextChild())
+		const std::vector< CTool * > & all_tools = TOOLS->AllTools();
+		for (std::vector< CTool * >::const_iterator l_itTool = all_tools.begin(); l_itTool != all_tools.end(); l_itTool++)
 		{
-			if (ob->GetType() != ToolType) continue;
-
-			CTool *pTool = (CTool *)ob;
-			if (ob != NULL)
-			{
-				tools.push_back( std::make_pair( pTool->m_tool_number, pTool->GetShortString() ) );
-			} // End if - then
+			tools.push_back( std::make_pair( (*l_itTool)->m_tool_number, (*l_itTool)->GetShortString() ) );
 		} // End for
 	} // End if - then
 
@@ -1872,7 +1845,7 @@ void CTool::DeleteSolid()
 	It is always drawn along the Z axis.  The calling routine may move and rotate the drawn
 	shape if need be but this method returns a standard straight up and down version.
  */
-TopoDS_Shape CTool::GetShape() const
+TopoDS_Shape CTool::MakeShape() const
 {
    try {
 	gp_Dir orientation(0,0,1);	// This method always draws it up and down.  Leave it
@@ -2223,7 +2196,7 @@ Python CTool::OCLDefinition(CAttachOp* attach_op) const
 
 } // End GetShape() method
 
-TopoDS_Face CTool::GetSideProfile() const
+TopoDS_Face CTool::MakeSideProfile() const
 {
    try {
 	gp_Dir orientation(0,0,1);	// This method always draws it up and down.  Leave it
@@ -2290,9 +2263,90 @@ TopoDS_Face CTool::GetSideProfile() const
 	// printf("Domain error thrown while generating tool shape\n");
 	throw;	// Re-throw the exception.
    } // End catch
+} // End MakeSideProfile() method
+
+
+
+
+/**
+	Return the solid representing this tool.  The solid is only constructed the
+	first time it's needed for this set of shape-relevant parameters.  After that
+	it's returned from the tool geometry cache.
+
+	The cache may be emptied by any call to CToolGeometryCache::Get() so the entry
+	is only looked up again once the geometry has been made and only a copy of
+	it is handed back.
+ */
+TopoDS_Shape CTool::GetShape() const
+{
+	CToolParams::GeometryKey_t key = m_params.GeometryKey();
+	if (! CToolGeometryCache::Get( key ).m_shape_valid)
+	{
+		TopoDS_Shape shape = MakeShape();	// May throw.  If so, we'll try again next time.
+
+		CToolGeometry & geometry = CToolGeometryCache::Get( key );
+		geometry.m_shape = shape;
+		geometry.m_shape_valid = true;
+	}
+
+	return(CToolGeometryCache::Get( key ).m_shape);
+} // End GetShape() method
+
+TopoDS_Face CTool::GetSideProfile() const
+{
+	CToolParams::GeometryKey_t key = m_params.GeometryKey();
+	if (! CToolGeometryCache::Get( key ).m_side_profile_valid)
+	{
+		TopoDS_Face face = MakeSideProfile();
+
+		CToolGeometry & geometry = CToolGeometryCache::Get( key );
+		geometry.m_side_profile = face;
+		geometry.m_side_profile_valid = true;
+	}
+
+	return(CToolGeometryCache::Get( key ).m_side_profile);
 } // End GetSideProfile() method
 
+/**
+	Return the values of all the parameters that affect the tool's shape (as
+	produced by MakeShape() and MakeSideProfile()).  Two tools with the same key
+	have exactly the same geometry.
+ */
+CToolParams::GeometryKey_t CToolParams::GeometryKey() const
+{
+	std::vector<double> values;
+	values.push_back( double(m_type) );
+	values.push_back( m_diameter );
+	values.push_back( m_tool_length_offset );
+	values.push_back( m_cutting_edge_height );
+	values.push_back( m_cutting_edge_angle );
+	values.push_back( m_flat_radius );
+	values.push_back( m_corner_radius );
+	values.push_back( m_tool_angle );
+	values.push_back( double(m_orientation) );
+
+	return(GeometryKey_t( values, m_size ));
+}
+
+/* static */ CToolGeometryCache::Cache_t CToolGeometryCache::s_cache;
 
+/* static */ CToolGeometry & CToolGeometryCache::Get( const CToolParams::GeometryKey_t & key )
+{
+	// A tool table rarely has more than a few dozen distinct geometries.  If we've
+	// accumulated more than this (from repeated editing) then just start again.
+	const unsigned int max_entries = 256;
+
+	Cache_t::iterator l_itGeometry = s_cache.find( key );
+	if (l_itGeometry != s_cache.end()) return(l_itGeometry->second);
+
+	if (s_cache.size() >= max_entries) s_cache.clear();
+	return(s_cache[ key ]);
+}
+
+/* static */ void CToolGeometryCache::Clear()
+{
+	s_cache.clear();
+}
 
 
 /**
@@ -12,6 +12,7 @@
 #include "HeeksCNCTypes.h"
 
 #include <vector>
+#include <map>
 #include <algorithm>
 
 class CTool;
@@ -343,6 +344,44 @@ public:
 
 	bool operator== ( const CToolParams & rhs ) const;
 	bool operator!= ( const CToolParams & rhs ) const { return(! (*this == rhs)); }
+
+	typedef std::pair< std::vector<double>, wxString > GeometryKey_t;
+	GeometryKey_t GeometryKey() const;
+};
+
+/**
+	The geometry generated from a tool's parameters.  These are expensive to build
+	(cylinders, cones and fillets through OpenCascade) so they're held in the
+	CToolGeometryCache and shared between all tools whose shape-relevant
+	parameters are the same.  Each member is only generated when first asked for.
+ */
+class CToolGeometry
+{
+public:
+	CToolGeometry() : m_shape_valid(false), m_side_profile_valid(false) { }
+
+	TopoDS_Shape m_shape;
+	bool m_shape_valid;
+
+	TopoDS_Face m_side_profile;
+	bool m_side_profile_valid;
+};
+
+/**
+	Process-wide cache of tool geometry keyed by CToolParams::GeometryKey().  Since
+	the key is made from the parameter values themselves, changing any of them
+	simply results in a lookup for a different key so the cache never needs to
+	be told when a tool is edited.
+ */
+class CToolGeometryCache
+{
+public:
+	static CToolGeometry & Get( const CToolParams::GeometryKey_t & key );
+	static void Clear();
+
+private:
+	typedef std::map< CToolParams::GeometryKey_t, CToolGeometry > Cache_t;
+	static Cache_t s_cache;
 };
 
 class CTool: public HeeksObj {
@@ -434,6 +473,8 @@ public:
 
 private:
 	void DeleteSolid();
+	TopoDS_Shape MakeShape() const;
+	TopoDS_Face  MakeSideProfile() const;
 
 public:
     typedef struct
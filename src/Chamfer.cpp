@@ -619,8 +619,8 @@ Python CChamfer::AppendTextForProfileChildren(
     {
 		HeeksObj *object = *itChild;
 
-        std::list<TopoDS_Shape> wires;
-        if (! heeksCAD->ConvertSketchToFaceOrWire( object, wires, false))
+        const std::list<TopoDS_Shape> *wires = theApp.m_program->m_sketch_wires.Wires( object );
+        if (wires == NULL)
         {
             number_of_bad_sketches++;
         } // End if - then
@@ -635,14 +635,9 @@ Python CChamfer::AppendTextForProfileChildren(
             }
 
             try {
-                for(std::list<TopoDS_Shape>::iterator It2 = wires.begin(); It2 != wires.end(); It2++)
+                for(std::list<TopoDS_Shape>::const_iterator It2 = wires->begin(); It2 != wires->end(); It2++)
                 {
-                    TopoDS_Shape& wire_to_fix = *It2;
-                    ShapeFix_Wire fix;
-                    fix.Load( TopoDS::Wire(wire_to_fix) );
-                    fix.FixReorder();
-
-                    TopoDS_Shape wire = fix.Wire();
+                    TopoDS_Shape wire = *It2;	// already reordered
 
                     wire = pMachineState->Fixture().Adjustment(wire);
 
@@ -30,6 +30,7 @@
 #include <sstream>
 #include <iomanip>
 #include <vector>
+#include <map>
 #include <algorithm>
 #include <functional>
 
@@ -512,8 +513,10 @@ Python CContour::ContiguousPath::GCode(
 		    if (pMachineState->Location().XYDistance(itPath->StartPoint()) > tolerance) // in X and Y only.
 		    {
                 // We need to move to the start BEFORE machining this line.
-                // Move up above workpiece to relocate to the start of the next edge.
-                python << _T("rapid(z=") << clearance_height / theApp.m_program->m_units << _T(")\n");
+                // Move up above workpiece to relocate to the start of the next edge.  If the program allows
+                // it, only go as high as we need to in order to clear the solids that lie under the way there.
+                double link_height = pMachineState->LinkHeight(itPath->StartPoint(), rapid_down_to_height, clearance_height);
+                python << _T("rapid(z=") << link_height / theApp.m_program->m_units << _T(")\n");
 
 				// Look at the locations that have been machined earlier in this program.  If we can lower
 				// the bit lower than the start_depth then we want to do so.
@@ -832,8 +835,8 @@ Python CContour::AppendTextToProgram( CMachineState *pMachineState )
 			continue;
 		}
 
-        std::list<TopoDS_Shape> wires;
-        if (! heeksCAD->ConvertSketchToFaceOrWire( object, wires, false))
+        const std::list<TopoDS_Shape> *wires = theApp.m_program->m_sketch_wires.Wires( object );
+        if (wires == NULL)
         {
             number_of_bad_sketches++;
         } // End if - then
@@ -846,20 +849,20 @@ Python CContour::AppendTextToProgram( CMachineState *pMachineState )
             }
 
             try {
-                for(std::list<TopoDS_Shape>::iterator It2 = wires.begin(); It2 != wires.end(); It2++)
+                for(std::list<TopoDS_Shape>::const_iterator It2 = wires->begin(); It2 != wires->end(); It2++)
                 {
-                    TopoDS_Shape& wire_to_fix = *It2;
-                    ShapeFix_Wire fix;
-                    fix.Load( TopoDS::Wire(wire_to_fix) );
-                    fix.FixReorder();
-
-                    TopoDS_Shape wire = fix.Wire();
+                    TopoDS_Shape wire = *It2;	// already reordered
 
 					// Rotate and translate the wire to align with the fixture (if necessary)
                     pMachineState->Fixture().Adjustment(wire);
 
                     BRepOffsetAPI_MakeOffset offset_wire(TopoDS::Wire(wire));
 
+                    // The offset only depends on the cutting radius so, for cutters whose radius doesn't
+                    // change with depth, it is calculated once and then moved down to each depth in turn.
+                    typedef std::map<double, TopoDS_Wire> OffsetWires_t;
+                    OffsetWires_t offset_wires;
+
                     // Now generate a toolpath along this wire.
                     std::list<double> depths = GetDepths();
 
@@ -878,12 +881,17 @@ Python CContour::AppendTextToProgram( CMachineState *pMachineState )
 
                         if (offset > tolerance)
                         {
-                            offset_wire.Perform(radius);
-                            if (! offset_wire.IsDone())
+                            OffsetWires_t::iterator l_itOffset = offset_wires.find(radius);
+                            if (l_itOffset == offset_wires.end())
                             {
-                                break;
+                                offset_wire.Perform(radius);
+                                if (! offset_wire.IsDone())
+                                {
+                                    break;
+                                }
+                                l_itOffset = offset_wires.insert( std::make_pair( radius, TopoDS::Wire(offset_wire.Shape()) ) ).first;
                             }
-                            tool_path_wire = TopoDS::Wire(offset_wire.Shape());
+                            tool_path_wire = l_itOffset->second;
                         }
 
                         if ((m_params.m_tool_on_side == CContourParams::eOn) || (offset > tolerance))
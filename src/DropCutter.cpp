@@ -19,10 +19,15 @@
 #include "stdafx.h"
 #include "DropCutter.h"
 #include "GTri.h"
+#include "WorkerThreads.h"
+#include <algorithm>
+#include <float.h>
 
 
 Cutter::Cutter(double Rset, double rset)
 {
+	tolerance = heeksCAD->GetTolerance();
+
 	if (Rset > 0)
 	{
 		R = Rset;
@@ -56,12 +61,12 @@ double DropCutter::VertexTest(const Cutter &c, const double *e, const double *p)
 	// q is the distance along xy-plane from e to vertex
 	double q = sqrt(pow(e[0] - p[0], 2) + pow((e[1] - p[1]), 2));
 
-	if (q > c.R + heeksCAD->GetTolerance())
+	if (q > c.R + c.tolerance)
 	{
 		// vertex is outside cutter. no need to do anything!
 		return -10000000.0;
 	}
-	else if (q <= (c.R - c.r) + heeksCAD->GetTolerance())
+	else if (q <= (c.R - c.r) + c.tolerance)
 	{
 		// vertex is in the cylindical/flat part of the cutter
 		return p[2];
@@ -105,7 +110,7 @@ double DropCutter::FacetTest(const Cutter &cu, const double *e, const GTri &t)
 
 	// the z-direction normal is a special case (?required?)
 	// in debug phase, see if this is a useful case!
-	if ((fabs(a) < heeksCAD->GetTolerance()) && (fabs(b) < heeksCAD->GetTolerance()))
+	if ((fabs(a) < cu.tolerance) && (fabs(b) < cu.tolerance))
 	{
 		// System.Console.WriteLine("facet-test:z-dir normal case!");
 		cc[0] = e[0];
@@ -171,21 +176,27 @@ double DropCutter::FacetTest(const Cutter &cu, const double *e, const GTri &t)
 		return -10000000.0;
 }
 
-static bool isinrange(double start, double end, double x)
+// the height of the cutter's surface above its tip at distance q from its axis
+static double TorusLift(const Cutter &cu, double q)
 {
-	// order input
-	double s_tmp = start;
-	//double e_tmp = end;
-	if (start > end)
-	{
-		start = end;
-		end = s_tmp;
-	}
+	double d = q - (cu.R - cu.r);
+	if (d <= 0.0)return 0.0; // flat bottom
+	if (d >= cu.r)return cu.r; // side of the cutter
+	return cu.r - sqrt(pow(cu.r, 2) - pow(d, 2));
+}
 
-	if ((x >= start - heeksCAD->GetTolerance()) && (x <= end + heeksCAD->GetTolerance()))
-		return true;
-	else
-		return false;
+// the slope, with respect to x, of the tip height allowed by the point on the edge at x
+// ( the edge runs parallel to the x axis, at distance l, rising at k )
+static double EdgeSlope(const Cutter &cu, double k, double l, double x)
+{
+	double q = sqrt(pow(x, 2) + pow(l, 2));
+	double d = q - (cu.R - cu.r);
+	if (d <= 0.0 || q < 0.000000000001)return k;
+
+	double s = pow(cu.r, 2) - pow(d, 2);
+	if (s <= 0.0)return (x > 0.0) ? -1.0e100 : 1.0e100; // the side of the cutter is vertical
+
+	return k - (d / sqrt(s)) * (x / q);
 }
 
 double DropCutter::EdgeTest(const Cutter &cu, const double *e, const double *p1, const double *p2)
@@ -235,18 +246,18 @@ double DropCutter::EdgeTest(const Cutter &cu, const double *e, const double *p1,
 	}
 
 	double l = -start[1]; // distance from cutter to edge
-	if (l < -heeksCAD->GetTolerance())
+	if (l < -cu.tolerance)
 		wxMessageBox(_T("EdgeTest ERROR! l<0 !"));
 
 	// System.Console.WriteLine("l=" + l+" start.y="+start.y+" end.y="+end.y);
 
 
 	// now we have two different algorithms depending on the cutter:
-	if (fabs(cu.r) < heeksCAD->GetTolerance())
+	if (fabs(cu.r) < cu.tolerance)
 	{
 		// this is the flat endmill case
 		// it is easier and faster than the general case, so we handle it separately
-		if (l > cu.R + heeksCAD->GetTolerance()) // edge is outside of the cutter
+		if (l > cu.R + cu.tolerance) // edge is outside of the cutter
 			return -10000000.0;
 		else // we are inside the cutter
 		{
@@ -272,9 +283,9 @@ double DropCutter::EdgeTest(const Cutter &cu, const double *e, const double *p1,
 			}
 
 			// now that we have a CC point, check if it's in the edge
-			if ((start[0] > xc + heeksCAD->GetTolerance()) && (xc + heeksCAD->GetTolerance()< end[0]))
+			if ((start[0] > xc + cu.tolerance) && (xc + cu.tolerance< end[0]))
 				return -10000000.0;
-			else if ((end[0] < xc - heeksCAD->GetTolerance()) && (xc + heeksCAD->GetTolerance() > start[0]))
+			else if ((end[0] < xc - cu.tolerance) && (xc + cu.tolerance > start[0]))
 				return -10000000.0;
 			else
 				return zc;
@@ -284,115 +295,71 @@ double DropCutter::EdgeTest(const Cutter &cu, const double *e, const double *p1,
 	} // end of flat endmill (r=0) case
 	else// if (cu.r > 0)
 	{
-		// System.Console.WriteLine("edgetest r>0 case!");
-
 		// this is the general case (r>0)   ball-nose or bull-nose (spherical or toroidal)
-		// later a separate case for the ball-cutter might be added (for performance)
+		// Anders's original version of this used an offset ellipse, which is only an approximation
+		// for the toroidal cutter.  Instead, a point on the edge at x (from the cutter's axis) can
+		// hold the cutter's tip at most at edge_z(x) - TorusLift(q(x)), where q is the point's
+		// distance from the axis.  That is a concave function of x, so the contact point is where
+		// its slope is zero, which is found by regula falsi (see below).
 
-		double xd=0, w=0, h=0, xd1=0, xd2=0, xc=0 , ze=0, zc=0;
-
-		if (l > cu.R + heeksCAD->GetTolerance()) // edge is outside of the cutter
+		if (l > cu.R + cu.tolerance) // edge is outside of the cutter
 			return -10000000.0;
-		else if (((cu.R-cu.r)<l - heeksCAD->GetTolerance())&&(l<=cu.R + heeksCAD->GetTolerance()))
-		{    // toroidal case
-			xd=0; // center of ellipse
-			w=sqrt(pow(cu.R,2)-pow(l,2)); // width of ellipse
-			h=sqrt(pow(cu.r,2)-pow((l-(cu.R-cu.r)),2)); // height of ellipse
-		}
-		else if ((cu.R-cu.r)>=l)
-		{
-			// quarter ellipse case
-			xd1=sqrt( pow((cu.R-cu.r),2)-pow(l,2));
-			xd2=-xd1;
-			h=cu.r; // ellipse height
-			w=sqrt( pow(cu.R,2)-pow(l,2) )- sqrt( pow((cu.R-cu.r),2)-pow(l,2) ); // ellipse height
-		}
 
-		// now there is a special case where the theta calculation will fail if
-		// the segment is horziontal, i.e. start.z==end.z  so we need to catch that here
-		if (fabs(start[2] - end[2]) < heeksCAD->GetTolerance())
-		{
-			if ((cu.R-cu.r)<l - heeksCAD->GetTolerance())
-			{
-				// half-ellipse case
-				xc=0;
-				h=sqrt(pow(cu.r,2)-pow((l-(cu.R-cu.r)),2));
-				ze = start[2] + h - cu.r;
-			}
-			else
-			{
-				// quarter ellipse case
-				xc = 0;
-				ze = start[2];
-			}
-
-			// now we have a CC point
-			// so we need to check if the CC point is in the edge
-			if (isinrange(start[0], end[0], xc))
-				return ze;
-			else
-				return -10000000.0;
-
-		} // end horizontal edge special case
+		if(fabs(end[0] - start[0]) < 0.000000001)return -10000000.0; // edge is vertical, the vertex tests will find it
 
+		if (l < 0.0)l = 0.0;
+		double xr = (l < cu.R) ? sqrt(pow(cu.R, 2) - pow(l, 2)) : 0.0; // the edge is inside the cutter for -xr < x < xr
 
-		// now the general case where the theta calculation works
-		double theta = atan( h*(start[0]-end[0])/(w*(start[2]-end[2])) );
+		double lo = (start[0] < end[0]) ? start[0] : end[0];
+		double hi = (start[0] < end[0]) ? end[0] : start[0];
+		if (lo < -xr)lo = -xr;
+		if (hi > xr)hi = xr;
+		if (lo > hi + cu.tolerance)
+			return -10000000.0; // the part of the edge that is under the cutter is not between p1 and p2
+		if (lo > hi)lo = hi = (lo + hi) * 0.5;
 
-		if(fabs(end[0] - start[0]) < 0.000000001)return -10000000.0; // instead of maths error below
-
-		// based on this calculate the CC point
-		if (((cu.R - cu.r) < l - heeksCAD->GetTolerance()) && (cu.R <= l + heeksCAD->GetTolerance()))
-		{
-			// half-ellipse case
-			double xc1 = xd + fabs(w * cos(theta));
-			double xc2 = xd - fabs(w * cos(theta));
-			double zc1 = ((xc1 - start[0]) / (end[0] - start[0])) * (end[2] - start[2]) + start[2];
-			double zc2 = ((xc2 - start[0]) / (end[0] - start[0])) * (end[2] - start[2]) + start[2];
-			// select the higher point:
-			if (zc1 > zc2)
-			{
-				zc = zc1;
-				xc = xc1;
-			}
-			else
-			{
-				zc = zc2;
-				xc = xc2;
-			}
+		double k = (end[2] - start[2]) / (end[0] - start[0]); // slope of the edge
 
-		}
+		double xc;
+		if (EdgeSlope(cu, k, l, lo) <= 0.0)
+			xc = lo; // dropping all the way along, so the highest point is at the low end
+		else if (EdgeSlope(cu, k, l, hi) >= 0.0)
+			xc = hi; // rising all the way along
 		else
 		{
-			// quarter ellipse case
-			double xc1 = xd1 + fabs(w * cos(theta));
-			double xc2 = xd2 - fabs(w * cos(theta));
-			double zc1 = ((xc1 - start[0]) / (end[0] - start[0])) * (end[2] - start[2]) + start[2];
-			double zc2 = ((xc2 - start[0]) / (end[0] - start[0])) * (end[2] - start[2]) + start[2];
-			// select the higher point:
-			if (zc1 > zc2)
-			{
-				zc = zc1;
-				xc = xc1;
-			}
-			else
+			// find the zero slope with the Illinois version of regula falsi, which keeps the root
+			// bracketed, falling back to bisection when the slope is too steep to interpolate
+			double slo = EdgeSlope(cu, k, l, lo);
+			double shi = EdgeSlope(cu, k, l, hi);
+			int side = 0;
+			xc = (lo + hi) * 0.5;
+			for(int i = 0; i<100 && hi - lo > 0.0000000001; i++)
 			{
-				zc = zc2;
-				xc = xc2;
+				xc = lo + slo * (hi - lo) / (slo - shi);
+				if (!(xc > lo && xc < hi) || fabs(slo) > 1.0e10 || fabs(shi) > 1.0e10)xc = (lo + hi) * 0.5;
+
+				double sc = EdgeSlope(cu, k, l, xc);
+				if (sc == 0.0)break;
+				if (sc > 0.0)
+				{
+					lo = xc;
+					slo = sc;
+					if (side == 1)shi *= 0.5;
+					side = 1;
+				}
+				else
+				{
+					hi = xc;
+					shi = sc;
+					if (side == -1)slo *= 0.5;
+					side = -1;
+				}
+				if (fabs(sc) < 0.0000000001)break;
 			}
 		}
 
-		// now we have a valid xc value, so calculate the ze value:
-		ze = zc + fabs(h * sin(theta)) - cu.r;
-
-		// finally, check that the CC point is in the edge
-		if (isinrange(start[0],end[0],xc))
-			return ze;
-		else
-			return -10000000.0;
-
-
-		// this line is unreachable (according to compiler)
+		double zc = start[2] + k * (xc - start[0]); // CC point
+		return zc - TorusLift(cu, sqrt(pow(xc, 2) + pow(l, 2)));
 
 	} // end of toroidal/spherical case
 
@@ -493,3 +460,257 @@ double DropCutter::TriTest(const Cutter &cu, const double *e, const std::list<GT
 	return z;
 }
 
+
+// sorts a cell's triangles so the highest ones come first
+class HigherTriangle
+{
+public:
+	const std::vector<double> &m_top;
+	HigherTriangle(const std::vector<double> &top):m_top(top){}
+	bool operator()(unsigned int a, unsigned int b) const { return m_top[a] > m_top[b]; }
+};
+
+TriangleGrid::TriangleGrid(const std::list<GTri> &tri_list, double cell_size)
+{
+	m_triangles.assign(tri_list.begin(), tri_list.end());
+
+	std::vector<double> tops;
+	double total_size = 0.0;
+	for(unsigned int i = 0; i<m_triangles.size(); i++)
+	{
+		const GTri& tri = m_triangles[i];
+		double top = tri.m_p[2];
+		if(tri.m_p[5] > top)top = tri.m_p[5];
+		if(tri.m_p[8] > top)top = tri.m_p[8];
+		tops.push_back(top);
+
+		if(i == 0)memcpy(m_box, tri.m_box, 4*sizeof(double));
+		if(tri.m_box[0] < m_box[0])m_box[0] = tri.m_box[0];
+		if(tri.m_box[1] < m_box[1])m_box[1] = tri.m_box[1];
+		if(tri.m_box[2] > m_box[2])m_box[2] = tri.m_box[2];
+		if(tri.m_box[3] > m_box[3])m_box[3] = tri.m_box[3];
+
+		double w = tri.m_box[2] - tri.m_box[0];
+		double h = tri.m_box[3] - tri.m_box[1];
+		total_size += (w > h) ? w : h;
+	}
+
+	if(m_triangles.size() == 0)
+	{
+		m_box[0] = m_box[1] = m_box[2] = m_box[3] = 0.0;
+		m_cell_size = 1.0;
+		m_columns = m_rows = 0;
+		m_cell_start.push_back(0);
+		return;
+	}
+
+	// by default make the cells about the size of an average triangle
+	if(cell_size <= 0.0)cell_size = total_size / m_triangles.size();
+	if(cell_size <= 0.0)cell_size = 1.0;
+
+	// but don't have many more cells than triangles
+	m_cell_size = cell_size;
+	while(true)
+	{
+		m_columns = (int)((m_box[2] - m_box[0]) / m_cell_size) + 1;
+		m_rows = (int)((m_box[3] - m_box[1]) / m_cell_size) + 1;
+		if((double)m_columns * (double)m_rows <= 4.0 * m_triangles.size() + 1.0)break;
+		m_cell_size *= 2.0;
+	}
+
+	std::vector< std::vector<unsigned int> > cells(m_columns * m_rows);
+	for(unsigned int i = 0; i<m_triangles.size(); i++)
+	{
+		const GTri& tri = m_triangles[i];
+		int c0 = Column(tri.m_box[0]), c1 = Column(tri.m_box[2]);
+		int r0 = Row(tri.m_box[1]), r1 = Row(tri.m_box[3]);
+		for(int row = r0; row <= r1; row++)
+		{
+			for(int column = c0; column <= c1; column++)
+			{
+				cells[row * m_columns + column].push_back(i);
+			}
+		}
+	}
+
+	// lay the cells out one after the other, each padded with entries which are below everything, so the
+	// drop stops at them, and whose boxes are nowhere, so they are never near the cutter
+	for(unsigned int i = 0; i<cells.size(); i++)
+	{
+		std::vector<unsigned int> &cell = cells[i];
+		std::sort(cell.begin(), cell.end(), HigherTriangle(tops));
+
+		m_cell_start.push_back((unsigned int)m_entry_triangle.size());
+		for(unsigned int j = 0; j < cell.size(); j++)
+		{
+			const GTri& tri = m_triangles[cell[j]];
+			m_entry_triangle.push_back(cell[j]);
+			for(int k = 0; k<4; k++)m_entry_box[k].push_back(tri.m_box[k]);
+			m_entry_top.push_back(tops[cell[j]]);
+		}
+		while(m_entry_triangle.size() % BLOCK != 0)
+		{
+			m_entry_triangle.push_back(0);
+			m_entry_box[0].push_back(DBL_MAX);
+			m_entry_box[1].push_back(DBL_MAX);
+			m_entry_box[2].push_back(-DBL_MAX);
+			m_entry_box[3].push_back(-DBL_MAX);
+			m_entry_top.push_back(-DBL_MAX);
+		}
+	}
+	m_cell_start.push_back((unsigned int)m_entry_triangle.size());
+}
+
+int TriangleGrid::Column(double x) const
+{
+	int column = (int)floor((x - m_box[0]) / m_cell_size);
+	if(column < 0)return 0;
+	if(column >= m_columns)return m_columns - 1;
+	return column;
+}
+
+int TriangleGrid::Row(double y) const
+{
+	int row = (int)floor((y - m_box[1]) / m_cell_size);
+	if(row < 0)return 0;
+	if(row >= m_rows)return m_rows - 1;
+	return row;
+}
+
+TriangleGridScratch::TriangleGridScratch(const TriangleGrid &grid)
+{
+	m_tested.resize(grid.Triangles().size(), 0);
+	m_pass = 0;
+}
+
+double DropCutter::TriTest(const Cutter &cu, const double *e, const TriangleGrid &grid, TriangleGridScratch &scratch, double minz)
+{
+	if(grid.m_triangles.size() == 0)return minz;
+
+	// is the cutter anywhere near the triangles?
+	double x0 = e[0] - cu.R, y0 = e[1] - cu.R, x1 = e[0] + cu.R, y1 = e[1] + cu.R;
+	if(x1 < grid.m_box[0])return minz;
+	if(y1 < grid.m_box[1])return minz;
+	if(x0 > grid.m_box[2])return minz;
+	if(y0 > grid.m_box[3])return minz;
+
+	scratch.m_pass++;
+	if(scratch.m_pass == 0)
+	{
+		// the counter has wrapped around
+		std::fill(scratch.m_tested.begin(), scratch.m_tested.end(), 0);
+		scratch.m_pass = 1;
+	}
+
+	int c0 = grid.Column(x0), c1 = grid.Column(x1);
+	int r0 = grid.Row(y0), r1 = grid.Row(y1);
+
+	double z = minz;
+	for(int row = r0; row <= r1; row++)
+	{
+		for(int column = c0; column <= c1; column++)
+		{
+			int cell = row * grid.m_columns + column;
+			bool below = false;
+			for(unsigned int first = grid.m_cell_start[cell]; !below && first < grid.m_cell_start[cell + 1]; first += TriangleGrid::BLOCK)
+			{
+				// how far each of the block's triangles' boxes is from the cutter's square, more than zero meaning
+				// it's not under the cutter.  This is done without branches so the compiler can do the triangles side by side.
+				const double *min_x = &(grid.m_entry_box[0][first]);
+				const double *min_y = &(grid.m_entry_box[1][first]);
+				const double *max_x = &(grid.m_entry_box[2][first]);
+				const double *max_y = &(grid.m_entry_box[3][first]);
+				double gap[TriangleGrid::BLOCK];
+				for(int k = 0; k < TriangleGrid::BLOCK; k++)
+				{
+					double gap_x = (min_x[k] - x1 > x0 - max_x[k]) ? (min_x[k] - x1) : (x0 - max_x[k]);
+					double gap_y = (min_y[k] - y1 > y0 - max_y[k]) ? (min_y[k] - y1) : (y0 - max_y[k]);
+					gap[k] = (gap_x > gap_y) ? gap_x : gap_y;
+				}
+
+				for(int k = 0; k < TriangleGrid::BLOCK; k++)
+				{
+					// none of the tests can put the cutter above the triangle's highest point,
+					// so once we get to triangles that are below the cutter, the rest are too
+					if(grid.m_entry_top[first + k] <= z){below = true; break;}
+					if(gap[k] > 0.0)continue;
+
+					unsigned int i = grid.m_entry_triangle[first + k];
+					if(scratch.m_tested[i] == scratch.m_pass)continue;
+					scratch.m_tested[i] = scratch.m_pass;
+
+					double temp_z = TriTest(cu, e, grid.m_triangles[i], minz);
+					if(temp_z > z)z = temp_z;
+				}
+			}
+		}
+	}
+
+	return z;
+}
+
+// drops the cutter at some of a batch's positions, on a worker thread with its own scratch
+class DropJob : public CWorkerJob
+{
+public:
+	const Cutter *m_cutter;
+	const std::vector<double> *m_xy;
+	const TriangleGrid *m_grid;
+	double m_minz;
+	std::vector< std::pair<int, unsigned int> >::const_iterator m_begin, m_end; // the positions to do
+	std::vector<double> *m_z; // each job only writes the heights of its own positions
+
+	virtual void Run()
+	{
+		TriangleGridScratch scratch(*m_grid);
+		for(std::vector< std::pair<int, unsigned int> >::const_iterator It = m_begin; It != m_end; It++)
+		{
+			unsigned int i = It->second;
+			double e[3] = {(*m_xy)[i*2], (*m_xy)[i*2+1], 0.0};
+			(*m_z)[i] = DropCutter::TriTest(*m_cutter, e, *m_grid, scratch, m_minz);
+		}
+	}
+};
+
+void DropCutter::TriTest(const Cutter &cu, const std::vector<double> &xy, const TriangleGrid &grid, double minz, std::vector<double> &z)
+{
+	unsigned int num_positions = (unsigned int)(xy.size() / 2);
+	z.resize(num_positions);
+	if(grid.m_triangles.size() == 0)
+	{
+		std::fill(z.begin(), z.end(), minz);
+		return;
+	}
+
+	// visit the positions cell by cell, so each cell's triangles are tested against all the
+	// positions over it while they are still in the cache
+	std::vector< std::pair<int, unsigned int> > order;
+	order.reserve(num_positions);
+	for(unsigned int i = 0; i<num_positions; i++)
+	{
+		order.push_back(std::make_pair(grid.Row(xy[i*2+1]) * grid.m_columns + grid.Column(xy[i*2]), i));
+	}
+	std::sort(order.begin(), order.end());
+
+	// give each thread a run of neighbouring positions, but not so few that starting the thread costs more than it saves
+	const unsigned int min_positions_per_job = 256;
+	unsigned int num_jobs = CWorkerThreads::Count();
+	if(num_jobs > num_positions / min_positions_per_job)num_jobs = num_positions / min_positions_per_job;
+	if(num_jobs < 1)num_jobs = 1;
+
+	std::vector<DropJob> jobs(num_jobs);
+	for(unsigned int j = 0; j<num_jobs; j++)
+	{
+		jobs[j].m_cutter = &cu;
+		jobs[j].m_xy = &xy;
+		jobs[j].m_grid = &grid;
+		jobs[j].m_minz = minz;
+		jobs[j].m_begin = order.begin() + (num_positions * j / num_jobs);
+		jobs[j].m_end = order.begin() + (num_positions * (j + 1) / num_jobs);
+		jobs[j].m_z = &z;
+	}
+
+	std::vector<CWorkerJob*> job_pointers;
+	for(unsigned int j = 0; j<num_jobs; j++)job_pointers.push_back(&jobs[j]);
+	CWorkerThreads::Run(job_pointers);
+}
@@ -17,14 +17,65 @@
 // Anders Wallin said:
 // yes, you are free to release this under the BSD license if you want. As someone pointed out on my blog the edge-test for the toroidal cutter is wrong, or at least only an approximation to the exact geometry
 
+#include "GTri.h"
+
+#include <list>
+#include <vector>
+
 class Cutter{
 public:
 	double R; // shaft radius
     double r; // corner radius
+	double tolerance; // read from HeeksCAD once, rather than inside every test
     Cutter(double Rset, double rset);
 };
 
-class GTri;
+// The triangles held in one contiguous array and bucketed into a uniform grid of square cells
+// in the XY plane.  Each cell lists the triangles whose boxes overlap it, highest first, so a
+// drop can stop looking at a cell as soon as its triangles are all below the cutter.
+// Dropping cutters doesn't change the grid, so threads can share one, as long as each has its own TriangleGridScratch.
+class TriangleGrid
+{
+public:
+	TriangleGrid(const std::list<GTri> &tri_list, double cell_size = 0.0); // cell_size <= 0 means choose one from the triangles
+
+	const std::vector<GTri> &Triangles() const { return m_triangles; }
+
+	// a cell's entries are padded to a whole number of blocks, which are tested this many at a time
+	enum { BLOCK = 4 };
+
+private:
+	friend class DropCutter;
+
+	std::vector<GTri> m_triangles;
+	double m_box[4]; // minx miny maxx maxy of all the triangles
+	double m_cell_size;
+	int m_columns;
+	int m_rows;
+
+	// the cells' entries, one after the other, row by row; cell n's entries go from m_cell_start[n] up to m_cell_start[n+1].
+	// Each entry has its triangle's number, box and highest z, in separate arrays so a block of entries can be tested at once.
+	std::vector<unsigned int> m_cell_start;
+	std::vector<unsigned int> m_entry_triangle;
+	std::vector<double> m_entry_box[4];
+	std::vector<double> m_entry_top;
+
+	int Column(double x) const;
+	int Row(double y) const;
+};
+
+// The pass in which each triangle was last tested, so triangles spanning several cells are only tested once per drop.
+class TriangleGridScratch
+{
+public:
+	TriangleGridScratch(const TriangleGrid &grid);
+
+private:
+	friend class DropCutter;
+
+	std::vector<unsigned int> m_tested;
+	unsigned int m_pass;
+};
 
 class DropCutter
 {
@@ -40,5 +91,12 @@ public:
 
 	// This one does TriTest for a whole load of triangles
     static double TriTest(const Cutter &cu, const double *e, const std::list<GTri> &tri_list, double minz);
+
+	// This one only tests the triangles in the grid cells under the cutter
+    static double TriTest(const Cutter &cu, const double *e, const TriangleGrid &grid, TriangleGridScratch &scratch, double minz);
+
+	// This one drops the cutter at a whole batch of positions; xy holds x,y pairs and z gets one height per pair.
+	// The batch is split between worker threads.
+    static void TriTest(const Cutter &cu, const std::vector<double> &xy, const TriangleGrid &grid, double minz, std::vector<double> &z);
 };
 
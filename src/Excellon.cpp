@@ -33,6 +33,71 @@ extern CHeeksCADInterface* heeksCAD;
 
 /* static */ bool Excellon::s_allow_dummy_tool_definitions = true;
 
+/**
+	Commands that are recognised but which don't alter the drill pattern we produce.
+	Where one keyword is a prefix of another, the longer keyword must come first.
+ */
+static const struct
+{
+	const char *keyword;
+	const char *description;
+} ignored_commands[] = {
+	{ "AFS", "Automatic Feeds and Speeds" },
+	{ "ATCOFF", "Tool Change - OFF command" },
+	{ "ATCON", "Tool Change - ON command" },
+	{ "CCW", "Counter-Clockwise routing" },
+	{ "CP", "Cutter Compensation" },
+	{ "DETECT", "Broken Tool Detection" },
+	{ "DN", "Down Limit Set" },
+	{ "DTMDIST", "Maximum Route Distance Before Tool Change" },
+	{ "EXDA", "Extended Drill Area" },
+	{ "FSB", "Feeds and Speeds Button OFF" },
+	{ "G04", "variable dwell (G04) command" },
+	{ "G05", "select drill mode (G05) command" },
+	{ "G81", "select drill mode (G81) command" },
+	{ "HBCK", "Home Button Check" },
+	{ "NCSL", "NC Slope Enable/Disable" },
+	{ "OM48", "Override Part Program Header" },
+	{ "OSTOP", "Optional Stop switch" },
+	{ "OTCLMP", "Override Table Clamp" },
+	{ "PCKPARAM", "Set up pecking tool,depth,infeed and retract parameters" },
+	{ "PF", "Floating Pressure Foot Switch" },
+	{ "PPR", "Programmable Plunge Rate Enable" },
+	{ "PVS", "Pre-vacuum Shut-off Switch" },
+	{ "RCP", "Reset Program Clocks" },
+	{ "RCR", "Reset Run Clocks" },
+	{ "RC", "Reset Clocks" },
+	{ "RD", "Reset All Cutter Distances" },
+	{ "RH", "Reset All Hit Counters" },
+	{ "SBK", "Single Block Mode Switch" },
+	{ "SG", "Spindle Group Mode" },
+	{ "SIXM", "Input From External Source" },
+	{ "TCSTOFF", "Tool Change Stop - OFF command" },
+	{ "TCSTON", "Tool Change Stop - ON command" },
+	{ "UP", "Upper Limit Switch Set" },
+	{ "ZA", "Auxiliary Zero" },
+	{ "ZC", "Zero Correction" },
+	{ "ZS", "Zero Preset" },
+	{ NULL, NULL }
+};
+
+// Hole locations are bucketed into grid cells of this size (in mm) when looking for duplicates.
+static const double grid_cell_size = 1.0;
+
+/**
+	If the text at *p starts with keyword then move *p past it and return true.
+ */
+static bool Accept( const char **p, const char *keyword )
+{
+	const char *q = *p;
+	while (*keyword != '\0')
+	{
+		if (*q++ != *keyword++) return(false);
+	}
+	*p = q;
+	return(true);
+}
+
 Excellon::Excellon()
 {
 	m_units = 25.4;	// inches.
@@ -55,6 +120,10 @@ Excellon::Excellon()
 
 	m_feed_rate = 50.0;
 	m_spindle_speed = 0.0;
+
+	m_position = gp_Pnt(0.0, 0.0, 0.0);
+	m_grid_cell_size = grid_cell_size;
+	m_point_tolerance = 0.0;
 } // End constructor
 
 
@@ -63,72 +132,122 @@ Excellon::Excellon()
 	doesn't accept 'd' or 'D' as radix values.  Some locale configurations
 	use 'd' or 'D' as radix values just as 'e' or 'E' might be used.  This
 	confuses subsequent commands held on the same line as the coordinate.
+
+	Only the characters that can form part of a number are copied into a
+	small local buffer before handing them to strtod() so that we don't
+	need to copy the remainder of the line for every coordinate.
  */
 double Excellon::special_strtod( const char *value, const char **end ) const
 {
-	std::string _value(value);
-	char *_end = NULL;
+	char buffer[64];
+	unsigned int length = 0;
 
-	std::string::size_type offset = _value.find_first_of( "dD" );
-	if (offset != std::string::npos)
+	for (const char *p = value; (*p != '\0') && (length < sizeof(buffer) - 1); p++)
 	{
-		_value.erase(offset);
+		if (((*p >= '0') && (*p <= '9')) || (*p == '.') || (*p == '+') || (*p == '-') || (*p == 'e') || (*p == 'E'))
+		{
+			buffer[length++] = *p;
+		}
+		else
+		{
+			break;
+		}
 	}
+	buffer[length] = '\0';
 
-	double dval = strtod( _value.c_str(), &_end );
+	char *_end = NULL;
+	double dval = strtod( buffer, &_end );
 	if (end)
 	{
-		*end = value + (_end - _value.c_str());
+		*end = value + (_end - buffer);
 	}
 	return(dval);
 }
 
-// Filter out '\r' and '\n' characters.
-char Excellon::ReadChar( const char *data, int *pos, const int max_pos )
+/**
+	Add any PointType objects that already exist in the drawing to the set of
+	known locations so that we don't duplicate points.
+ */
+void Excellon::AddExistingPoints()
 {
-	if (*pos < max_pos)
+	for (HeeksObj *obj = heeksCAD->GetFirstObject(); obj != NULL; obj = heeksCAD->GetNextObject() )
 	{
-		while ( ((*pos) < max_pos) && ((data[*pos] == '\r') || (data[*pos] == '\n')) )
+		if (obj->GetType() != PointType) continue;
+		double pos[3];
+		obj->GetStartPoint( pos );
+
+		unsigned int index = FindOrAddLocation( CNCPoint( pos ) );
+		if (m_locations[index].m_symbol.second == 0)
 		{
-			if(data[*pos] == '\n') m_current_line++;
-			(*pos)++;
+			m_locations[index].m_symbol = CDrilling::Symbol_t( PointType, obj->m_id );
 		}
-		if (*pos < max_pos)
-		{
-			return(data[(*pos)++]);
-		} // End if - then
-		else
-		{
-			return(-1);
-		} // End if - else
-	} // End if - then
-	else
-	{
-		return(-1);
-	} // End if - else
-} // End ReadChar() method
+	} // End for
+} // End AddExistingPoints() method
 
-std::string Excellon::ReadBlock( const char *data, int *pos, const int max_pos )
+/**
+	Return the index (into m_locations) of the location that matches point.  Two
+	points match if they're within the sum of their tolerances of each other (as
+	per CNCPoint::operator==).  If there is no such location, add one now.
+ */
+unsigned int Excellon::FindOrAddLocation( const CNCPoint & point )
 {
-	char delimiter;
-	std::ostringstream l_ossBlock;
+	if (m_point_tolerance <= 0.0)
+	{
+		m_point_tolerance = heeksCAD->GetTolerance() * 2.0;
+	}
 
-	// Read first char to determine if it's a parameter or not.
-	char c = ReadChar(data,pos,max_pos);
+	// Only the cells that lie within tolerance of this point can hold a match.
+	long min_i = (long) floor((point.X() - m_point_tolerance) / m_grid_cell_size);
+	long max_i = (long) floor((point.X() + m_point_tolerance) / m_grid_cell_size);
+	long min_j = (long) floor((point.Y() - m_point_tolerance) / m_grid_cell_size);
+	long max_j = (long) floor((point.Y() + m_point_tolerance) / m_grid_cell_size);
 
-	if (c < 0) return(std::string(""));
+	for (long i = min_i; i <= max_i; i++)
+	{
+		for (long j = min_j; j <= max_j; j++)
+		{
+			Grid_t::const_iterator l_itCell = m_grid.find( GridCell_t( i, j ) );
+			if (l_itCell == m_grid.end()) continue;
+
+			for (std::vector<unsigned int>::const_iterator l_itIndex = l_itCell->second.begin(); l_itIndex != l_itCell->second.end(); l_itIndex++)
+			{
+				if (m_locations[*l_itIndex].m_point.Distance( point ) < m_point_tolerance)
+				{
+					return(*l_itIndex);
+				}
+			} // End for
+		} // End for
+	} // End for
 
-	delimiter = '\n';
+	Location_t location;
+	location.m_point = point;
+	location.m_symbol = CDrilling::Symbol_t( PointType, 0 );
+	m_locations.push_back( location );
 
-	l_ossBlock << c;
+	unsigned int index = (unsigned int) (m_locations.size() - 1);
+	GridCell_t cell( (long) floor(point.X() / m_grid_cell_size), (long) floor(point.Y() / m_grid_cell_size) );
+	m_grid[ cell ].push_back( index );
+	return(index);
+} // End FindOrAddLocation() method
 
-	while (((c = ReadChar(data,pos,max_pos)) > 0) && (c != delimiter))
+/**
+	Create the point objects for all the hole locations that didn't match an existing
+	point.  This is done once, after the whole file has been read, so that the
+	drawing is only updated (and an undo point created) once per import.
+ */
+void Excellon::CreatePointObjects()
+{
+	for (Locations_t::iterator l_itLocation = m_locations.begin(); l_itLocation != m_locations.end(); l_itLocation++)
 	{
-		l_ossBlock << c;
-	} // End while
+		if (l_itLocation->m_symbol.second != 0) continue;
 
-	return(l_ossBlock.str());
-} // End ReadBlock() method
+		double location[3];
+		l_itLocation->m_point.ToDoubleArray( location );
+		HeeksObj *point = heeksCAD->NewPoint( location );
+		heeksCAD->Add( point, NULL );
+		l_itLocation->m_symbol = CDrilling::Symbol_t( point->GetType(), point->m_id );
+	} // End for
+} // End CreatePointObjects() method
 
 bool Excellon::Read( const char *p_szFileName, const bool force_mirror /* = false */ )
 {
@@ -139,194 +258,230 @@ bool Excellon::Read( const char *p_szFileName, const bool force_mirror /* = fals
 		m_mirror_image_x_axis = true;
 	}
 
-	// First read in existing PointType object locations so that we don't duplicate points.
-	for (HeeksObj *obj = heeksCAD->GetFirstObject(); obj != NULL; obj = heeksCAD->GetNextObject() )
+	// Read the whole file in one go and tokenize it in place.
+	std::ifstream input( p_szFileName, std::ios::in | std::ios::binary );
+	if (! input.is_open())
 	{
-		if (obj->GetType() != PointType) continue;
-		double pos[3];
-		obj->GetStartPoint( pos );
-		m_existing_points.insert( std::make_pair( CNCPoint( pos ), CDrilling::Symbol_t( PointType, obj->m_id ) ) );
-	} // End for
-
-	std::ifstream input( p_szFileName, std::ios::in );
-	if (input.is_open())
-	{
-		m_current_line = 0;
-
-		while (input.good())
-		{
-			char memblock[512];
+		// Couldn't read file.
+		printf("Could not open '%s' for reading\n", p_szFileName );
+		return(false);
+	} // End if - then
 
-			memset( memblock, '\0', sizeof(memblock) );
-			input.getline( memblock, sizeof(memblock)-1 );
+	input.seekg( 0, std::ios::end );
+	std::streamoff file_size = input.tellg();
+	input.seekg( 0, std::ios::beg );
 
-			if (memblock[0] != '\0')
-			{
-				if (! ReadDataBlock( memblock )) return(false);
-			} // End if - then
-		} // End while
+	std::vector<char> data( (size_t) ((file_size > 0) ? file_size : 0) );
+	if (! data.empty())
+	{
+		input.read( &data[0], data.size() );
+		data.resize( (size_t) input.gcount() );
+	}
+	input.close();
 
-		// Have a look at the endmills we have in the tool table.  Find the smallest one
-		// and offer to counterbore the larger drill holes with that rather than ask for
-		// large drill bits.
+	heeksCAD->CreateUndoPoint();
 
-		CTool *pSmallEndmill = NULL;
-		for (HeeksObj *obj = theApp.m_program->Tools()->GetFirstChild(); obj != NULL; obj = theApp.m_program->Tools()->GetNextChild())
-		{
-		    if (obj->GetType() == ToolType)
-		    {
-		        CTool *pTool = (CTool *) obj;
-		        if ((pTool->m_params.m_type == CToolParams::eEndmill) ||
-                    (pTool->m_params.m_type == CToolParams::eSlotCutter))
-                {
-                    if (pSmallEndmill == NULL) pSmallEndmill = pTool;
-                    if (pSmallEndmill->CuttingRadius(false, 2.0) > pTool->CuttingRadius(false, 2.0))
-                    {
-                        pSmallEndmill = pTool;
-                    }
-                }
-		    }
-		}
+	// First read in existing PointType object locations so that we don't duplicate points.
+	AddExistingPoints();
 
-        bool use_counterbore_operation = false;
+	m_current_line = 0;
+	const char *data_end = data.empty() ? NULL : &data[0] + data.size();
+	for (const char *line = data.empty() ? NULL : &data[0]; line < data_end; )
+	{
+		const char *line_end = line;
+		while ((line_end < data_end) && (*line_end != '\n')) line_end++;
+		m_current_line++;
 
-		std::set< CTool::ToolNumber_t > tool_numbers;
-		for (Holes_t::const_iterator l_itHole = m_holes.begin(); l_itHole != m_holes.end(); l_itHole++)
+		if (line_end > line)
 		{
-			tool_numbers.insert( l_itHole->first );
-			if (pSmallEndmill != NULL)
+			if (! ReadDataBlock( line, line_end ))
 			{
-			    CTool *pTool = CTool::Find(l_itHole->first);
-			    if (pTool != NULL)
-			    {
-			        if (pTool->CuttingRadius(false, 2.0) > pSmallEndmill->CuttingRadius(false, 2.0))
-			        {
-			            use_counterbore_operation = true;
-			        }
-			    }
+				printf("Excellon::Read() failed at line %d\n", m_current_line );
+				heeksCAD->Changed();
+				return(false);
 			}
-		} // End for
+		} // End if - then
 
-		if ((pSmallEndmill != NULL) && (use_counterbore_operation == true))
-		{
-		    use_counterbore_operation = false;
+		line = line_end + 1;
+	} // End for
 
-		    // We've found an endmill.  Offer to use it on the larger holes.
-		    wxString message(_("Use counterbore for larger holes?"));
-            wxString caption(_("Use counterbore for larger holes?"));
+	// Now that we know all the hole locations, add the points that don't already exist.
+	CreatePointObjects();
 
-            wxArrayString choices;
+	// Have a look at the endmills we have in the tool table.  Find the smallest one
+	// and offer to counterbore the larger drill holes with that rather than ask for
+	// large drill bits.
 
+	CTool *pSmallEndmill = NULL;
+	for (HeeksObj *obj = theApp.m_program->Tools()->GetFirstChild(); obj != NULL; obj = theApp.m_program->Tools()->GetNextChild())
+	{
+	    if (obj->GetType() == ToolType)
+	    {
+	        CTool *pTool = (CTool *) obj;
+	        if ((pTool->m_params.m_type == CToolParams::eEndmill) ||
+                (pTool->m_params.m_type == CToolParams::eSlotCutter))
             {
-                wxString option;
-                option << _("Use ") << pSmallEndmill->m_title << _(" for holes larger than ") << pSmallEndmill->CuttingRadius(true, 2.0) << _T("?");
-                choices.Add(option);
+                if (pSmallEndmill == NULL) pSmallEndmill = pTool;
+                if (pSmallEndmill->CuttingRadius(false, 2.0) > pTool->CuttingRadius(false, 2.0))
+                {
+                    pSmallEndmill = pTool;
+                }
             }
-            choices.Add(_("Use drill operation for all holes"));
+	    }
+	}
 
-            wxString choice = ::wxGetSingleChoice( message, caption, choices );
+    bool use_counterbore_operation = false;
 
-            if ((choices.size() > 0) && (choice == choices[0]))
-            {
-                use_counterbore_operation = true;
-            }
+	std::map< CTool::ToolNumber_t, CDrilling::Symbols_t > symbols_by_tool;
+	for (Holes_t::const_iterator l_itHole = m_holes.begin(); l_itHole != m_holes.end(); l_itHole++)
+	{
+		CDrilling::Symbols_t & symbols = symbols_by_tool[ l_itHole->first ];
+		for (std::vector<unsigned int>::const_iterator l_itIndex = l_itHole->second.begin(); l_itIndex != l_itHole->second.end(); l_itIndex++)
+		{
+			symbols.push_back( m_locations[ *l_itIndex ].m_symbol );
 		}
 
-		// Now go through and add the drilling cycles for each different tool.
+		if (pSmallEndmill != NULL)
+		{
+		    CTool *pTool = CTool::Find(l_itHole->first);
+		    if (pTool != NULL)
+		    {
+		        if (pTool->CuttingRadius(false, 2.0) > pSmallEndmill->CuttingRadius(false, 2.0))
+		        {
+		            use_counterbore_operation = true;
+		        }
+		    }
+		}
+	} // End for
+
+	if ((pSmallEndmill != NULL) && (use_counterbore_operation == true))
+	{
+	    use_counterbore_operation = false;
 
+	    // We've found an endmill.  Offer to use it on the larger holes.
+	    wxString message(_("Use counterbore for larger holes?"));
+        wxString caption(_("Use counterbore for larger holes?"));
 
-		for (std::set<CTool::ToolNumber_t>::const_iterator l_itToolNumber = tool_numbers.begin();
-			l_itToolNumber != tool_numbers.end(); l_itToolNumber++)
-		{
-			double depth = 2.5;	// mm
+        wxArrayString choices;
 
-			CTool *pTool = CTool::Find(*l_itToolNumber);
-			if ((pTool != NULL) &&
-				(pTool->CuttingRadius(false, 2.0) > pSmallEndmill->CuttingRadius(false, 2.0)) &&
-				(use_counterbore_operation == true))
-			{	
-				CCounterBore *new_object = new CCounterBore( m_holes[ *l_itToolNumber ], *l_itToolNumber );
-				new_object->m_params.m_diameter = pTool->CuttingRadius(false,2.0) * 2.0;
-				new_object->m_params.m_finishing_pass = 0.0;
-				new_object->m_params.m_sort_locations = true;
-				new_object->m_depth_op_params.m_start_depth = 0.0;
-				new_object->m_depth_op_params.m_final_depth = -1.0 * depth;
-				new_object->m_depth_op_params.m_step_down = pSmallEndmill->CuttingRadius(false,2.0) / 2.0;	// step down one quarter of the diameter.
-				new_object->m_speed_op_params.m_spindle_speed = m_spindle_speed;
-				new_object->m_speed_op_params.m_vertical_feed_rate = m_feed_rate;
-				new_object->m_depth_op_params.m_rapid_safety_space = 2.0;		// Printed Circuit Boards a quite flat
-				new_object->m_depth_op_params.ClearanceHeight( 10.0 );		// Printed Circuit Boards a quite flat
+        {
+            wxString option;
+            option << _("Use ") << pSmallEndmill->m_title << _(" for holes larger than ") << pSmallEndmill->CuttingRadius(true, 2.0) << _T("?");
+            choices.Add(option);
+        }
+        choices.Add(_("Use drill operation for all holes"));
 
-				theApp.m_program->Operations()->Add(new_object,NULL);
-			}
-			else
-			{
-				CDrilling *new_object = new CDrilling( m_holes[ *l_itToolNumber ], *l_itToolNumber, depth );
-				new_object->m_speed_op_params.m_spindle_speed = m_spindle_speed;
-				new_object->m_speed_op_params.m_vertical_feed_rate = m_feed_rate;
-				new_object->m_params.m_peck_depth = 0.0;	// Don't peck for a Printed Circuit Board.
-				new_object->m_params.m_dwell = 0.0;		// Don't wait around to clear stringers either.
-				new_object->m_params.m_standoff = 2.0;		// Printed Circuit Boards a quite flat
-
-				theApp.m_program->Operations()->Add(new_object,NULL);
-			}
-		} // End for
+        wxString choice = ::wxGetSingleChoice( message, caption, choices );
 
-		return(true);	// Success
-	} // End if - then
-	else
+        if ((choices.size() > 0) && (choice == choices[0]))
+        {
+            use_counterbore_operation = true;
+        }
+	}
+
+	// Now go through and add the drilling cycles for each different tool.
+	for (std::map< CTool::ToolNumber_t, CDrilling::Symbols_t >::const_iterator l_itSymbols = symbols_by_tool.begin();
+		l_itSymbols != symbols_by_tool.end(); l_itSymbols++)
 	{
-		// Couldn't read file.
-		printf("Could not open '%s' for reading\n", p_szFileName );
-		return(false);
-	} // End if - else
+		double depth = 2.5;	// mm
+
+		CTool *pTool = CTool::Find(l_itSymbols->first);
+		if ((use_counterbore_operation == true) &&
+			(pTool != NULL) &&
+			(pTool->CuttingRadius(false, 2.0) > pSmallEndmill->CuttingRadius(false, 2.0)))
+		{
+			CCounterBore *new_object = new CCounterBore( l_itSymbols->second, l_itSymbols->first );
+			new_object->m_params.m_diameter = pTool->CuttingRadius(false,2.0) * 2.0;
+			new_object->m_params.m_finishing_pass = 0.0;
+			new_object->m_params.m_sort_locations = true;
+			new_object->m_depth_op_params.m_start_depth = 0.0;
+			new_object->m_depth_op_params.m_final_depth = -1.0 * depth;
+			new_object->m_depth_op_params.m_step_down = pSmallEndmill->CuttingRadius(false,2.0) / 2.0;	// step down one quarter of the diameter.
+			new_object->m_speed_op_params.m_spindle_speed = m_spindle_speed;
+			new_object->m_speed_op_params.m_vertical_feed_rate = m_feed_rate;
+			new_object->m_depth_op_params.m_rapid_safety_space = 2.0;		// Printed Circuit Boards a quite flat
+			new_object->m_depth_op_params.ClearanceHeight( 10.0 );		// Printed Circuit Boards a quite flat
+
+			theApp.m_program->Operations()->Add(new_object,NULL);
+		}
+		else
+		{
+			CDrilling *new_object = new CDrilling( l_itSymbols->second, l_itSymbols->first, depth );
+			new_object->m_speed_op_params.m_spindle_speed = m_spindle_speed;
+			new_object->m_speed_op_params.m_vertical_feed_rate = m_feed_rate;
+			new_object->m_params.m_peck_depth = 0.0;	// Don't peck for a Printed Circuit Board.
+			new_object->m_params.m_dwell = 0.0;		// Don't wait around to clear stringers either.
+			new_object->m_params.m_standoff = 2.0;		// Printed Circuit Boards a quite flat
+
+			theApp.m_program->Operations()->Add(new_object,NULL);
+		}
+	} // End for
+
+	heeksCAD->Changed();
+	return(true);	// Success
 } // End Read() method
 
 
 double Excellon::InterpretCoord(
 	const char *coordinate,
+	const int length,
 	const int digits_left_of_point,
 	const int digits_right_of_point,
 	const bool leading_zero_suppression,
 	const bool trailing_zero_suppression ) const
 {
+	static const double powers_of_ten[] = { 1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12 };
+	static const int max_power = (int) (sizeof(powers_of_ten) / sizeof(powers_of_ten[0])) - 1;
 
 	double multiplier = m_units;
-	double result;
-	std::string _coord( coordinate );
+	const char *p = coordinate;
+	const char *end = coordinate + length;
 
-	if (_coord[0] == '-')
+	if ((p < end) && (*p == '-'))
 	{
 		multiplier *= -1.0;
-		_coord.erase(0,1);
+		p++;
 	} // End if - then
 
-	if (_coord[0] == '+')
+	if ((p < end) && (*p == '+'))
 	{
-		multiplier *= +1.0;
-		_coord.erase(0,1);
+		p++;
 	} // End if - then
 
-	if (leading_zero_suppression)
+	// Accumulate all the digits as a single integer and then work out where the decimal point belongs.
+	double digits = 0.0;
+	int num_digits = 0;
+	for ( ; p < end; p++)
 	{
-	    while (_coord.size() < (unsigned int) digits_right_of_point) _coord.insert(0,"0");
+		if ((*p < '0') || (*p > '9')) break;
+		digits = (digits * 10.0) + (*p - '0');
+		num_digits++;
+	}
 
+	int exponent;
+	if (leading_zero_suppression)
+	{
 		// use the end of the string as the reference point.
-		result = atof( _coord.substr( 0, _coord.size() - digits_right_of_point ).c_str() );
-		result += (atof( _coord.substr( _coord.size() - digits_right_of_point ).c_str() ) / pow(10.0, digits_right_of_point));
+		exponent = -digits_right_of_point;
 	} // End if - then
 	else
 	{
-		if (trailing_zero_suppression)
-		{
-		    while (_coord.size() < (unsigned int) digits_left_of_point) _coord.push_back('0');
-		} // End while
-
-		// use the beginning of the string as the reference point.
-		result = atof( _coord.substr( 0, digits_left_of_point ).c_str() );
-		result += (atof( _coord.substr( digits_left_of_point ).c_str() ) / pow(10.0, (int)(_coord.size() - digits_left_of_point)));
+		// use the beginning of the string as the reference point.  If trailing zeroes have been
+		// suppressed then the missing digits are zeroes.
+		exponent = digits_left_of_point - num_digits;
+		if ((! trailing_zero_suppression) && (exponent > 0)) exponent = 0;
 	} // End if - else
 
+	double result = digits;
+	if (exponent < 0)
+	{
+		result /= ((-exponent <= max_power) ? powers_of_ten[-exponent] : pow(10.0, -exponent));
+	}
+	else if (exponent > 0)
+	{
+		result *= ((exponent <= max_power) ? powers_of_ten[exponent] : pow(10.0, exponent));
+	}
+
 	result *= multiplier;
 
 	// printf("Excellon::InterpretCoord(%s) = %lf\n", coordinate, result );
@@ -334,522 +489,273 @@ double Excellon::InterpretCoord(
 } // End InterpretCoord() method
 
 
-bool Excellon::ReadDataBlock( const std::string & data_block )
+/**
+	Read the coordinate value that follows an 'X' or 'Y' character.  *p points
+	at the first character of the number and is moved past it.  The returned
+	value is in mm.
+ */
+bool Excellon::ReadCoordinate( const char **p, const unsigned int digits_left_of_point, const unsigned int digits_right_of_point, double *pValue ) const
 {
-	std::string _data( data_block );
-	std::string::size_type offset;
-	while ((offset = _data.find('%')) != _data.npos) _data.erase(offset,1);
-	while ((offset = _data.find('*')) != _data.npos) _data.erase(offset,1);
-	while ((offset = _data.find(',')) != _data.npos) _data.erase(offset,1);
-	while ((offset = _data.find(' ')) != _data.npos) _data.erase(offset,1);
-	while ((offset = _data.find('\t')) != _data.npos) _data.erase(offset,1);
-	while ((offset = _data.find('\r')) != _data.npos) _data.erase(offset,1);
+	const char *end = NULL;
+
+	double value = special_strtod( *p, &end );
+	if ((end == NULL) || (end == *p))
+	{
+		return(false);
+	} // End if - then
+
+	bool decimal_point_found = false;
+	for (const char *c = *p; c < end; c++)
+	{
+		if (*c == '.') decimal_point_found = true;
+	}
+
+	if (decimal_point_found)
+	{
+		// The number had a decimal point explicitly defined within it.  Read it as a correctly
+		// represented number as is.
+		*pValue = value * m_units;
+	}
+	else
+	{
+		*pValue = InterpretCoord( *p, (int) (end - *p),
+						digits_left_of_point,
+						digits_right_of_point,
+						m_leadingZeroSuppression,
+						m_trailingZeroSuppression );
+	}
+
+	*p = end;
+	return(true);
+} // End ReadCoordinate() method
+
 
+/**
+	Interpret a single line of the file.  The line is scanned once to remove the
+	characters we don't care about and then the commands are consumed from the
+	front of it without any further copying.
+ */
+bool Excellon::ReadDataBlock( const char *begin, const char *end )
+{
 	char buffer[1024];
-	memset(buffer,'\0', sizeof(buffer));
-	strcpy( buffer, data_block.c_str() );
+	unsigned int length = 0;
+	for (const char *c = begin; (c < end) && (length < sizeof(buffer) - 1); c++)
+	{
+		switch (*c)
+		{
+		case '%':
+		case '*':
+		case ',':
+		case ' ':
+		case '\t':
+		case '\r':
+			break;
+
+		default:
+			buffer[length++] = *c;
+			break;
+		} // End switch
+	} // End for
+	buffer[length] = '\0';
 
-	static gp_Pnt position(0.0,0.0,0.0);
 	bool position_has_been_set = false;
 
 	bool m02_found = false;
 	bool swap_axis = false;
-	bool mirror_image_x_axis = false;
-	bool mirror_image_y_axis = false;
 	unsigned int excellon_tool_number = 0;
 	double tool_diameter = 0.0;
 
-	while (_data.size() > 0)
+	const char *p = buffer;
+	while (*p != '\0')
 	{
-	    if (_data.substr(0,2) == "RT")
+		bool ignored = false;
+		for (int i = 0; ignored_commands[i].keyword != NULL; i++)
+		{
+			if (Accept( &p, ignored_commands[i].keyword ))
+			{
+				printf("Ignoring %s\n", ignored_commands[i].description );
+				ignored = true;
+				break;
+			}
+		} // End for
+
+		if (ignored) continue;
+
+		char *end_of_number = NULL;
+
+	    if (Accept( &p, "RT" ))
 		{
 			// Reset Tool Data
-			_data.erase(0,2);
             m_tool_table_map.clear();
             m_active_tool_number = 0;
 		}
-		else if (_data.substr(0,4) == "FMAT")
+		else if (Accept( &p, "FMAT" ))
 		{
 			// Ignore format
-			_data.erase(0,4);
-			char *end = NULL;
-			unsigned long format = strtoul( _data.c_str(), &end, 10 );
-			_data.erase(0, end - _data.c_str());
+			unsigned long format = strtoul( p, &end_of_number, 10 );
+			p = end_of_number;
 			printf("Ignoring Format %ld command\n", format );
 		}
-		else if (_data.substr(0,3) == "AFS")
-		{
-			// Ignore format
-			_data.erase(0,3);
-			printf("Ignoring Automatic Feeds and Speeds\n");
-		}
-		else if (_data.substr(0,3) == "CCW")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Counter-Clockwise routing\n");
-		}
-		else if (_data.substr(0,2) == "CP")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Cutter Compensation\n");
-		}
-		else if (_data.substr(0,6) == "DETECT")
-		{
-			_data.erase(0,6);
-			printf("Ignoring Broken Tool Detection\n");
-		}
-        else if (_data.substr(0,2) == "DN")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Down Limit Set\n");
-		}
-		else if (_data.substr(0,6) == "DTMDIST")
-		{
-			_data.erase(0,6);
-			printf("Ignoring Maximum Route Distance Before Tool Change\n");
-		}
-		else if (_data.substr(0,4) == "EXDA")
-		{
-			_data.erase(0,4);
-			printf("Ignoring Extended Drill Area\n");
-		}
-		else if (_data.substr(0,3) == "FSB")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Feeds and Speeds Button OFF\n");
-		}
-		else if (_data.substr(0,4) == "HBCK")
-		{
-			_data.erase(0,4);
-			printf("Ignoring Home Button Check\n");
-		}
-		else if (_data.substr(0,4) == "NCSL")
-		{
-			_data.erase(0,4);
-			printf("Ignoring NC Slope Enable/Disable\n");
-		}
-		else if (_data.substr(0,4) == "OM48")
-		{
-			_data.erase(0,4);
-			printf("Ignoring Override Part Program Header\n");
-		}
-		else if (_data.substr(0,5) == "OSTOP")
-		{
-			_data.erase(0,5);
-			printf("Ignoring Optional Stop switch\n");
-		}
-		else if (_data.substr(0,6) == "OTCLMP")
-		{
-			_data.erase(0,6);
-			printf("Ignoring Override Table Clamp\n");
-		}
-		else if (_data.substr(0,8) == "PCKPARAM")
-		{
-			_data.erase(0,8);
-			printf("Ignoring Set up pecking tool,depth,infeed and retract parameters\n");
-		}
-        else if (_data.substr(0,2) == "PF")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Floating Pressure Foot Switch\n");
-		}
-		else if (_data.substr(0,3) == "PPR")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Programmable Plunge Rate Enable\n");
-		}
-		else if (_data.substr(0,3) == "PVS")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Pre-vacuum Shut-off Switch\n");
-		}
-		else if (_data.substr(0,3) == "RC")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Reset Clocks\n");
-		}
-		else if (_data.substr(0,3) == "RCP")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Reset Program Clocks\n");
-		}
-		else if (_data.substr(0,3) == "RCR")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Reset Run Clocks\n");
-		}
-		else if (_data.substr(0,2) == "RD")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Reset All Cutter Distances\n");
-		}
-		else if (_data.substr(0,2) == "RH")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Reset All Hit Counters\n");
-		}
-		else if (_data.substr(0,3) == "SBK")
-		{
-			_data.erase(0,3);
-			printf("Ignoring Single Block Mode Switch\n");
-		}
-		else if (_data.substr(0,2) == "SG")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Spindle Group Mode\n");
-		}
-		else if (_data.substr(0,4) == "SIXM")
-		{
-			_data.erase(0,4);
-			printf("Ignoring Input From External Source\n");
-		}
-		else if (_data.substr(0,2) == "UP")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Upper Limit Switch Set\n");
-		}
-		else if (_data.substr(0,2) == "ZA")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Auxiliary Zero\n");
-		}
-		else if (_data.substr(0,2) == "ZC")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Zero Correction\n");
-		}
-		else if (_data.substr(0,2) == "ZS")
-		{
-			_data.erase(0,2);
-			printf("Ignoring Zero Preset\n");
-		}
-		else if (_data.substr(0,1) == "Z")
-		{
-			_data.erase(0,1);
-			printf("Ignoring Zero Set\n");
-		}
-		else if (_data.substr(0,3) == "VER")
+		else if (Accept( &p, "VER" ))
 		{
 			// Ignore version
-			_data.erase(0,3);
-			char *end = NULL;
-			unsigned long version = strtoul( _data.c_str(), &end, 10 );
-			_data.erase(0, end - _data.c_str());
+			unsigned long version = strtoul( p, &end_of_number, 10 );
+			p = end_of_number;
 			printf("Ignoring Version %ld command\n", version);
 		}
-		else if (_data.substr(0,6) == "TCSTON")
-		{
-			// Tool Change Stop - ON
-			printf("Ignoring Tool Change Stop - ON command\n");
-			_data.erase(0,6);
-		}
-		else if (_data.substr(0,7) == "TCSTOFF")
-		{
-			// Tool Change Stop - OFF
-			printf("Ignoring Tool Change Stop - OFF command\n");
-			_data.erase(0,7);
-		}
-		else if (_data.substr(0,5) == "ATCON")
-		{
-			// Automatic Tool Change - ON
-			printf("Ignoring Tool Change - ON command\n");
-			_data.erase(0,5);
-		}
-		else if (_data.substr(0,6) == "ATCOFF")
-		{
-			// Automatic Tool Change - OFF
-			printf("Ignoring Tool Change - OFF command\n");
-			_data.erase(0,6);
-		}
-		else if (_data.substr(0,3) == "M30")
+		else if (Accept( &p, "M30" ) || Accept( &p, "M00" ))
 		{
 			// End of program
-			_data.erase(0,3);
 		}
-		else if (_data.substr(0,1) == ";")
+		else if (Accept( &p, ";" ))
 		{
-			_data.erase(0,1);
 			return(true);	// Ignore all subsequent comments until the end of line.
 		}
-		else if (_data.substr(0,4) == "INCH")
+		else if (Accept( &p, "INCH" ) || Accept( &p, "M72" ))
 		{
-			_data.erase(0,4);
 			m_units = 25.4;	// Imperial
 		}
-		else if (_data.substr(0,6) == "METRIC")
+		else if (Accept( &p, "METRIC" ) || Accept( &p, "MM" ) || Accept( &p, "M71" ))
 		{
-			_data.erase(0,6);
 			m_units = 1.0;	// mm
 		}
-		else if (_data.substr(0,2) == "MM")
+		else if (Accept( &p, "TZ" ))
 		{
-			_data.erase(0,2);
-			m_units = 1.0;	// mm
-		}
-		else if (_data.substr(0,2) == "TZ")
-		{
-			_data.erase(0,2);
 			// In Excellon files, the TZ means that trailing zeroes are INCLUDED
 			// while in RS274X format, it means they're OMITTED
 			m_trailingZeroSuppression = false;
 		}
-		else if (_data.substr(0,2) == "LZ")
+		else if (Accept( &p, "LZ" ))
 		{
-			_data.erase(0,2);
 			// In Excellon files, the LZ means that leading zeroes are INCLUDED
 			// while in RS274X format, it means they're OMITTED
 			m_leadingZeroSuppression = false;
 		}
-		else if (_data.substr(0,1) == "T")
+		else if (Accept( &p, "T" ))
 		{
-			_data.erase(0,1);
-			char *end = NULL;
-			excellon_tool_number = strtoul( _data.c_str(), &end, 10 );
-			_data.erase(0, end - _data.c_str());
+			excellon_tool_number = strtoul( p, &end_of_number, 10 );
+			p = end_of_number;
 		}
-		else if (_data.substr(0,1) == "C")
+		else if (Accept( &p, "C" ))
 		{
-			_data.erase(0,1);
 			const char *end = NULL;
-			tool_diameter = special_strtod( _data.c_str(), &end );
-			_data.erase(0, end - _data.c_str());
+			tool_diameter = special_strtod( p, &end );
+			p = end;
 		}
-		else if (_data.substr(0,3) == "M02")
+		else if (Accept( &p, "M02" ))
 		{
-			_data.erase(0,3);
 			m02_found = true;
 		}
-		else if (_data.substr(0,3) == "M00")
-		{
-			// End of program
-			_data.erase(0,3);
-		}
-		else if ((_data.substr(0,3) == "M25") ||
-			 (_data.substr(0,3) == "M31") ||
-			 (_data.substr(0,3) == "M08") ||
-			 (_data.substr(0,3) == "M01"))
+		else if (Accept( &p, "M25" ) ||
+			 Accept( &p, "M31" ) ||
+			 Accept( &p, "M08" ) ||
+			 Accept( &p, "M01" ) ||
+			 Accept( &p, "R" ))
 		{
 			// Beginning of pattern
 			printf("Pattern repetition is not yet supported\n");
 			return(false);
 		}
-		else if (_data.substr(0,1) == "R")
+		else if (Accept( &p, "M70" ))
 		{
-			_data.erase(0,1);
-			printf("Pattern repetition is not yet supported\n");
-			return(false);
-
-			/*
-			char *end = NULL;
-			repetitions = strtoul( _data.c_str(), &end, 10 );
-			_data.erase(0, end - _data.c_str());
-			*/
-		}
-		else if (_data.substr(0,3) == "M70")
-		{
-			_data.erase(0,3);
 			swap_axis = true;
 		}
-		else if (_data.substr(0,3) == "M80")
+		else if (Accept( &p, "M80" ))
 		{
-			_data.erase(0,3);
-			mirror_image_x_axis = true;
+			printf("Ignoring mirror image X axis (M80) command\n");
 		}
-		else if (_data.substr(0,3) == "G90")
+		else if (Accept( &p, "Z" ))
 		{
-			_data.erase(0,3);
-			mirror_image_y_axis = true;
+			printf("Ignoring Zero Set\n");
 		}
-		else if (_data.substr(0,1) == "N")
+		else if (Accept( &p, "N" ))
 		{
 			// Ignore block numbers
-			_data.erase(0,1);
-			char *end = NULL;
-			strtoul( _data.c_str(), &end, 10 );
-			_data.erase( 0, end - _data.c_str() );
+			strtoul( p, &end_of_number, 10 );
+			p = end_of_number;
 		}
-		else if (_data.substr(0,1) == "X")
+		else if (Accept( &p, "X" ))
 		{
-			_data.erase(0,1);	// Erase X
-			const char *end = NULL;
-
-			double x = special_strtod( _data.c_str(), &end );
-			if ((end == NULL) || (end == _data.c_str()))
+			double x;
+			if (! ReadCoordinate( &p, m_XDigitsLeftOfPoint, m_XDigitsRightOfPoint, &x ))
 			{
 				printf("Expected number following 'X'\n");
 				return(false);
 			} // End if - then
-			std::string x_string = _data.substr(0, end - _data.c_str());
-			_data.erase(0, end - _data.c_str());
 
             position_has_been_set = true;
-            if (x_string.find('.') == std::string::npos)
+            if (m_absoluteCoordinatesMode)
             {
-
-                double x = InterpretCoord( x_string.c_str(),
-                                m_YDigitsLeftOfPoint,
-                                m_YDigitsRightOfPoint,
-                                m_leadingZeroSuppression,
-                                m_trailingZeroSuppression );
-
-                if (m_absoluteCoordinatesMode)
-                {
-                    position.SetX( x );
-                }
-                else
-                {
-                    // Incremental position.
-                    position.SetX( position.X() + x );
-                }
+                m_position.SetX( x );
             }
             else
             {
-                // The number had a decimal point explicitly defined within it.  Read it as a correctly
-                // represented number as is.
-                if (m_absoluteCoordinatesMode)
-                {
-                    position.SetX( x * m_units );
-                }
-                else
-                {
-                    // Incremental position.
-                    position.SetX( position.X() + (x * m_units) );
-                }
+                // Incremental position.
+                m_position.SetX( m_position.X() + x );
             }
 		}
-		else if (_data.substr(0,1) == "Y")
+		else if (Accept( &p, "Y" ))
 		{
-			_data.erase(0,1);	// Erase Y
-			const char *end = NULL;
-
-			double y = special_strtod( _data.c_str(), &end );
-			if ((end == NULL) || (end == _data.c_str()))
+			double y;
+			if (! ReadCoordinate( &p, m_YDigitsLeftOfPoint, m_YDigitsRightOfPoint, &y ))
 			{
 				printf("Expected number following 'Y'\n");
 				return(false);
 			} // End if - then
-			std::string y_string = _data.substr(0, end - _data.c_str());
-			_data.erase(0, end - _data.c_str());
 
             position_has_been_set = true;
-            if (y_string.find('.') == std::string::npos)
+            if (m_absoluteCoordinatesMode)
             {
-                double y = InterpretCoord( y_string.c_str(),
-                                m_YDigitsLeftOfPoint,
-                                m_YDigitsRightOfPoint,
-                                m_leadingZeroSuppression,
-                                m_trailingZeroSuppression );
-
-                if (m_absoluteCoordinatesMode)
-                {
-                    position.SetY( y );
-                }
-                else
-                {
-                    // Incremental position.
-                    position.SetY( position.Y() + y );
-                }
+                m_position.SetY( y );
             }
             else
             {
-                    // The number already has a decimal point explicitly defined within it.
-
-                    if (m_absoluteCoordinatesMode)
-                    {
-                        position.SetY( y * m_units );
-                    }
-                    else
-                    {
-                        // Incremental position.
-                        position.SetY( position.Y() + (y * m_units) );
-                    }
+                // Incremental position.
+                m_position.SetY( m_position.Y() + y );
             }
 		}
-		else if (_data.substr(0,3) == "G05")
-		{
-			_data.erase(0,3);
-			printf("Ignoring select drill mode (G05) command\n");
-		}
-		else if (_data.substr(0,3) == "G81")
-		{
-			_data.erase(0,3);
-			printf("Ignoring select drill mode (G81) command\n");
-		}
-		else if (_data.substr(0,3) == "G04")
-		{
-			_data.erase(0,3);
-			printf("Ignoring variable dwell (G04) command\n");
-		}
-		else if (_data.substr(0,3) == "G90")
-		{
-			_data.erase(0,3);
-			m_absoluteCoordinatesMode = true; 	// It's the only mode we use anyway.
-		}
-        else if (_data.substr(0,6) == "ICIOFF")
+		else if (Accept( &p, "G90" ) || Accept( &p, "ICIOFF" ))
 		{
-			_data.erase(0,6);
 			m_absoluteCoordinatesMode = true; 	// It's the only mode we use anyway.
 		}
-		else if (_data.substr(0,3) == "G91")    // Incremental coordinates mode ON
+		else if (Accept( &p, "G91" ) || Accept( &p, "ICION" ))    // Incremental coordinates mode ON
 		{
-			_data.erase(0,3);
 			m_absoluteCoordinatesMode = false;
 		}
-		else if (_data.substr(0,5) == "ICION")    // Incremental coordinates mode ON
+		else if (Accept( &p, "G92" ))
 		{
-			_data.erase(0,5);
-			m_absoluteCoordinatesMode = false;
-		}
-		else if (_data.substr(0,3) == "G92")
-		{
-			_data.erase(0,3);
 			printf("Set zero (G92) is not yet supported\n");
 			return(false);
 		}
-		else if (_data.substr(0,3) == "G93")
+		else if (Accept( &p, "G93" ))
 		{
-			_data.erase(0,3);
 			printf("Set zero (G93) is not yet supported\n");
 			return(false);
 		}
-		else if (_data.substr(0,3) == "M48")
+		else if (Accept( &p, "M48" ))
 		{
-			_data.erase(0,3);
 			// Ignore 'Program Header to first "%"'
 		}
-		else if (_data.substr(0,3) == "M47")
+		else if (Accept( &p, "M47" ))
 		{
-			_data.erase(0,3);
 			// Ignore 'Operator Message CRT Display'
 			return(true);	// Ignore the rest of the line.
 		}
-		else if (_data.substr(0,3) == "M71")
-		{
-			_data.erase(0,3);
-			m_units = 1.0;	// Metric
-		}
-		else if (_data.substr(0,3) == "M72")
-		{
-			_data.erase(0,3);
-			m_units = 25.4;	// Imperial
-		}
-		else if (_data.substr(0,1) == "S")
+		else if (Accept( &p, "S" ))
 		{
-			_data.erase(0,1);
 			const char *end = NULL;
-			m_spindle_speed = special_strtod( _data.c_str(), &end );
-			_data.erase(0, end - _data.c_str());
+			m_spindle_speed = special_strtod( p, &end );
+			p = end;
 		}
-		else if (_data.substr(0,1) == "F")
+		else if (Accept( &p, "F" ))
 		{
-			_data.erase(0,1);
 			const char *end = NULL;
-			m_feed_rate = special_strtod( _data.c_str(), &end ) * m_units;
-			_data.erase(0, end - _data.c_str());
+			m_feed_rate = special_strtod( p, &end ) * m_units;
+			p = end;
 		}
 		else
 		{
-			printf("Unexpected command '%s'\n", _data.c_str() );
+			printf("Unexpected command '%s'\n", p );
 			return(false);
 		} // End if - else
 	} // End while
@@ -917,48 +823,21 @@ bool Excellon::ReadDataBlock( const std::string & data_block )
 		} // End if - then
 		else
 		{
-			// We've been given a position.  See if we already have a point object
-			// at this location.  If so, use it.  Otherwise add a new one.
-			CNCPoint cnc_point( position );
+			// We've been given a position.  See if we already have a point
+			// at this location.  If so, use it.  Otherwise remember a new one.
+			CNCPoint cnc_point( m_position );
 			if (m_mirror_image_x_axis) cnc_point.SetY( cnc_point.Y() * -1.0 ); // mirror about X axis
             if (m_mirror_image_y_axis) cnc_point.SetX( cnc_point.X() * -1.0 ); // mirror about Y axis
 
-			if (m_existing_points.find( cnc_point ) == m_existing_points.end())
-			{
-				// There are no pre-existing Point objects for this location.  Add one now.
-				double location[3];
-				cnc_point.ToDoubleArray( location );
-				HeeksObj *point = heeksCAD->NewPoint( location );
-				heeksCAD->Add( point, NULL );
-				CDrilling::Symbol_t symbol( point->GetType(), point->m_id );
-				m_existing_points.insert( std::make_pair( cnc_point, symbol ));
-			} // End if - then
-
-			// There is already a point here.  Use it.
-			if (m_holes.find( m_active_tool_number ) == m_holes.end())
-			{
-				// We haven't used this drill bit before.  Add it now.
-				CDrilling::Symbols_t symbols;
-				CDrilling::Symbol_t symbol( m_existing_points[ cnc_point ] );
-				symbols.push_back( symbol );
-
-				m_holes.insert( std::make_pair( m_active_tool_number, symbols ) );
-			}
-			else
-			{
-				// We've already used this drill bit.  Just add to its list of symbols.
-				m_holes[ m_active_tool_number ].push_back( m_existing_points[ cnc_point ] );
-			} // End if - else
+			m_holes[ m_active_tool_number ].push_back( FindOrAddLocation( cnc_point ) );
 
 			/*
 			printf("Drill hole using tool %d at x=%lf, y=%lf z=%lf\n", m_active_tool_number,
-				pPosition->X(), pPosition->Y(), pPosition->Z() );
+				m_position.X(), m_position.Y(), m_position.Z() );
 			*/
 		} // End if - else
 	} // End if - then
 
-
-
 	return(true);
 } // End ReadDataBlock() method
 
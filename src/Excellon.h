@@ -13,6 +13,7 @@ for isolation milling.
 #include <list>
 #include <map>
 #include <algorithm>
+#include <vector>
 #include <iostream>
 
 #include "Drilling.h"
@@ -36,18 +37,22 @@ class Excellon
 
 	private:
 
-		char ReadChar( const char *data, int *pos, const int max_pos );
-		std::string ReadBlock( const char *data, int *pos, const int max_pos );
 		double special_strtod( const char *value, const char **end ) const;
 
-		bool ReadDataBlock( const std::string & data_block );
+		bool ReadDataBlock( const char *begin, const char *end );
+		bool ReadCoordinate( const char **p, const unsigned int digits_left_of_point, const unsigned int digits_right_of_point, double *pValue ) const;
 
 		double InterpretCoord(	const char *coordinate,
+					const int length,
 					const int digits_left_of_point,
 					const int digits_right_of_point,
 					const bool leading_zero_suppression,
 					const bool trailing_zero_suppression ) const;
 
+		void AddExistingPoints();
+		unsigned int FindOrAddLocation( const CNCPoint & point );
+		void CreatePointObjects();
+
 		int m_current_line;
 
 		double m_units;	// 1 = mm, 25.4 = inches
@@ -69,16 +74,41 @@ class Excellon
 		double m_spindle_speed;
 		double m_feed_rate;
 
+		gp_Pnt m_position;
+
 		// Associates tool number in the Excellon file with tools in the Tools (plural) list.
 		typedef std::map< unsigned int, CTool::ToolNumber_t > ToolTableMap_t;
 		ToolTableMap_t	m_tool_table_map;
 
-		typedef std::map< CTool::ToolNumber_t, CDrilling::Symbols_t > Holes_t;
+		/**
+			Every distinct hole location (whether it came from an existing PointType
+			object or from the file) is held once in m_locations.  The symbol's ID
+			remains zero until the point object is created after the whole file
+			has been read so that all the new objects are added in one go.
+		 */
+		typedef struct
+		{
+			CNCPoint m_point;
+			CDrilling::Symbol_t m_symbol;
+		} Location_t;
+		typedef std::vector< Location_t > Locations_t;
+		Locations_t m_locations;
+
+		/**
+			The locations are bucketed into a uniform XY grid so that looking for
+			an existing point at a new hole's position only needs to compare
+			against the points in the neighbouring cells.
+		 */
+		typedef std::pair< long, long > GridCell_t;
+		typedef std::map< GridCell_t, std::vector< unsigned int > > Grid_t;
+		Grid_t m_grid;
+		double m_grid_cell_size;
+		double m_point_tolerance;
+
+		// Indices into m_locations for each of our tool numbers, in the order they appear in the file.
+		typedef std::map< CTool::ToolNumber_t, std::vector< unsigned int > > Holes_t;
 		Holes_t m_holes;
 
-		typedef std::map< CNCPoint, CDrilling::Symbol_t > Points_t;
-		Points_t	m_existing_points;
-
 public:
 		static void GetOptions(std::list<Property *> *list);
 		static bool s_allow_dummy_tool_definitions;
@@ -62,6 +62,7 @@ CFixtureParams & CFixtureParams::operator= ( const CFixtureParams & rhs )
 		m_touch_off_point_defined = rhs.m_touch_off_point_defined;
 		m_touch_off_point = rhs.m_touch_off_point;
 		m_touch_off_description = rhs.m_touch_off_description;
+		m_height_map = rhs.m_height_map;
 	}
 
 	return(*this);
@@ -230,6 +231,15 @@ void CFixtureParams::WriteXMLAttributes(TiXmlNode *root)
 	element->SetDoubleAttribute( "touch_off_point_z", m_touch_off_point.Z());
 
 	element->SetAttribute( "touch_off_description", m_touch_off_description.utf8_str());
+
+	for (std::vector<gp_Pnt>::const_iterator l_itPoint = m_height_map.begin(); l_itPoint != m_height_map.end(); l_itPoint++)
+	{
+		TiXmlElement *point = heeksCAD->NewXMLElement( "height_map_point" );
+		heeksCAD->LinkXMLEndChild( element, point );
+		point->SetDoubleAttribute( "x", l_itPoint->X());
+		point->SetDoubleAttribute( "y", l_itPoint->Y());
+		point->SetDoubleAttribute( "z", l_itPoint->Z());
+	}
 }
 
 void CFixtureParams::ReadParametersFromXMLElement(TiXmlElement* pElem)
@@ -259,6 +269,18 @@ void CFixtureParams::ReadParametersFromXMLElement(TiXmlElement* pElem)
 	if (pElem->Attribute("touch_off_point_z")) { pElem->Attribute("touch_off_point_z", &value); m_touch_off_point.SetZ( value ); }
 
 	if (pElem->Attribute("touch_off_description")) m_touch_off_description = Ctt(pElem->Attribute("touch_off_description"));
+
+	m_height_map.clear();
+	for(TiXmlElement* pPoint = heeksCAD->FirstXMLChildElement( pElem ) ; pPoint; pPoint = pPoint->NextSiblingElement())
+	{
+		if (std::string(pPoint->Value()) != "height_map_point") continue;
+
+		double x = 0.0, y = 0.0, z = 0.0;
+		pPoint->Attribute("x", &x);
+		pPoint->Attribute("y", &y);
+		pPoint->Attribute("z", &z);
+		m_height_map.push_back(gp_Pnt(x, y, z));
+	}
 }
 
 const wxBitmap &CFixture::GetIcon()
@@ -1142,6 +1164,83 @@ void CFixture::SetRotationsFromProbedPoints( const wxString & probed_points_xml_
 	} // End if - else
 } // End SetRotationsFromProbedPoints() method
 
+/**
+	Read the points recorded by a probing program (one element per point with X, Y and Z
+	child elements).  The file is in the program's units.  The points are returned in drawing
+	units.  Returns false (having told the operator) if the file can't be read.
+ */
+/* static */ bool CFixture::ReadProbedPoints( const wxString & probed_points_xml_file_name, std::vector<CNCPoint> & points )
+{
+	TiXmlDocument* xml = heeksCAD->NewXMLDocument();
+	if (! xml->LoadFile( probed_points_xml_file_name.utf8_str() ))
+	{
+		wxString text;
+		text << _("Failed to load XML file ") << probed_points_xml_file_name;
+		wxMessageBox(text);
+		return(false);
+	} // End if - then
+
+	TiXmlElement *root = xml->RootElement();
+	if (root == NULL) return(false);
+
+	for(TiXmlElement* pElem = heeksCAD->FirstXMLChildElement( root ); pElem; pElem = pElem->NextSiblingElement())
+	{
+		CNCPoint point(0,0,0);
+		for(TiXmlElement* pPoint = heeksCAD->FirstXMLChildElement( pElem ) ; pPoint; pPoint = pPoint->NextSiblingElement())
+		{
+		    std::string name(pPoint->Value());
+			wxString value( Ctt(pPoint->GetText()) );
+			double number = 0.0;
+			if (value.ToDouble(&number))
+			{
+			    if (name == "X") { point.SetX( number * PROGRAM->m_units ); }
+                if (name == "Y") { point.SetY( number * PROGRAM->m_units ); }
+                if (name == "Z") { point.SetZ( number * PROGRAM->m_units ); }
+			}
+		} // End for
+
+		points.push_back(point);
+	} // End for
+
+	return(true);
+} // End ReadProbedPoints() method
+
+/**
+	Keep the probed points as this fixture's height map.  Moves made in this fixture are then
+	raised or lowered to follow the surface they describe (see nc/level.py).
+ */
+void CFixture::SetHeightMapFromProbedPoints( const wxString & probed_points_xml_file_name )
+{
+	std::vector<CNCPoint> points;
+	if (! ReadProbedPoints( probed_points_xml_file_name, points )) return;
+
+	m_params.m_height_map.clear();
+	for (std::vector<CNCPoint>::const_iterator l_itPoint = points.begin(); l_itPoint != points.end(); l_itPoint++)
+	{
+		m_params.m_height_map.push_back( gp_Pnt( l_itPoint->X(false), l_itPoint->Y(false), l_itPoint->Z(false) ) );
+	}
+} // End SetHeightMapFromProbedPoints() method
+
+/**
+	Python to make the moves that follow it follow this fixture's height map.
+ */
+Python CFixture::HeightMapBegin() const
+{
+	Python python;
+	if (m_params.m_height_map.size() == 0) return(python);
+
+	python << _T("import nc.level\n");
+	python << _T("nc.level.level_begin([");
+	for (std::vector<gp_Pnt>::const_iterator l_itPoint = m_params.m_height_map.begin(); l_itPoint != m_params.m_height_map.end(); l_itPoint++)
+	{
+		if (l_itPoint != m_params.m_height_map.begin()) python << _T(", ");
+		python << _T("(") << l_itPoint->X() / PROGRAM->m_units << _T(", ") << l_itPoint->Y() / PROGRAM->m_units << _T(", ") << l_itPoint->Z() / PROGRAM->m_units << _T(")");
+	}
+	python << _T("], ") << heeksCAD->GetTolerance() / PROGRAM->m_units << _T(")\n");
+
+	return(python);
+} // End HeightMapBegin() method
+
 
 class Fixture_ImportProbeData: public Tool
 {
@@ -1172,15 +1271,100 @@ public:
 
 static Fixture_ImportProbeData import_probe_data;
 
+class Fixture_ImportHeightMap: public Tool
+{
+
+CFixture *m_pThis;
+
+public:
+	Fixture_ImportHeightMap() { m_pThis = NULL; }
+
+	// Tool's virtual functions
+	const wxChar* GetTitle(){return _("Import height map");}
+
+	void Run()
+	{
+		// Prompt the user to select a file to import.
+		wxFileDialog fd(heeksCAD->GetMainFrame(), _T("Select a file to import"), _T("."), _T(""),
+				wxString(_("Known Files")) + _T(" |*.xml;*.XML;")
+					+ _T("*.Xml;"),
+					wxOPEN | wxFILE_MUST_EXIST );
+		fd.SetFilterIndex(1);
+		if (fd.ShowModal() == wxID_CANCEL) return;
+		m_pThis->SetHeightMapFromProbedPoints( fd.GetPath().c_str() );
+	}
+	wxString BitmapPath(){ return _T("import");}
+	void Set( CFixture *pThis ) { m_pThis = pThis; }
+};
+
+static Fixture_ImportHeightMap import_height_map;
+
+class Fixture_ClearHeightMap: public Tool
+{
+
+CFixture *m_pThis;
+
+public:
+	Fixture_ClearHeightMap() { m_pThis = NULL; }
+
+	// Tool's virtual functions
+	const wxChar* GetTitle(){return _("Clear height map");}
+
+	void Run()
+	{
+		m_pThis->m_params.m_height_map.clear();
+	}
+	wxString BitmapPath(){ return _T("delete");}
+	void Set( CFixture *pThis ) { m_pThis = pThis; }
+};
+
+static Fixture_ClearHeightMap clear_height_map;
+
 void CFixture::GetTools(std::list<Tool*>* t_list, const wxPoint* p)
 {
 
 	import_probe_data.Set( this );
 
 	t_list->push_back( &import_probe_data );
+
+	import_height_map.Set( this );
+	t_list->push_back( &import_height_map );
+
+	if (m_params.m_height_map.size() > 0)
+	{
+		clear_height_map.Set( this );
+		t_list->push_back( &clear_height_map );
+	}
 }
 
 
+/**
+	Returns true if operations generated for this fixture would produce exactly the same
+	GCode (in terms of their own coordinate systems) as those generated for the other one.
+	i.e. the two fixtures only differ by their coordinate system numbers (and touch-off
+	details) so one subroutine can be called in each of them.
+ */
+bool CFixture::SameToolpathsAs( CFixture & rhs )
+{
+	if (m_params.m_clearance_height != rhs.m_params.m_clearance_height) return(false);
+
+	// Moves are levelled when the Python runs so the subroutine is only right for both if they're levelled alike.
+	if (m_params.m_height_map.size() != rhs.m_params.m_height_map.size()) return(false);
+	for (std::vector<gp_Pnt>::size_type i = 0; i < m_params.m_height_map.size(); i++)
+	{
+		if (CNCPoint(m_params.m_height_map[i]) != CNCPoint(rhs.m_params.m_height_map[i])) return(false);
+	}
+
+	double tolerance = heeksCAD->GetTolerance();
+	gp_Pnt points[4] = { gp_Pnt(0.0, 0.0, 0.0), gp_Pnt(100.0, 0.0, 0.0), gp_Pnt(0.0, 100.0, 0.0), gp_Pnt(0.0, 0.0, 100.0) };
+	for (int i = 0; i < 4; i++)
+	{
+		if (Adjustment(points[i]).Distance(rhs.Adjustment(points[i])) > tolerance) return(false);
+	}
+
+	return(true);
+} // End SameToolpathsAs() method
+
 bool CFixture::operator== ( const CFixture & rhs ) const
 {
 	// if (m_params != rhs.m_params) return(false);	// When we're importing data, we only want to compare on coordinate system number.
@@ -1204,6 +1388,12 @@ bool CFixtureParams::operator== ( const CFixtureParams & rhs ) const
 	if (CNCPoint(m_touch_off_point) != CNCPoint(rhs.m_touch_off_point)) return(false);
 	if (m_touch_off_description != rhs.m_touch_off_description) return(false);
 
+	if (m_height_map.size() != rhs.m_height_map.size()) return(false);
+	for (std::vector<gp_Pnt>::size_type i = 0; i < m_height_map.size(); i++)
+	{
+		if (CNCPoint(m_height_map[i]) != CNCPoint(rhs.m_height_map[i])) return(false);
+	}
+
 	return(true);
 }
 
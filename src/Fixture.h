@@ -19,6 +19,7 @@
 #include <algorithm>
 
 class CFixture;
+class CNCPoint;
 class Python;
 
 class CFixtureParams {
@@ -40,6 +41,9 @@ public:
 	wxString m_touch_off_description;	// Tell the operator what to do when setting up this fixture.
 										// eg: "touch off 0,0,0 at bottom left corner".
 
+	std::vector<gp_Pnt> m_height_map;	// Probed points (in local coordinates and drawing units) on the workpiece's surface.  When there are
+										// any, the Z coordinate of every move is adjusted to follow the surface.
+
 	CFixtureParams()
 	{
 		m_yz_plane = 0.0;
@@ -224,12 +228,16 @@ public:
 	gp_Pnt Adjustment( double *point );
 	gp_Pnt ReverseAdjustment( const gp_Pnt point );		// Place this point from the drawing coordinates to the fixture's coordinates.
 	gp_Pnt Reorient( const gp_Pnt point );
+	bool SameToolpathsAs( CFixture & rhs );
 
 	static void extract(const gp_Trsf& tr, double *m);
 	gp_Trsf GetMatrix(const ePlane_t = XY) const;
 
 	void GetTools(std::list<Tool*>* t_list, const wxPoint* p);
 	void SetRotationsFromProbedPoints( const wxString & probed_points_xml_file_name );
+	void SetHeightMapFromProbedPoints( const wxString & probed_points_xml_file_name );
+	static bool ReadProbedPoints( const wxString & probed_points_xml_file_name, std::vector<CNCPoint> & points );
+	Python HeightMapBegin() const;
 	double AxisAngle( const gp_Pnt & one, const gp_Pnt & two, const gp_Vec & pivot, const gp_Vec & axis ) const;
 
 	bool operator== ( const CFixture & rhs ) const;
@@ -3,6 +3,8 @@
 // triangle used for Anders's DropCutter code
 // written by Dan Heeks starting on May 2nd 2008
 
+#pragma once
+
 class GTri{
 public:
 	double m_p[9]; // three points
@@ -32,6 +32,7 @@
 #include "Pocket.h"
 #include "ZigZag.h"
 #include "Waterline.h"
+#include "HeightmapRough.h"
 #include "Drilling.h"
 #include "Tapping.h"
 #include "Positioning.h"
@@ -57,6 +58,8 @@
 #include "ScriptOp.h"
 #include "AttachOp.h"
 #include "Boring.h"
+#include "Tessellation.h"
+#include "SplineBiarcs.h"
 
 #include <sstream>
 
@@ -334,6 +337,42 @@ static void NewWaterlineOpMenuCallback(wxCommandEvent &event)
 	heeksCAD->Mark(new_object);
 	heeksCAD->Changed();
 }
+
+static void NewHeightmapRoughOpMenuCallback(wxCommandEvent &event)
+{
+	// check for at least one solid selected
+	std::list<int> solids;
+
+	const std::list<HeeksObj*>& list = heeksCAD->GetMarkedList();
+	for(std::list<HeeksObj*>::const_iterator It = list.begin(); It != list.end(); It++)
+	{
+		HeeksObj* object = *It;
+		if(object->GetType() == SolidType || object->GetType() == StlSolidType)solids.push_back(object->m_id);
+	}
+
+	// if no selected solids,
+	if(solids.size() == 0)
+	{
+		// use all the solids in the drawing
+		for(HeeksObj* object = heeksCAD->GetFirstObject();object; object = heeksCAD->GetNextObject())
+		{
+			if(object->GetType() == SolidType || object->GetType() == StlSolidType)solids.push_back(object->m_id);
+		}
+	}
+
+	if(solids.size() == 0)
+	{
+		wxMessageBox(_("There are no solids!"));
+		return;
+	}
+
+	heeksCAD->CreateUndoPoint();
+	CHeightmapRough *new_object = new CHeightmapRough(solids);
+	theApp.m_program->Operations()->Add(new_object, NULL);
+	heeksCAD->ClearMarkedList();
+	heeksCAD->Mark(new_object);
+	heeksCAD->Changed();
+}
 #endif
 
 
@@ -1381,6 +1420,7 @@ static void AddToolBars()
 		heeksCAD->StartToolBarFlyout(_("3D Milling operations"));
 		heeksCAD->AddFlyoutButton(_("ZigZag"), ToolImage(_T("zigzag")), _("New ZigZag Operation..."), NewZigZagOpMenuCallback);
 		heeksCAD->AddFlyoutButton(_("Waterline"), ToolImage(_T("waterline")), _("New Waterline Operation..."), NewWaterlineOpMenuCallback);
+		heeksCAD->AddFlyoutButton(_("3D Rough"), ToolImage(_T("pocket")), _("New Heightmap Roughing Operation..."), NewHeightmapRoughOpMenuCallback);
 		heeksCAD->AddFlyoutButton(_("Attach"), ToolImage(_T("attach")), _("New Attach Operation..."), NewAttachOpMenuCallback);
 		heeksCAD->AddFlyoutButton(_("Unattach"), ToolImage(_T("unattach")), _("New Unattach Operation..."), NewUnattachOpMenuCallback);
 		heeksCAD->EndToolBarFlyout((wxToolBar*)(theApp.m_machiningBar));
@@ -1515,6 +1555,7 @@ void CHeeksCNCApp::OnStartUp(CHeeksCADInterface* h, const wxString& dll_path)
 	wxMenu *menu3dMillingOperations = new wxMenu;
 	heeksCAD->AddMenuItem(menu3dMillingOperations, _("ZigZag Operation..."), ToolImage(_T("zigzag")), NewZigZagOpMenuCallback);
 	heeksCAD->AddMenuItem(menu3dMillingOperations, _("Waterline Operation..."), ToolImage(_T("waterline")), NewWaterlineOpMenuCallback);
+	heeksCAD->AddMenuItem(menu3dMillingOperations, _("Heightmap Roughing Operation..."), ToolImage(_T("pocket")), NewHeightmapRoughOpMenuCallback);
 	heeksCAD->AddMenuItem(menu3dMillingOperations, _("Attach Operation..."), ToolImage(_T("attach")), NewAttachOpMenuCallback);
 	heeksCAD->AddMenuItem(menu3dMillingOperations, _("Unattach Operation..."), ToolImage(_T("unattach")), NewUnattachOpMenuCallback);
 
@@ -1601,6 +1642,15 @@ void CHeeksCNCApp::OnStartUp(CHeeksCADInterface* h, const wxString& dll_path)
 	m_drilling_reference_speed = 3000.0;	// default.
 	config.Read(_T("DrillingReferenceSpeed"), &m_drilling_reference_speed, 3000.0);
 
+	// Solids are tessellated once and then reused by each 3D operation until they change.
+	int tessellation_cache_megabytes = 256;
+	config.Read(_T("TessellationCacheMegabytes"), &tessellation_cache_megabytes, 256);
+	CTessellation::SetMemoryLimit( size_t(tessellation_cache_megabytes) * 1024 * 1024 );
+	heeksCAD->RegisterObserver( &CTessellation::m_observer );
+
+	// Splines are fitted with biarcs once for each deviation until they change.
+	heeksCAD->RegisterObserver( &CSplineBiarcs::m_observer );
+
 	aui_manager->GetPane(m_program_canvas).Show(program_visible);
 	aui_manager->GetPane(m_output_canvas).Show(output_visible);
 
@@ -1622,6 +1672,7 @@ void CHeeksCNCApp::OnStartUp(CHeeksCADInterface* h, const wxString& dll_path)
 	heeksCAD->RegisterReadXMLfunction("Pocket", CPocket::ReadFromXMLElement);
 	heeksCAD->RegisterReadXMLfunction("ZigZag", CZigZag::ReadFromXMLElement);
 	heeksCAD->RegisterReadXMLfunction("Waterline", CWaterline::ReadFromXMLElement);
+	heeksCAD->RegisterReadXMLfunction("HeightmapRough", CHeightmapRough::ReadFromXMLElement);
 	heeksCAD->RegisterReadXMLfunction("Drilling", CDrilling::ReadFromXMLElement);
 	heeksCAD->RegisterReadXMLfunction("Locating", CPositioning::ReadFromXMLElement);
 	heeksCAD->RegisterReadXMLfunction("Positioning", CPositioning::ReadFromXMLElement);
@@ -1928,6 +1979,15 @@ void CHeeksCNCApp::OnFrameDelete()
     config.Write(_T("UseDOSNotUnix"), m_use_DOS_not_Unix);
 	config.Write(_T("StartupFilesDirectory"), m_startup_files_directory );
 	config.Write(_T("DrillingReferenceSpeed"), m_drilling_reference_speed );
+
+	heeksCAD->RemoveObserver( &CTessellation::m_observer );
+	CTessellation::Clear();
+
+	heeksCAD->RemoveObserver( &CSplineBiarcs::m_observer );
+	CSplineBiarcs::Clear();
+
+	// The cached tool solids are OpenCascade shapes so free them while OpenCascade is still with us.
+	CToolGeometryCache::Clear();
 }
 
 wxString CHeeksCNCApp::GetDllFolder()
@@ -2017,6 +2077,7 @@ wxString HeeksCNCType( const int type )
 	case WaterlineType:       return(_("Waterline"));
 	case TappingType:       return(_("Tapping"));
 	case BoringType:		return(_("Boring"));
+	case HeightmapRoughType:       return(_("HeightmapRough"));
 
 	default:
         return(_T("")); // Indicates that this function could not make the conversion.
@@ -42,5 +42,6 @@ enum{
 	RaftType,
 	TappingType,
 	BoringType,
+	HeightmapRoughType,
 	HeeksCNCMaximumType
 };
@@ -0,0 +1,541 @@
+// HeightmapRough.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "HeightmapRough.h"
+#include "CNCConfig.h"
+#include "ProgramCanvas.h"
+#include "interface/PropertyLength.h"
+#include "tinyxml/tinyxml.h"
+#include "Reselect.h"
+#include "PythonStuff.h"
+#include "CTool.h"
+#include "MachineState.h"
+#include "Program.h"
+#include "Fixture.h"
+#include "Tessellation.h"
+#include "DropCutter.h"
+
+#include <map>
+
+// Samples outside the heightmap are treated as being this high so that the contours close around its edge.
+static const double outside_height = 1.0e10;
+
+CHeightmap::CHeightmap( const TriangleGrid & triangles, const CBox & box, const double resolution, const double floor )
+{
+	m_resolution = (resolution > 0.0) ? resolution : 1.0;
+	m_x0 = box.MinX();
+	m_y0 = box.MinY();
+	m_columns = int(ceil((box.MaxX() - box.MinX()) / m_resolution)) + 1;
+	m_rows = int(ceil((box.MaxY() - box.MinY()) / m_resolution)) + 1;
+
+	std::vector<double> xy;
+	xy.reserve( m_columns * m_rows * 2 );
+	for (int row = 0; row < m_rows; row++)
+	{
+		for (int column = 0; column < m_columns; column++)
+		{
+			xy.push_back( m_x0 + column * m_resolution );
+			xy.push_back( m_y0 + row * m_resolution );
+		}
+	}
+
+	// Contours() interpolates its crossing points along the cell edges, so the region it traces
+	// reaches up to a cell's width from the nearest sample that's inside it.  Every point of a cell
+	// that's on the inside of a contour is within sqrt(1.25) cell widths of one of the cell's inside
+	// corners, so a flat cutter of that radius makes sure there's no material above the level
+	// anywhere in the traced region.
+	Cutter cutter( m_resolution * 1.118034, 0.0 );
+	DropCutter::TriTest( cutter, xy, triangles, floor, m_heights );
+}
+
+double CHeightmap::Height( const int column, const int row ) const
+{
+	if ((column < 0) || (column >= m_columns) || (row < 0) || (row >= m_rows)) return(outside_height);
+	return(m_heights[row * m_columns + column]);
+}
+
+/**
+	Edges between neighbouring samples are numbered so that the contour segments from neighbouring
+	cells can be joined up.  The samples are offset by one to make room for the ring of samples outside
+	the heightmap.  Bit 0 says whether the edge runs along x (0) or along y (1) from its sample.
+ */
+static long EdgeId( const int columns, const int column, const int row, const int along_y )
+{
+	return(((long(row + 1) * (columns + 2)) + (column + 1)) * 2 + along_y);
+}
+
+std::pair<double, double> CHeightmap::Crossing( const long edge, const double z ) const
+{
+	int along_y = int(edge % 2);
+	int column = int((edge / 2) % (m_columns + 2)) - 1;
+	int row = int((edge / 2) / (m_columns + 2)) - 1;
+
+	double ha = Height( column, row );
+	double hb = along_y ? Height( column, row + 1 ) : Height( column + 1, row );
+
+	double fraction = 0.5;
+	if (hb != ha) fraction = (z - ha) / (hb - ha);
+	if (fraction < 0.0) fraction = 0.0;
+	if (fraction > 1.0) fraction = 1.0;
+
+	double x = m_x0 + column * m_resolution;
+	double y = m_y0 + row * m_resolution;
+	if (along_y) y += fraction * m_resolution;
+	else x += fraction * m_resolution;
+
+	return(std::make_pair( x, y ));
+}
+
+/**
+	Trace the boundaries of the region where the heightmap is below z (marching squares).  Each cell's
+	segments run with the region on their left.  The crossing points are interpolated along the cell
+	edges so that sloping walls give smooth curves rather than steps.
+ */
+void CHeightmap::Contours( const double z, Loops_t & loops ) const
+{
+	std::map<long, long> next_edge;
+
+	for (int row = -1; row < m_rows; row++)
+	{
+		for (int column = -1; column < m_columns; column++)
+		{
+			// corners and edges anti-clockwise from the bottom left.  Edge k runs from corner k to corner k+1.
+			double heights[4] = { Height(column, row), Height(column + 1, row), Height(column + 1, row + 1), Height(column, row + 1) };
+			bool inside[4];
+			int num_inside = 0;
+			for (int k=0; k<4; k++)
+			{
+				inside[k] = (heights[k] < z);
+				if (inside[k]) num_inside++;
+			}
+			if ((num_inside == 0) || (num_inside == 4)) continue;
+
+			long edges[4] = {	EdgeId(m_columns, column, row, 0),
+								EdgeId(m_columns, column + 1, row, 1),
+								EdgeId(m_columns, column, row + 1, 0),
+								EdgeId(m_columns, column, row, 1) };
+
+			// A saddle is joined up through the middle if the middle (taken as the average) is inside.
+			bool saddle = (inside[0] == inside[2]) && (inside[1] == inside[3]);
+			bool join_insides = (! saddle) || ((heights[0] + heights[1] + heights[2] + heights[3]) * 0.25 < z);
+
+			for (int k=0; k<4; k++)
+			{
+				if (!(inside[k] && !inside[(k+1)%4])) continue;	// segments start where we leave the region
+
+				// and end where we come back into it.
+				for (int step = 1; step < 4; step++)
+				{
+					int j = join_insides ? (k + step) % 4 : (k + 4 - step) % 4;
+					if (!inside[j] && inside[(j+1)%4])
+					{
+						next_edge[edges[k]] = edges[j];
+						break;
+					}
+				}
+			}
+		} // End for
+	} // End for
+
+	double tolerance = m_resolution * 0.001;
+	while (! next_edge.empty())
+	{
+		Loop_t loop;
+		long start = next_edge.begin()->first;
+		long edge = start;
+		while (true)
+		{
+			std::pair<double, double> point = Crossing( edge, z );
+
+			// Drop the middle one of any three points in a line.
+			size_t n = loop.size();
+			if (n >= 2)
+			{
+				double ax = loop[n-1].first - loop[n-2].first, ay = loop[n-1].second - loop[n-2].second;
+				double bx = point.first - loop[n-2].first, by = point.second - loop[n-2].second;
+				if (fabs(ax * by - ay * bx) <= tolerance * sqrt(bx * bx + by * by)) loop.pop_back();
+			}
+			loop.push_back( point );
+
+			std::map<long, long>::iterator l_itNext = next_edge.find( edge );
+			if (l_itNext == next_edge.end()) break;
+			edge = l_itNext->second;
+			next_edge.erase( l_itNext );
+			if (edge == start) break;
+		} // End while
+
+		if (loop.size() >= 3) loops.push_back( loop );
+	} // End while
+} // End Contours() method
+
+
+static void on_set_minx(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_box.m_x[0] = value;}
+static void on_set_maxx(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_box.m_x[3] = value;}
+static void on_set_miny(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_box.m_x[1] = value;}
+static void on_set_maxy(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_box.m_x[4] = value;}
+static void on_set_step_over(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_step_over = value;}
+static void on_set_material_allowance(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_material_allowance = value;}
+static void on_set_resolution(double value, HeeksObj* object){((CHeightmapRough*)object)->m_params.m_resolution = value;}
+
+void CHeightmapRoughParams::GetProperties(CHeightmapRough* parent, std::list<Property *> *list)
+{
+	list->push_back(new PropertyLength(_("minimum x"), m_box.m_x[0], parent, on_set_minx));
+	list->push_back(new PropertyLength(_("maximum x"), m_box.m_x[3], parent, on_set_maxx));
+	list->push_back(new PropertyLength(_("minimum y"), m_box.m_x[1], parent, on_set_miny));
+	list->push_back(new PropertyLength(_("maximum y"), m_box.m_x[4], parent, on_set_maxy));
+	list->push_back(new PropertyLength(_("step over"), m_step_over, parent, on_set_step_over));
+	list->push_back(new PropertyLength(_("material allowance"), m_material_allowance, parent, on_set_material_allowance));
+	list->push_back(new PropertyLength(_("heightmap resolution"), m_resolution, parent, on_set_resolution));
+}
+
+void CHeightmapRoughParams::WriteXMLAttributes(TiXmlNode *root)
+{
+	TiXmlElement * element;
+	element = heeksCAD->NewXMLElement( "params" );
+	heeksCAD->LinkXMLEndChild( root,  element );
+	element->SetDoubleAttribute( "minx", m_box.m_x[0]);
+	element->SetDoubleAttribute( "maxx", m_box.m_x[3]);
+	element->SetDoubleAttribute( "miny", m_box.m_x[1]);
+	element->SetDoubleAttribute( "maxy", m_box.m_x[4]);
+	element->SetDoubleAttribute( "step_over", m_step_over);
+	element->SetDoubleAttribute( "material_allowance", m_material_allowance);
+	element->SetDoubleAttribute( "resolution", m_resolution);
+}
+
+void CHeightmapRoughParams::ReadFromXMLElement(TiXmlElement* pElem)
+{
+	// get the attributes
+	pElem->Attribute("minx", &m_box.m_x[0]);
+	pElem->Attribute("maxx", &m_box.m_x[3]);
+	pElem->Attribute("miny", &m_box.m_x[1]);
+	pElem->Attribute("maxy", &m_box.m_x[4]);
+	pElem->Attribute("step_over", &m_step_over);
+	pElem->Attribute("material_allowance", &m_material_allowance);
+	pElem->Attribute("resolution", &m_resolution);
+}
+
+bool CHeightmapRoughParams::operator==( const CHeightmapRoughParams & rhs ) const
+{
+	if (m_box != rhs.m_box) return(false);
+	if (m_step_over != rhs.m_step_over) return(false);
+	if (m_material_allowance != rhs.m_material_allowance) return(false);
+	if (m_resolution != rhs.m_resolution) return(false);
+
+	return(true);
+}
+
+CHeightmapRough::CHeightmapRough(const std::list<int> &solids, const int tool_number)
+    :CDepthOp(GetTypeString(), NULL, tool_number, HeightmapRoughType), m_solids(solids)
+{
+	ReadDefaultValues();
+
+	// set m_box from the extents of the solids
+	for(std::list<int>::const_iterator It = solids.begin(); It != solids.end(); It++)
+	{
+		int solid = *It;
+		HeeksObj* object = heeksCAD->GetIDObject(SolidType, solid);
+		if(object)
+		{
+			if(object->GetType() == StlSolidType)
+			{
+				object->GetBox(m_params.m_box);
+			}
+			else
+			{
+				double extents[6];
+				if(heeksCAD->BodyGetExtents(object, extents))
+				{
+					m_params.m_box.Insert(CBox(extents));
+				}
+			}
+
+			Add(object, NULL);
+		}
+	}
+	m_solids.clear();
+
+	SetDepthOpParamsFromBox();
+}
+
+CHeightmapRough::CHeightmapRough( const CHeightmapRough & rhs ) : CDepthOp(rhs)
+{
+	m_solids.clear();
+	std::copy( rhs.m_solids.begin(), rhs.m_solids.end(), std::inserter( m_solids, m_solids.begin() ) );
+
+	m_params = rhs.m_params;
+}
+
+CHeightmapRough & CHeightmapRough::operator= ( const CHeightmapRough & rhs )
+{
+	if (this != &rhs)
+	{
+		CDepthOp::operator =(rhs);
+
+		m_solids.clear();
+		std::copy( rhs.m_solids.begin(), rhs.m_solids.end(), std::inserter( m_solids, m_solids.begin() ) );
+
+		m_params = rhs.m_params;
+	}
+
+	return(*this);
+}
+
+bool CHeightmapRough::operator==( const CHeightmapRough & rhs ) const
+{
+	if (m_params != rhs.m_params) return(false);
+
+	return(CDepthOp::operator==(rhs));
+}
+
+const wxBitmap &CHeightmapRough::GetIcon()
+{
+	static wxBitmap* icon = NULL;
+	if(icon == NULL)icon = new wxBitmap(wxImage(theApp.GetResFolder() + _T("/icons/pocket.png")));
+	return *icon;
+}
+
+/**
+	Convert any solid ids read from the file into child objects (see CZigZag::ReloadPointers())
+ */
+void CHeightmapRough::ReloadPointers()
+{
+	for (std::list<int>::iterator symbol = m_solids.begin(); symbol != m_solids.end(); symbol++)
+	{
+		HeeksObj *object = heeksCAD->GetIDObject( SolidType, *symbol );
+		if (object != NULL)
+		{
+			Add( object, NULL );
+		}
+	}
+
+	m_solids.clear();	// We don't want to convert them twice.
+
+	CDepthOp::ReloadPointers();
+}
+
+void CHeightmapRough::SetDepthOpParamsFromBox()
+{
+	m_depth_op_params.m_start_depth = m_params.m_box.MaxZ();
+	m_depth_op_params.ClearanceHeight( m_params.m_box.MaxZ() + 5.0 );
+	m_depth_op_params.m_final_depth = m_params.m_box.MinZ();
+	m_depth_op_params.m_rapid_safety_space = m_params.m_box.MaxZ() + 2.0;
+}
+
+Python CHeightmapRough::AppendTextToProgram(CMachineState *pMachineState)
+{
+	Python python;
+
+	ReloadPointers();   // Make sure all the solids in m_solids are included as child objects.
+
+	CTool *pTool = CTool::Find(m_tool_number);
+	if(pTool == NULL)
+	{
+		return(python);
+	}
+
+	python << CDepthOp::AppendTextToProgram(pMachineState);
+
+	// Gather the solids' triangles, rotated by the fixture settings.
+	double m[16];
+	CFixture::extract( CTessellation::FixtureMatrix( pMachineState->Fixture() ), m );
+
+	std::list<GTri> triangles;
+	for (HeeksObj *object = GetFirstChild(); object != NULL; object = GetNextChild())
+	{
+		if (object->GetType() != SolidType && object->GetType() != StlSolidType) continue;
+
+		const CTessellation::CMesh & mesh = CTessellation::Mesh( object, 0.01 );
+		for (std::vector<unsigned int>::size_type i=0; i + 2 < mesh.m_indices.size(); i += 3)
+		{
+			double x[9];
+			for (int j=0; j<3; j++)
+			{
+				const float *p = &mesh.m_vertices[mesh.m_indices[i + j] * 3];
+				x[j*3]   = m[0] * p[0] + m[1] * p[1] + m[2]  * p[2] + m[3];
+				x[j*3+1] = m[4] * p[0] + m[5] * p[1] + m[6]  * p[2] + m[7];
+				x[j*3+2] = m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11];
+			}
+			triangles.push_back( GTri(x) );
+		}
+	} // End for
+
+	// Rotate the box to align with the fixture.
+	gp_Pnt min = pMachineState->Fixture().Adjustment( gp_Pnt( m_params.m_box.m_x[0], m_params.m_box.m_x[1], m_params.m_box.m_x[2] ) );
+	gp_Pnt max = pMachineState->Fixture().Adjustment( gp_Pnt( m_params.m_box.m_x[3], m_params.m_box.m_x[4], m_params.m_box.m_x[5] ) );
+	double extents[6] = {	(min.X() < max.X()) ? min.X() : max.X(), (min.Y() < max.Y()) ? min.Y() : max.Y(), (min.Z() < max.Z()) ? min.Z() : max.Z(),
+							(min.X() < max.X()) ? max.X() : min.X(), (min.Y() < max.Y()) ? max.Y() : min.Y(), (min.Z() < max.Z()) ? max.Z() : min.Z() };
+	CBox box(extents);
+
+	const double floor = m_depth_op_params.m_final_depth - 1.0;
+	CHeightmap heightmap( TriangleGrid(triangles), box, m_params.m_resolution, floor );
+
+	// Step down from the start depth, pocketing the region that's below each level in one pass.
+	double units = theApp.m_program->m_units;
+	double previous_z = m_depth_op_params.m_start_depth;
+	while (previous_z > m_depth_op_params.m_final_depth)
+	{
+		double z = previous_z - m_depth_op_params.m_step_down;
+		if ((m_depth_op_params.m_step_down <= 0.0) || (z < m_depth_op_params.m_final_depth)) z = m_depth_op_params.m_final_depth;
+
+		CHeightmap::Loops_t loops;
+		heightmap.Contours( z - m_params.m_material_allowance, loops );
+
+		if (! loops.empty())
+		{
+			python << _T("a = area.Area()\n");
+			for (CHeightmap::Loops_t::const_iterator l_itLoop = loops.begin(); l_itLoop != loops.end(); l_itLoop++)
+			{
+				python << _T("c = area.Curve()\n");
+				for (CHeightmap::Loop_t::const_iterator l_itPoint = l_itLoop->begin(); l_itPoint != l_itLoop->end(); l_itPoint++)
+				{
+					python << _T("c.append(area.Vertex(0, area.Point(") << l_itPoint->first / units << _T(", ") << l_itPoint->second / units << _T("), area.Point(0, 0)))\n");
+				}
+				python << _T("c.append(area.Vertex(0, area.Point(") << l_itLoop->begin()->first / units << _T(", ") << l_itLoop->begin()->second / units << _T("), area.Point(0, 0)))\n");
+				python << _T("a.append(c)\n");
+			}
+
+			// reorder the area, the outside curves must be made anti-clockwise and the insides clockwise
+			python << _T("a.Reorder()\n");
+
+			python << _T("area_funcs.pocket(a, tool_diameter/2, ") << m_params.m_material_allowance / units;
+			python << _T(", rapid_safety_space, float(") << previous_z / units << _T("), float(") << z / units << _T("), ");
+			python << m_params.m_step_over / units;
+			python << _T(", float(") << (previous_z - z) / units << _T("), clearance, 0, False, False, 0, False)\n");
+		}
+
+		previous_z = z;
+	} // End while
+
+	// rapid back up to clearance plane
+	python << _T("rapid(z = clearance)\n");
+
+	return(python);
+}
+
+void CHeightmapRough::GetProperties(std::list<Property *> *list)
+{
+	AddSolidsProperties(list, this);
+	m_params.GetProperties(this, list);
+	CDepthOp::GetProperties(list);
+}
+
+HeeksObj *CHeightmapRough::MakeACopy(void)const
+{
+	return new CHeightmapRough(*this);
+}
+
+void CHeightmapRough::CopyFrom(const HeeksObj* object)
+{
+	operator=(*((CHeightmapRough*)object));
+}
+
+bool CHeightmapRough::CanAddTo(HeeksObj* owner)
+{
+	return ((owner != NULL) && (owner->GetType() == OperationsType));
+}
+
+bool CHeightmapRough::CanAdd(HeeksObj* object)
+{
+	if (object == NULL) return(false);
+
+	switch (object->GetType())
+	{
+	case StlSolidType:
+	case SolidType:
+	case FixtureType:
+		return(true);
+
+	default:
+		return(false);
+	}
+}
+
+void CHeightmapRough::WriteXML(TiXmlNode *root)
+{
+	TiXmlElement * element = heeksCAD->NewXMLElement( "HeightmapRough" );
+	heeksCAD->LinkXMLEndChild( root,  element );
+	m_params.WriteXMLAttributes(element);
+
+	// write solid ids
+	for (HeeksObj *object = GetFirstChild(); object != NULL; object = GetNextChild())
+	{
+		if (object->GetIDGroupType() != SolidType)continue;
+		int solid = object->GetID();
+		TiXmlElement * solid_element = heeksCAD->NewXMLElement( "solid" );
+		heeksCAD->LinkXMLEndChild( element, solid_element );
+		solid_element->SetAttribute("id", solid);
+	}
+
+	WriteBaseXML(element);
+}
+
+// static member function
+HeeksObj* CHeightmapRough::ReadFromXMLElement(TiXmlElement* element)
+{
+	CHeightmapRough* new_object = new CHeightmapRough;
+
+	std::list<TiXmlElement *> elements_to_remove;
+
+	// read solid ids
+	for(TiXmlElement* pElem = heeksCAD->FirstXMLChildElement( element ) ; pElem; pElem = pElem->NextSiblingElement())
+	{
+		std::string name(pElem->Value());
+		if(name == "params"){
+			new_object->m_params.ReadFromXMLElement(pElem);
+			elements_to_remove.push_back(pElem);
+		}
+		else if(name == "solid"){
+			for(TiXmlAttribute* a = pElem->FirstAttribute(); a; a = a->Next())
+			{
+				std::string name(a->Name());
+				if(name == "id"){
+					int id = a->IntValue();
+					new_object->m_solids.push_back(id);
+				}
+			}
+			elements_to_remove.push_back(pElem);
+		}
+	}
+
+	for (std::list<TiXmlElement*>::iterator itElem = elements_to_remove.begin(); itElem != elements_to_remove.end(); itElem++)
+	{
+		heeksCAD->RemoveXMLChild( element, *itElem);
+	}
+
+	new_object->ReadBaseXML(element);
+
+	return new_object;
+}
+
+void CHeightmapRough::WriteDefaultValues()
+{
+	CDepthOp::WriteDefaultValues();
+
+	CNCConfig config(ConfigScope());
+	config.Write(wxString(GetTypeString()) + _T("StepOver"), m_params.m_step_over);
+	config.Write(wxString(GetTypeString()) + _T("MatAllowance"), m_params.m_material_allowance);
+	config.Write(wxString(GetTypeString()) + _T("Resolution"), m_params.m_resolution);
+}
+
+void CHeightmapRough::ReadDefaultValues()
+{
+	CDepthOp::ReadDefaultValues();
+
+	CNCConfig config(ConfigScope());
+	config.Read(wxString(GetTypeString()) + _T("StepOver"), &m_params.m_step_over, 1.0);
+	config.Read(wxString(GetTypeString()) + _T("MatAllowance"), &m_params.m_material_allowance, 0.5);
+	config.Read(wxString(GetTypeString()) + _T("Resolution"), &m_params.m_resolution, 1.0);
+}
+
+static ReselectSolids reselect_solids;
+
+void CHeightmapRough::GetTools(std::list<Tool*>* t_list, const wxPoint* p)
+{
+	reselect_solids.m_solids = &m_solids;
+	reselect_solids.m_object = this;
+	t_list->push_back(&reselect_solids);
+
+	CDepthOp::GetTools( t_list, p );
+}
@@ -0,0 +1,98 @@
+// HeightmapRough.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include "DepthOp.h"
+#include "HeeksCNCTypes.h"
+
+#include <list>
+#include <vector>
+#include <utility>
+
+class CHeightmapRough;
+class TriangleGrid;
+
+/**
+	A grid of material heights sampled over the operation's box.  Each sample is the height at which a
+	flat cutter comes to rest on the triangles (using the DropCutter code).  The cutter is big enough
+	that the heights are never lower than the material anywhere the contours between the samples reach.
+ */
+class CHeightmap
+{
+public:
+	typedef std::vector< std::pair<double, double> > Loop_t;	// x,y points of one closed curve
+	typedef std::list<Loop_t> Loops_t;
+
+	CHeightmap( const TriangleGrid & triangles, const CBox & box, const double resolution, const double floor );
+
+	void Contours( const double z, Loops_t & loops ) const;
+
+private:
+	double m_x0, m_y0;
+	double m_resolution;
+	int m_columns, m_rows;
+	std::vector<double> m_heights;	// m_columns * m_rows samples, row by row
+
+	double Height( const int column, const int row ) const;
+	std::pair<double, double> Crossing( const long edge, const double z ) const;
+};
+
+class CHeightmapRoughParams{
+public:
+	CBox m_box; // z values ignored ( use start_depth, final_depth instead )
+	double m_step_over;
+	double m_material_allowance;
+	double m_resolution;	// spacing of the heightmap samples
+
+	void GetProperties(CHeightmapRough* parent, std::list<Property *> *list);
+	void WriteXMLAttributes(TiXmlNode* pElem);
+	void ReadFromXMLElement(TiXmlElement* pElem);
+
+	const wxString ConfigScope(void)const{return _T("HeightmapRough");}
+
+	bool operator==( const CHeightmapRoughParams & rhs ) const;
+	bool operator!=( const CHeightmapRoughParams & rhs ) const { return(! (*this == rhs)); }
+};
+
+/**
+	3D roughing without OpenCAMLib.  The solids are drop-cut once into a coarse heightmap and, for
+	each step down, the region where the material is below that level is contoured out of the
+	heightmap and pocketed with area_funcs.pocket().
+ */
+class CHeightmapRough: public CDepthOp{
+public:
+	std::list<int> m_solids;
+	CHeightmapRoughParams m_params;
+
+	CHeightmapRough():CDepthOp(GetTypeString(), 0, HeightmapRoughType){}
+	CHeightmapRough(const std::list<int> &solids, const int tool_number = -1);
+	CHeightmapRough( const CHeightmapRough & rhs );
+	CHeightmapRough & operator= ( const CHeightmapRough & rhs );
+
+	bool operator==( const CHeightmapRough & rhs ) const;
+	bool operator!=( const CHeightmapRough & rhs ) const { return(! (*this == rhs)); }
+
+	bool IsDifferent(HeeksObj *other) { return(*this != (*(CHeightmapRough *)other)); }
+
+	// HeeksObj's virtual functions
+	int GetType()const{return HeightmapRoughType;}
+	const wxChar* GetTypeString(void)const{return _T("HeightmapRough");}
+	const wxBitmap &GetIcon();
+	void GetProperties(std::list<Property *> *list);
+	HeeksObj *MakeACopy(void)const;
+	void CopyFrom(const HeeksObj* object);
+	void WriteXML(TiXmlNode *root);
+	bool CanAddTo(HeeksObj* owner);
+	bool CanAdd(HeeksObj* object);
+	void GetTools(std::list<Tool*>* t_list, const wxPoint* p);
+
+	void WriteDefaultValues();
+	void ReadDefaultValues();
+	Python AppendTextToProgram(CMachineState *pMachineState);
+	void ReloadPointers();
+	void SetDepthOpParamsFromBox();
+
+	static HeeksObj* ReadFromXMLElement(TiXmlElement* pElem);
+};
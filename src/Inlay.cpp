@@ -553,7 +553,168 @@ double CInlay::CornerAngle( const std::set<CNCVector> _vectors ) const
     made below this one.
  */
 
-CInlay::Corners_t CInlay::FindSimilarCorners( const CNCPoint coordinate, CInlay::Corners_t corners, const CTool *pChamferingBit ) const
+CInlay::CCornerIndex::CCornerIndex( const CInlay::Corners_t & corners )
+{
+	// Group the corners by depth in exactly the way that FindSimilarCorners() used to so
+	// that the same corner wins at each depth.
+	typedef std::map<CDouble, unsigned int> Depths_t;	// depth => index into m_depths
+	Depths_t depths;
+
+	for (Corners_t::const_iterator itCorner = corners.begin(); itCorner != corners.end(); itCorner++)
+	{
+		if (depths.insert(std::make_pair(CDouble(itCorner->first.Z()), (unsigned int) m_depths.size())).second)
+		{
+			m_depths.push_back( CDepth( (unsigned int) m_points.size(), itCorner->first.Z() ) );
+		}
+		m_points.push_back( itCorner->first );
+	} // End for
+
+	for (unsigned int i=0; i<m_points.size(); i++)
+	{
+		Depths_t::iterator itDepth = depths.find(CDouble(m_points[i].Z()));
+		if (itDepth == depths.end()) continue;
+
+		CDepth & depth = m_depths[itDepth->second];
+		if (depth.m_members.size() == 0)
+		{
+			depth.m_box[0] = depth.m_box[2] = m_points[i].X();
+			depth.m_box[1] = depth.m_box[3] = m_points[i].Y();
+		}
+		if (m_points[i].X() < depth.m_box[0]) depth.m_box[0] = m_points[i].X();
+		if (m_points[i].Y() < depth.m_box[1]) depth.m_box[1] = m_points[i].Y();
+		if (m_points[i].X() > depth.m_box[2]) depth.m_box[2] = m_points[i].X();
+		if (m_points[i].Y() > depth.m_box[3]) depth.m_box[3] = m_points[i].Y();
+		if (fabs(m_points[i].Z() - depth.m_z) > depth.m_dz) depth.m_dz = fabs(m_points[i].Z() - depth.m_z);
+		depth.m_members.push_back(i);
+	} // End for
+
+	// Aim for about one corner per cell.
+	for (std::vector<CDepth>::iterator itDepth = m_depths.begin(); itDepth != m_depths.end(); itDepth++)
+	{
+		if (itDepth->m_members.size() == 0) continue;
+
+		double width = itDepth->m_box[2] - itDepth->m_box[0];
+		double height = itDepth->m_box[3] - itDepth->m_box[1];
+		double largest = (width > height)?width:height;
+		itDepth->m_cell_size = largest / ceil(sqrt(double(itDepth->m_members.size())));
+		if (itDepth->m_cell_size < heeksCAD->GetTolerance()) itDepth->m_cell_size = heeksCAD->GetTolerance();
+
+		itDepth->m_columns = int(floor(width / itDepth->m_cell_size)) + 1;
+		itDepth->m_rows = int(floor(height / itDepth->m_cell_size)) + 1;
+		itDepth->m_cells.resize( itDepth->m_columns * itDepth->m_rows );
+
+		for (Members_t::const_iterator itMember = itDepth->m_members.begin(); itMember != itDepth->m_members.end(); itMember++)
+		{
+			const CNCPoint & point = m_points[*itMember];
+			itDepth->m_cells[ (itDepth->Row(point.Y()) * itDepth->m_columns) + itDepth->Column(point.X()) ].push_back(*itMember);
+		}
+	} // End for
+} // End constructor
+
+int CInlay::CCornerIndex::CDepth::Column( const double x ) const
+{
+	int column = int(floor((x - m_box[0]) / m_cell_size));
+	if (column < 0) column = 0;
+	if (column >= m_columns) column = m_columns - 1;
+	return(column);
+}
+
+int CInlay::CCornerIndex::CDepth::Row( const double y ) const
+{
+	int row = int(floor((y - m_box[1]) / m_cell_size));
+	if (row < 0) row = 0;
+	if (row >= m_rows) row = m_rows - 1;
+	return(row);
+}
+
+/**
+	Return the index of the corner at this depth that is closest to the line.  The corner that
+	first defined the depth is kept unless another is strictly closer and, of those that are
+	equally close, the first (in the Corners_t order) wins.
+
+	No corner can be closer to the line than its XY distance from where the line passes through
+	its depth multiplied by the Z component of the line's direction.  Once we have the distance to
+	any nearby corner, that limits the cells we need to look in.
+ */
+unsigned int CInlay::CCornerIndex::Closest( const gp_Lin & line, const CDepth & depth ) const
+{
+	unsigned int closest = depth.m_first;
+	double best = line.SquareDistance(m_points[closest]);
+
+	Members_t candidates;
+	double dz = fabs(line.Direction().Z());
+	if ((dz < 1e-6) || (depth.m_members.size() == 0))
+	{
+		candidates = depth.m_members;
+	}
+	else
+	{
+		// Where the line passes through this depth.
+		double t = (depth.m_z - line.Location().Z()) / line.Direction().Z();
+		double x = line.Location().X() + (t * line.Direction().X());
+		double y = line.Location().Y() + (t * line.Direction().Y());
+
+		// Measure the corners in the nearest occupied ring of cells to tighten the bound.
+		int column = depth.Column(x);
+		int row = depth.Row(y);
+		bool found = false;
+		int rings = (depth.m_columns > depth.m_rows)?depth.m_columns:depth.m_rows;
+		for (int ring = 0; (! found) && (ring <= rings); ring++)
+		{
+			for (int r = row - ring; r <= row + ring; r++)
+			{
+				if ((r < 0) || (r >= depth.m_rows)) continue;
+				for (int c = column - ring; c <= column + ring; c++)
+				{
+					if ((c < 0) || (c >= depth.m_columns)) continue;
+					if ((abs(r - row) != ring) && (abs(c - column) != ring)) continue;	// Inside this ring.
+
+					const Members_t & cell = depth.m_cells[(r * depth.m_columns) + c];
+					for (Members_t::const_iterator itMember = cell.begin(); itMember != cell.end(); itMember++)
+					{
+						double distance = line.SquareDistance(m_points[*itMember]);
+						if (distance < best) best = distance;
+						found = true;
+					}
+				} // End for
+			} // End for
+		} // End for
+
+		double radius = (sqrt(best) / dz) + (depth.m_dz * sqrt(1.0 - (dz * dz)) / dz) + heeksCAD->GetTolerance();
+		for (int r = depth.Row(y - radius); r <= depth.Row(y + radius); r++)
+		{
+			for (int c = depth.Column(x - radius); c <= depth.Column(x + radius); c++)
+			{
+				const Members_t & cell = depth.m_cells[(r * depth.m_columns) + c];
+				for (Members_t::const_iterator itMember = cell.begin(); itMember != cell.end(); itMember++)
+				{
+					const CNCPoint & point = m_points[*itMember];
+					if ((((point.X() - x) * (point.X() - x)) + ((point.Y() - y) * (point.Y() - y))) <= (radius * radius))
+					{
+						candidates.push_back(*itMember);
+					}
+				}
+			} // End for
+		} // End for
+
+		std::sort(candidates.begin(), candidates.end());
+		best = line.SquareDistance(m_points[closest]);
+	} // End if - else
+
+	for (Members_t::const_iterator itCandidate = candidates.begin(); itCandidate != candidates.end(); itCandidate++)
+	{
+		double distance = line.SquareDistance(m_points[*itCandidate]);
+		if (distance < best)
+		{
+			best = distance;
+			closest = *itCandidate;
+		}
+	} // End for
+
+	return(closest);
+} // End Closest() method
+
+CInlay::Corners_t CInlay::FindSimilarCorners( const CNCPoint coordinate, const CInlay::Corners_t & corners, const CInlay::CCornerIndex & index, const CTool *pChamferingBit ) const
 {
 	/*
 	// Test cases.
@@ -599,23 +760,16 @@ CInlay::Corners_t CInlay::FindSimilarCorners( const CNCPoint coordinate, CInlay:
 	*/
 
 	Corners_t results;
-	typedef std::map<CDouble, CNCPoint > ClosestVertices_t;
-	ClosestVertices_t closest_vertices;
 
-	if (corners.find(coordinate) == corners.end())
+	Corners_t::const_iterator itCoordinate = corners.find(coordinate);
+	if (itCoordinate == corners.end())
 	{
 		return(results);	// Empty set.
 	}
 
-	// Get a distinct set of depth values from all the valley lines.
-	for (Corners_t::iterator itCorner = corners.begin(); itCorner != corners.end(); itCorner++)
-	{
-		closest_vertices.insert(std::make_pair(itCorner->first.Z(), itCorner->first));
-	} // End for
-
-	if (corners[coordinate].size() == 2)
+	if (itCoordinate->second.size() == 2)
 	{
-		double reference_angle = CornerAngle(corners[coordinate]);
+		double reference_angle = CornerAngle(itCoordinate->second);
 
 		// This reference_angle is the angle of the line coming from the corner half way
 		// between the two connected edges.  i.e. it bisects the angle formed by the
@@ -662,25 +816,11 @@ CInlay::Corners_t CInlay::FindSimilarCorners( const CNCPoint coordinate, CInlay:
 
 		gp_Lin cutting_line(s, gp_Dir(gp_Vec(s, e)));
 
-		// Now see how far the other coordinates are away from this line.
-		for (Corners_t::iterator itCorner = corners.begin(); itCorner != corners.end(); itCorner++)
-		{
-			CNCPoint coordinate(itCorner->first);
-			double distance = cutting_line.SquareDistance(itCorner->first);
-
-			CNCPoint previous_coordinate(closest_vertices[itCorner->first.Z()]);
-			double previous_distance = cutting_line.SquareDistance(previous_coordinate);
-
-			if (distance < previous_distance)
-			{
-				closest_vertices[CDouble(itCorner->first.Z())] = itCorner->first;
-			}
-		} // End for
-
-		for (ClosestVertices_t::iterator itClosestVertex = closest_vertices.begin(); itClosestVertex != closest_vertices.end();
-				itClosestVertex++)
+		// Now find the coordinate closest to this line at each depth.
+		for (std::vector<CCornerIndex::CDepth>::const_iterator itDepth = index.m_depths.begin(); itDepth != index.m_depths.end(); itDepth++)
 		{
-			results.insert(std::make_pair(itClosestVertex->second, corners[itClosestVertex->second]));
+			const CNCPoint & closest = index.m_points[index.Closest(cutting_line, *itDepth)];
+			results.insert(std::make_pair(closest, corners.find(closest)->second));
 		}
 	} // End if - then
 
@@ -816,6 +956,7 @@ Python CInlay::FormCorners( Valley_t & paths, CMachineState *pMachineState ) con
 	// We now have all the coordinates and vectors of all the edges in the wire.  Look at
     // each coordinate, discard duplicate vectors and find the angle between the two
     // vectors formed at each coordinate.
+	CCornerIndex index(corners);
 
     gp_Vec reference( 0, 0, -1 );    // Looking from the top down.
     for (SortedCoordinates_t::iterator itCoordinate = sorted_coordinates.begin(); itCoordinate != sorted_coordinates.end(); itCoordinate++)
@@ -830,7 +971,7 @@ Python CInlay::FormCorners( Valley_t & paths, CMachineState *pMachineState ) con
 
 		if (corners[*itCoordinate].size() == 2)
 		{
-			Corners_t similar = FindSimilarCorners(*itCoordinate, corners, CTool::Find(pMachineState->Tool()));
+			Corners_t similar = FindSimilarCorners(*itCoordinate, corners, index, CTool::Find(pMachineState->Tool()));
 
 			// We don't want to form corners on two intersecting edges if the angle of intersection
             // is too shallow.  i.e. if there are two lines that are mostly pointing in the same
@@ -894,7 +1035,8 @@ Python CInlay::FormCorners( Valley_t & paths, CMachineState *pMachineState ) con
 
 			// Rapid into place first.
 			python << _T("comment(") << PythonString(_("sharpen corner")) << _T(")\n");
-			python << _T("rapid(z=") << this->m_depth_op_params.ClearanceHeight() / theApp.m_program->m_units << _T(")\n");
+			double link_height = pMachineState->LinkHeight(bottom_corner, this->m_depth_op_params.m_rapid_safety_space, this->m_depth_op_params.ClearanceHeight());
+			python << _T("rapid(z=") << link_height / theApp.m_program->m_units << _T(")\n");
 			python << _T("rapid(x=") << bottom_corner.X(true) << _T(", y=") << bottom_corner.Y(true) << _T(")\n");
 			python << _T("rapid(x=") << bottom_corner.X(true) << _T(", y=") << bottom_corner.Y(true) << _T(", z=") << this->m_depth_op_params.m_rapid_safety_space / theApp.m_program->m_units << _T(")\n");
 			python << _T("feed(x=") << bottom_corner.X(true) << _T(", y=") << bottom_corner.Y(true) << _T(", z=") << bottom_corner.Z(true) << _T(")\n");
@@ -943,20 +1085,15 @@ CInlay::Valleys_t CInlay::DefineValleys(CMachineState *pMachineState)
 		}
 
 	    // Convert them to a list of wire objects.
-		std::list<TopoDS_Shape> wires;
-		if (heeksCAD->ConvertSketchToFaceOrWire( object, wires, false))
+		const std::list<TopoDS_Shape> *wires = theApp.m_program->m_sketch_wires.Wires( object );
+		if (wires != NULL)
 		{
 			// The wire(s) represent the sketch objects for a tool path.
 			try {
 			    // For all wires in this sketch...
-				for(std::list<TopoDS_Shape>::iterator It2 = wires.begin(); It2 != wires.end(); It2++)
+				for(std::list<TopoDS_Shape>::const_iterator It2 = wires->begin(); It2 != wires->end(); It2++)
 				{
-					TopoDS_Shape& wire_to_fix = *It2;
-					ShapeFix_Wire fix;
-					fix.Load( TopoDS::Wire(wire_to_fix) );
-					fix.FixReorder();
-
-					TopoDS_Shape wire = fix.Wire();
+					TopoDS_Shape wire = *It2;	// already reordered
 
 					// DO NOT align wires with the fixture YET.  When we form
 					// the corners, we will assume the wires are all in the XY plane.
@@ -1236,10 +1373,70 @@ bool CInlay::CutterBoundary( TopoDS_Wire original, const double cutter_radius, T
 
 
 
+/**
+	Subtract the rhs face from the lhs face.  Both faces are flat and at the same height so
+	cut the faces themselves rather than the solids made by extruding them.  This keeps
+	OpenCascade's boolean operation in two dimensions.  It only returns false if OpenCascade
+	could not do this, in which case FaceMinusFace() goes back to using the extruded solids.
+ */
+bool CInlay::PlanarFaceMinusFace( const TopoDS_Face lhs, const TopoDS_Face rhs, const double z_height, std::vector<TopoDS_Wire> & results ) const
+{
+	try {
+		BRepAlgoAPI_Cut cut( lhs, rhs );
+		cut.Build();
+		if (! cut.IsDone()) return(false);
+
+		for (TopExp_Explorer expFace(cut.Shape(), TopAbs_FACE); expFace.More(); expFace.Next())
+		{
+			TopoDS_Face aFace = TopoDS::Face(expFace.Current());
+
+			// Only trust the cut if every face it gives is flat, horizontal and at z_height.
+			Handle(Geom_Surface) aSurface = BRep_Tool::Surface(aFace);
+			if (aSurface->DynamicType() != STANDARD_TYPE(Geom_Plane))
+			{
+				results.clear();
+				return(false);
+			}
+
+			gp_Pln plane = Handle(Geom_Plane)::DownCast(aSurface)->Pln();
+			if ((! plane.Axis().Direction().IsParallel( gp_Dir(0,0,1), 0.0001 )) ||
+				(fabs(plane.Location().Z() - z_height) > 0.0001))
+			{
+				results.clear();
+				return(false);
+			}
+
+			TopoDS_Wire wire=BRepTools::OuterWire(aFace);
+
+			Bnd_Box box;
+			BRepBndLib::Add(wire, box);
+			double bounds[6];
+			box.Get(bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5]);
+			if ((bounds[5] > (z_height + 0.0001) + box.GetGap()) ||
+				(bounds[2] < (z_height - 0.0001) - box.GetGap()))
+			{
+				results.clear();
+				return(false);
+			}
+
+			results.push_back(wire);
+		}
+
+		return(true);
+	}
+	catch (Standard_Failure) {
+		Handle_Standard_Failure e = Standard_Failure::Caught();
+		results.clear();
+		return(false);
+	}
+} // End PlanarFaceMinusFace() method
+
 std::vector<TopoDS_Wire> CInlay::FaceMinusFace( const TopoDS_Face lhs, const TopoDS_Face rhs, const double z_height ) const
 {
 	std::vector<TopoDS_Wire> results;
 
+	if (PlanarFaceMinusFace( lhs, rhs, z_height, results )) return(results);
+
 	TopoDS_Shape shape;
     TopoDS_Shape lhs_shape = BRepPrimAPI_MakePrism(lhs, gp_Vec(0,0,1));
     TopoDS_Shape rhs_shape = BRepPrimAPI_MakePrism(rhs, gp_Vec(0,0,1));
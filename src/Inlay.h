@@ -19,6 +19,7 @@
 #include "CNCPoint.h"
 #include <TopoDS_Wire.hxx>
 #include <TopoDS_Edge.hxx>
+#include <gp_Lin.hxx>
 
 
 class CInlay;
@@ -234,6 +235,44 @@ public:
 
 	typedef std::map<CNCPoint, std::set<CNCVector> > Corners_t;
 
+	/**
+		The corners gathered by FormCorners() grouped by depth (in the same way as FindSimilarCorners()
+		always has) and then bucketed into a grid of XY cells within each depth.  This lets
+		FindSimilarCorners() measure only those corners that are near enough to its cutting line
+		rather than every corner at every depth.
+	 */
+	class CCornerIndex
+	{
+	public:
+		typedef std::vector<unsigned int> Members_t;	// Indices into m_points, in ascending order.
+
+		class CDepth
+		{
+		public:
+			CDepth( const unsigned int first, const double z ) : m_first(first), m_z(z), m_dz(0.0), m_columns(0), m_rows(0), m_cell_size(1.0) { }
+
+			unsigned int m_first;	// The corner that first defined this depth.
+			double m_z;
+			double m_dz;			// Furthest any member is (in Z) from m_z
+			Members_t m_members;
+			std::vector<Members_t> m_cells;
+			double m_box[4];		// min x, min y, max x, max y
+			int m_columns;
+			int m_rows;
+			double m_cell_size;
+
+			int Column( const double x ) const;
+			int Row( const double y ) const;
+		}; // End CDepth class definition.
+
+		CCornerIndex( const Corners_t & corners );
+
+		unsigned int Closest( const gp_Lin & line, const CDepth & depth ) const;
+
+		std::vector<CNCPoint> m_points;	// In the same order as the Corners_t map.
+		std::vector<CDepth> m_depths;
+	}; // End CCornerIndex class definition.
+
 public:
 	//	These are references to the CAD elements whose position indicate where the Drilling Cycle begins.
 	//	If the m_params.m_sort_drilling_locations is false then the order of symbols in this list should
@@ -312,7 +351,7 @@ public:
 	static bool DirectionTowarardsNextEdge( const TopoDS_Edge &from, const TopoDS_Edge &to );
 	static double FindMaxOffset( const double max_offset_required, TopoDS_Wire wire, const double tolerance );
 	Python FormCorners( Valley_t & paths, CMachineState *pMachineState ) const;
-	Corners_t FindSimilarCorners( const CNCPoint coordinate, Corners_t corners, const CTool *pChamferingBit ) const;
+	Corners_t FindSimilarCorners( const CNCPoint coordinate, const Corners_t & corners, const CCornerIndex & index, const CTool *pChamferingBit ) const;
 	double CornerAngle( const std::set<CNCVector> _vectors ) const;
 
 	Valleys_t DefineValleys(CMachineState *pMachineState);
@@ -326,6 +365,7 @@ public:
 	Python FormMountainCrevices( Valleys_t valleys, CMachineState *pMachineState  );
 	bool CutterBoundary( TopoDS_Wire original, const double cutter_radius, TopoDS_Wire &result  ) const;
 	std::vector<TopoDS_Wire> FaceMinusFace( const TopoDS_Face lhs, const TopoDS_Face rhs, const double z_height ) const;
+	bool PlanarFaceMinusFace( const TopoDS_Face lhs, const TopoDS_Face rhs, const double z_height, std::vector<TopoDS_Wire> & results ) const;
 	void AddShapeToBoundingBox( TopoDS_Shape shape, CBox & box ) const;
 	CBox GetBoundingBoxForMountains(Valleys_t valleys, CMachineState *pMachineState);
 	bool DistanceBetweenWires( const TopoDS_Wire lhs, const TopoDS_Wire rhs, double *pResult ) const;
@@ -0,0 +1,712 @@
+// IsoCreator.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+// This file is also built into the 'nciso' Python extension so it deliberately
+// doesn't include stdafx.h (and so doesn't use precompiled headers either).
+
+#include "IsoCreator.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+	Format.string() from nc/format.py.  Python's str() of a float gives 12 significant
+	digits, which is what "%.12g" gives too.  The digits after the decimal point are
+	truncated rather than rounded.  Only values that would round to zero are written as '0'.
+	Python sometimes keeps trailing zeros in the mantissa of numbers written with an
+	exponent (1e11 and up), which isn't copied here.
+ */
+std::string CIsoCreator::CFormat::String( const double number ) const
+{
+	double f = number * pow(10.0, m_number_of_decimal_places);
+	if (f < 0) f = f - 0.5;
+	else f = f + 0.5;
+	if (fabs(f) < 1.0) return("0");
+
+	// Python switches to an exponent from 1e11 on, one power of ten sooner than "%.12g" does.
+	char buffer[64];
+	sprintf(buffer, "%.11e", number);
+	char *exponent = strchr(buffer, 'e');
+	if ((exponent != NULL) && (atoi(exponent + 1) == 11))
+	{
+		char *mantissa_end = exponent;
+		while (*(mantissa_end - 1) == '0') mantissa_end--;
+		if (*(mantissa_end - 1) == '.') mantissa_end--;
+		memmove(mantissa_end, exponent, strlen(exponent) + 1);
+	}
+	else
+	{
+		sprintf(buffer, "%.12g", number);
+	}
+	std::string s(buffer);
+
+	std::string::size_type dot = s.find('.');
+	if (dot == std::string::npos) return(s);
+
+	std::string before_dp = s.substr(0, dot);
+	std::string after_dp = s.substr(dot + 1, m_number_of_decimal_places);
+	while ((after_dp.size() > 0) && (after_dp[after_dp.size() - 1] == '0')) after_dp.erase(after_dp.size() - 1);
+
+	if (after_dp.size() == 0) return(before_dp);
+	return(before_dp + "." + after_dp);
+} // End String() method
+
+CIsoCreator::CIsoCreator( const eDialect_t dialect ) : m_dialect(dialect), m_file(NULL), m_fmt(3), m_ffmt(2)
+{
+	m_n = 10;
+	m_x = m_y = m_a = m_b = m_c = 0.0;
+	m_z = 500.0;
+	m_absolute_flag = true;
+
+	m_fhv = false;
+	m_fh = m_fv = 0.0;
+
+	m_tool_number = -1;
+}
+
+CIsoCreator::~CIsoCreator()
+{
+	FileClose();
+}
+
+bool CIsoCreator::FileOpen( const char *file_name )
+{
+	FileClose();
+	m_file = fopen(file_name, "w");
+	return(m_file != NULL);
+}
+
+void CIsoCreator::FileClose()
+{
+	if (m_file != NULL)
+	{
+		fclose(m_file);
+		m_file = NULL;
+	}
+}
+
+void CIsoCreator::Write( const std::string & text )
+{
+	if (m_file != NULL) fwrite(text.data(), 1, text.size(), m_file);
+	else m_output += text;
+}
+
+std::string CIsoCreator::FeedrateCode() const
+{
+	// nc/iso.py never defines FEEDRATE() (so its feedrate() fails) but nc/emc2.py does.
+	if (m_dialect == eEmc2) return("  F");
+	return("F");
+}
+
+std::string CIsoCreator::CommentText( const std::string & text ) const
+{
+	if (m_dialect == eIso) return("(" + text + ")");
+
+	// Replace any embedded round brackets with curly braces so that the EMC2 GCode
+	// interpreter will not have trouble with the nested comment format.
+	std::string comment(text);
+	for (std::string::iterator l_itChar = comment.begin(); l_itChar != comment.end(); l_itChar++)
+	{
+		if (*l_itChar == '(') *l_itChar = '{';
+		else if (*l_itChar == ')') *l_itChar = '}';
+	}
+	return("(" + comment + ")");
+}
+
+void CIsoCreator::WriteBlockNumber()
+{
+	char buffer[32];
+	sprintf(buffer, "N%i ", m_n);
+	Write(buffer);
+	m_n += 10;
+}
+
+void CIsoCreator::WritePreps()
+{
+	if ((m_plane.size() > 0) && (m_plane != m_previous_plane))
+	{
+		Write(" " + m_plane);
+		m_previous_plane = m_plane;
+	}
+	m_plane.clear();
+
+	// nc/iso.py writes each of these codes after a 'G' of its own.
+	for (std::vector<std::string>::iterator l_itG = m_g_list.begin(); l_itG != m_g_list.end(); l_itG++)
+	{
+		Write(" G" + *l_itG);
+	}
+	m_g_list.clear();
+}
+
+void CIsoCreator::WriteMisc()
+{
+	// Only the most recent one is written.  Any others wait for later blocks.
+	if (m_m.size() > 0)
+	{
+		Write(m_m.back());
+		m_m.pop_back();
+	}
+}
+
+void CIsoCreator::WriteSpindle()
+{
+	if (m_s.size() > 0)
+	{
+		Write(" " + m_s);
+		m_s.clear();
+	}
+}
+
+/**
+	Write one address of a move and remember where that axis ends up.
+ */
+void CIsoCreator::WriteAxis( const char *address, const double *value, double & current )
+{
+	if (value == NULL) return;
+	Write(std::string(" ") + address + m_fmt.String(m_absolute_flag ? *value : (*value - current)));
+	current = *value;
+}
+
+void CIsoCreator::CalcFeedrateHV( const double h, const double v )
+{
+	if (fabs(v) > fabs(h * 2))
+	{
+		m_f = " " + FeedrateCode() + m_ffmt.String(m_fv);
+	}
+	else
+	{
+		m_f = " " + FeedrateCode() + m_ffmt.String(m_fh);
+	}
+}
+
+bool CIsoCreator::SameXYZ( const double *x, const double *y, const double *z ) const
+{
+	if ((x != NULL) && (m_fmt.String(*x) != m_fmt.String(m_x))) return(false);
+	if ((y != NULL) && (m_fmt.String(*y) != m_fmt.String(m_y))) return(false);
+	if ((z != NULL) && (m_fmt.String(*z) != m_fmt.String(m_z))) return(false);
+	return(true);
+}
+
+void CIsoCreator::WriteInBraces( const char *prefix, const std::string & text )
+{
+	if (m_dialect == eIso) return;	// nc/iso.py ignores these messages.
+
+	std::string comment = CommentText(text);
+	WriteBlockNumber();
+	Write("(" + std::string(prefix) + comment.substr(1));
+	Write("\n");
+}
+
+void CIsoCreator::ProgramBegin( const int id, const std::string & name )
+{
+	if (m_dialect == eEmc2)
+	{
+		Write("(" + name + ")\n");
+		WriteBlockNumber();
+		Write("G49\t(Ensure tool length compensation is OFF)\n");
+		WriteBlockNumber();
+		Write("G92.1\t(Ensure no temporary coordinate systems are in effect)\n");
+		return;
+	}
+
+	char buffer[32];
+	sprintf(buffer, "O%i ", id);
+	Write(buffer + CommentText(name) + "\n");
+}
+
+void CIsoCreator::ProgramStop( const bool optional )
+{
+	WriteBlockNumber();
+	if (optional) Write(" M01\n");
+	else Write("M00\n");
+}
+
+void CIsoCreator::ProgramEnd()
+{
+	WriteBlockNumber();
+	Write(" M02\n");
+}
+
+void CIsoCreator::FlushNC()
+{
+	if ((m_g_list.size() == 0) && (m_m.size() == 0)) return;
+	WriteBlockNumber();
+	WritePreps();
+	WriteMisc();
+	Write("\n");
+}
+
+void CIsoCreator::SubBegin( const int id, const std::string & name )
+{
+	char buffer[32];
+	sprintf(buffer, "O%i ", id);
+	Write(buffer + CommentText(name) + "\n");
+
+	// A subroutine can be called from anywhere so don't rely on any modal codes from before it.
+	ResetModal();
+}
+
+void CIsoCreator::SubCall( const int id )
+{
+	char buffer[32];
+	sprintf(buffer, " M98 P%i\n", id);
+	WriteBlockNumber();
+	Write(buffer);
+
+	// Nor rely on those left behind by it.
+	ResetModal();
+}
+
+void CIsoCreator::ResetModal()
+{
+	m_previous_plane.clear();
+}
+
+void CIsoCreator::SubEnd()
+{
+	WriteBlockNumber();
+	Write(" M99\n");
+}
+
+void CIsoCreator::Imperial()
+{
+	if (m_dialect == eEmc2)
+	{
+		WriteBlockNumber();
+		Write("G20\t (Imperial Values)\n");
+	}
+	else
+	{
+		m_g_list.push_back("G20");
+	}
+	m_fmt.m_number_of_decimal_places = 4;
+}
+
+void CIsoCreator::Metric()
+{
+	if (m_dialect == eEmc2)
+	{
+		WriteBlockNumber();
+		Write("G21\t (Metric Values)\n");
+	}
+	else
+	{
+		m_g_list.push_back("G21");
+	}
+	m_fmt.m_number_of_decimal_places = 3;
+}
+
+void CIsoCreator::Absolute()
+{
+	if (m_dialect == eEmc2)
+	{
+		// nc/emc2.py doesn't change its absolute flag.
+		WriteBlockNumber();
+		Write("G90\t (Absolute Coordinates)\n");
+		return;
+	}
+
+	m_g_list.push_back("G90");
+	m_absolute_flag = true;
+}
+
+void CIsoCreator::Incremental()
+{
+	if (m_dialect == eEmc2)
+	{
+		WriteBlockNumber();
+		Write("G91\t (Incremental Coordinates)\n");
+		return;
+	}
+
+	m_g_list.push_back("G91");
+	m_absolute_flag = false;
+}
+
+void CIsoCreator::Polar( const bool on )
+{
+	if (m_dialect == eEmc2)
+	{
+		WriteBlockNumber();
+		if (on) Write("G16\t (Polar ON)\n");
+		else Write("G15\t (Polar OFF)\n");
+		return;
+	}
+
+	m_g_list.push_back(on ? "G16" : "G15");
+}
+
+void CIsoCreator::SetPlane( const int plane )
+{
+	const char *codes[] = { "G17", "G18", "G19" };
+	const char *descriptions[] = { "\t (Select XY Plane)\n", "\t (Select XZ Plane)\n", "\t (Select YZ Plane)\n" };
+	if ((plane < 0) || (plane > 2)) return;
+
+	if (m_dialect == eEmc2)
+	{
+		WriteBlockNumber();
+		Write(std::string(codes[plane]) + descriptions[plane]);
+		return;
+	}
+
+	// nc/iso.py fails here.  Write the code with the next move (and only when it changes) as it intended.
+	m_plane = codes[plane];
+}
+
+void CIsoCreator::SetTemporaryOrigin( const double *x, const double *y, const double *z, const double *a, const double *b, const double *c )
+{
+	WriteBlockNumber();
+	Write(" G92");
+	if (x != NULL) Write(" X " + m_fmt.String(*x));
+	if (y != NULL) Write(" Y " + m_fmt.String(*y));
+	if (z != NULL) Write(" Z " + m_fmt.String(*z));
+	if (a != NULL) Write(" A " + m_fmt.String(*a));
+	if (b != NULL) Write(" B " + m_fmt.String(*b));
+	if (c != NULL) Write(" C " + m_fmt.String(*c));
+	Write("\n");
+}
+
+void CIsoCreator::RemoveTemporaryOrigin()
+{
+	WriteBlockNumber();
+	Write(" G92.1\n");
+}
+
+void CIsoCreator::ToolChange( const int id, const char *description )
+{
+	if (description != NULL) Message(description);
+
+	char buffer[32];
+	sprintf(buffer, " T%i M06\n", id);
+	WriteBlockNumber();
+	Write(buffer);
+	m_tool_number = id;
+}
+
+void CIsoCreator::PredefinedPosition( const std::string & type )
+{
+	WriteBlockNumber();
+	Write(" " + type + " (Move to the predefined position)\n");
+}
+
+void CIsoCreator::ToolDefn( const int id, const double *radius, const double *length )
+{
+	if (m_dialect == eEmc2) return;
+
+	char buffer[64];
+	WriteBlockNumber();
+	sprintf(buffer, " G10 L1 P%i ", id);
+	Write(buffer);
+	if (radius != NULL)
+	{
+		sprintf(buffer, " R%.3f", *radius);
+		Write(buffer);
+	}
+	if (length != NULL)
+	{
+		sprintf(buffer, " Z%.3f", *length);
+		Write(buffer);
+	}
+	Write("\n");
+}
+
+/**
+	This is the coordinate system we're using.  G54->G59, G59.1, G59.2, G59.3
+	These are selected by values from 1 to 9 inclusive.
+ */
+void CIsoCreator::Workplane( const int id )
+{
+	char buffer[32];
+	if ((id >= 1) && (id <= 6))
+	{
+		sprintf(buffer, "G%i", id + 53);
+	}
+	else if ((id >= 7) && (id <= 9))
+	{
+		sprintf(buffer, "G59.%i", id - 6);
+	}
+	else return;
+
+	WriteBlockNumber();
+	Write(std::string(buffer) + "\t (Select Relative Coordinate System)\n");
+}
+
+void CIsoCreator::Feedrate( const double f )
+{
+	m_f = " " + FeedrateCode() + m_ffmt.String(f);
+	m_fhv = false;
+}
+
+void CIsoCreator::FeedrateHV( const double fh, const double fv )
+{
+	m_fh = fh;
+	m_fv = fv;
+	m_fhv = true;
+	CalcFeedrateHV(fh, fv);
+}
+
+void CIsoCreator::Spindle( const double s, const bool clockwise )
+{
+	m_s = "S" + m_ffmt.String(s);
+	if (s > 0.0) m_s += clockwise ? " M03" : " M04";
+	else m_s += clockwise ? " M04" : " M03";
+}
+
+void CIsoCreator::Coolant( const int mode )
+{
+	if (mode <= 0) m_m.push_back(" M09");
+	else if (mode == 1) m_m.push_back(" M07");
+	else if (mode == 2) m_m.push_back(" M08");
+}
+
+void CIsoCreator::Rapid( const double *x, const double *y, const double *z, const double *a, const double *b, const double *c, const bool machine_coordinates )
+{
+	WriteBlockNumber();
+	if (machine_coordinates) Write("G53 ");
+	Write("G00");
+	WritePreps();
+	WriteAxis("X", x, m_x);
+	WriteAxis("Y", y, m_y);
+	WriteAxis("Z", z, m_z);
+	WriteAxis("A", a, m_a);
+	WriteAxis("B", b, m_b);
+	WriteAxis("C", c, m_c);
+	WriteSpindle();
+	WriteMisc();
+	Write("\n");
+}
+
+void CIsoCreator::Feed( const double *x, const double *y, const double *z )
+{
+	if (SameXYZ(x, y, z)) return;
+
+	double dx = (x == NULL) ? 0.0 : (*x - m_x);
+	double dy = (y == NULL) ? 0.0 : (*y - m_y);
+	double dz = (z == NULL) ? 0.0 : (*z - m_z);
+
+	WriteBlockNumber();
+	Write("G01");
+	WritePreps();
+	WriteAxis("X", x, m_x);
+	WriteAxis("Y", y, m_y);
+	WriteAxis("Z", z, m_z);
+	if (m_fhv) CalcFeedrateHV(sqrt(dx*dx + dy*dy), fabs(dz));
+	WriteFeedrate();
+	WriteSpindle();
+	WriteMisc();
+	Write("\n");
+}
+
+/**
+	The arc's centre is given in absolute coordinates and written relative to its start point.
+ */
+void CIsoCreator::Arc( const bool cw, const double *x, const double *y, const double *z, const double *i, const double *j, const double *k, const double *r )
+{
+	WriteBlockNumber();
+	Write(cw ? "G02" : "G03");
+	WritePreps();
+
+	// The end point is only remembered once the centre has been written relative to the start point.
+	double end_x = m_x, end_y = m_y, end_z = m_z;
+	WriteAxis("X", x, end_x);
+	WriteAxis("Y", y, end_y);
+	WriteAxis("Z", z, end_z);
+	if (i != NULL) Write(" I" + m_fmt.String(*i - m_x));
+	if (j != NULL) Write(" J" + m_fmt.String(*j - m_y));
+	if (k != NULL) Write(" K" + m_fmt.String(*k - m_z));
+	if (r != NULL) Write(" R" + m_fmt.String(*r));
+
+	// use horizontal feed rate
+	if (m_fhv) CalcFeedrateHV(1, 0);
+	WriteFeedrate();
+	WriteSpindle();
+	WriteMisc();
+	Write("\n");
+
+	m_x = end_x;
+	m_y = end_y;
+	m_z = end_z;
+}
+
+void CIsoCreator::NurbsBeginDefinition( const double *degree, const double *x, const double *y, const double *weight )
+{
+	if (m_dialect == eIso) return;	// Only nc/emc2.py supports NURBS.
+	if ((degree == NULL) || (x == NULL) || (y == NULL) || (weight == NULL)) return;
+
+	WriteBlockNumber();
+	Write("G5.2");
+	Write(" L" + m_fmt.String(*degree + 1));
+	Write(" X" + m_fmt.String(*x));
+	Write(" Y" + m_fmt.String(*y));
+	Write(" P" + m_fmt.String(*weight));
+	Write("\n");
+}
+
+void CIsoCreator::NurbsAddPole( const double *x, const double *y, const double *weight )
+{
+	if (m_dialect == eIso) return;
+	if ((x == NULL) || (y == NULL) || (weight == NULL)) return;
+
+	WriteBlockNumber();
+	Write(" X" + m_fmt.String(*x) + " ");
+	Write(" Y" + m_fmt.String(*y) + " ");
+	Write(" P" + m_fmt.String(*weight));
+	Write("\n");
+}
+
+void CIsoCreator::NurbsEndDefinition()
+{
+	if (m_dialect == eIso) return;
+
+	WriteBlockNumber();
+	Write("G5.3\n");
+}
+
+void CIsoCreator::Dwell( const double t )
+{
+	// nc/iso.py fails here (its TIME() code has no format specifier) so write the dwell time as a P word.
+	WriteBlockNumber();
+	WritePreps();
+	Write("G04 P" + m_ffmt.String(t));
+	WriteMisc();
+	Write("\n");
+}
+
+void CIsoCreator::SetMachineCoordinates()
+{
+	Write(" G53");
+}
+
+bool CIsoCreator::StartCRC( const bool left )
+{
+	if (m_tool_number < 0) return(false);
+
+	char buffer[128];
+	WriteBlockNumber();
+	if (m_dialect == eEmc2)
+	{
+		sprintf(buffer, "%s D%i\t (start %s cutter radius compensation)\n", left ? "G41" : "G42", m_tool_number, left ? "left" : "right");
+	}
+	else
+	{
+		sprintf(buffer, " %s D%i\n", left ? "G41" : "G42", m_tool_number);
+	}
+	Write(buffer);
+	return(true);
+}
+
+void CIsoCreator::EndCRC()
+{
+	WriteBlockNumber();
+	if (m_dialect == eEmc2)
+	{
+		// Like nc/emc2.py, which never writes its G40, only the comment.
+		WritePreps();
+		WriteMisc();
+		Write("\t (end cutter radius compensation)\n");
+		return;
+	}
+
+	Write(" G40\n");
+}
+
+/**
+	The drill routine supports drilling (G81) and peck drilling (G83).
+
+	The x,y,z values are INITIAL locations (above the hole to be made).  This routine combines
+	the z value and the depth value to determine the bottom of the hole.  The standoff value
+	is the distance up from the z value where the bit retracts to.  Missing depth, dwell and
+	peck_depth values are taken as zero.
+
+	As in nc/iso.py, a drill cycle with a dwell (G82) is only written in modal drilling mode,
+	which neither dialect uses, so such holes get no cycle code of their own.
+ */
+void CIsoCreator::Drill( const double *x, const double *y, const double *z, const double *depth, const double *standoff, const double *dwell, const double *peck_depth, const double *clearance_height )
+{
+	// All the drilling cycles need a retraction (and starting) height and the top of the hole.
+	if ((standoff == NULL) || (z == NULL)) return;
+	if (clearance_height == NULL) clearance_height = standoff;
+
+	Rapid(x, y, NULL);
+	Rapid(NULL, NULL, standoff);
+	WritePreps();
+	WriteBlockNumber();
+
+	if ((peck_depth != NULL) && (*peck_depth != 0.0))
+	{
+		Write(" G83  Q" + m_fmt.String(*peck_depth));
+	}
+	else if ((dwell == NULL) || (*dwell == 0.0))
+	{
+		Write(" G81");
+	}
+
+	double retract_height = *z + *standoff;
+	if (x != NULL)
+	{
+		Write(" X" + m_fmt.String(*x));
+		m_x = *x;
+	}
+	if (y != NULL)
+	{
+		Write(" Y" + m_fmt.String(*y));
+		m_y = *y;
+	}
+
+	// This is the z value for the bottom of the hole but we remember the top of the hole.
+	Write(" Z" + m_fmt.String(*z - ((depth == NULL) ? 0.0 : *depth)));
+	m_z = retract_height;
+	Write("  R" + m_fmt.String(retract_height));
+	WriteFeedrate();
+	WriteSpindle();
+	WriteMisc();
+	Write("\n");
+
+	Rapid(NULL, NULL, clearance_height);
+}
+
+void CIsoCreator::EndCannedCycle()
+{
+	WriteBlockNumber();
+	Write(" G80\n");
+}
+
+void CIsoCreator::Comment( const std::string & text )
+{
+	if (m_dialect == eEmc2) WriteBlockNumber();
+	Write(CommentText(text) + "\n");
+}
+
+void CIsoCreator::VariableSet( const int id, const double value )
+{
+	char buffer[64];
+	sprintf(buffer, " #%i =%.3f\n", id, value);
+	WriteBlockNumber();
+	Write(buffer);
+}
+
+/**
+	nc/emc2.py takes the variable and its value as strings (expressions are allowed).
+ */
+void CIsoCreator::VariableSet( const std::string & id, const std::string & value )
+{
+	WriteBlockNumber();
+	Write("#" + id + " = " + value + "\n");
+}
+
+void CIsoCreator::Message( const std::string & text )
+{
+	WriteInBraces("MSG,", text);
+}
+
+void CIsoCreator::DebugMessage( const std::string & text )
+{
+	WriteInBraces("DEBUG,", text);
+}
+
+void CIsoCreator::LogMessage( const std::string & text )
+{
+	WriteInBraces("LOG,", text);
+}
@@ -0,0 +1,159 @@
+// IsoCreator.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+/**
+	The CIsoCreator class writes the same G-code as the nc/iso.py and nc/emc2.py post-processors
+	without going through Python for every move.  Its methods mirror those of nc.Creator, one for
+	one, and produce exactly the same text (including the oddities of the Python versions) so that
+	the two can be diffed against each other.  Arguments that are optional (None) in Python are
+	passed as NULL pointers.
+
+	It uses nothing from wxWidgets or OpenCASCADE.  It's only built into the 'nciso' Python
+	extension (IsoCreatorModule.cpp) used by nc/iso_native.py and nc/emc2_native.py, since
+	HeeksCNC itself writes Python rather than G-code.  test/nciso_check.py diffs its output
+	against iso.py and emc2.py.
+ */
+class CIsoCreator
+{
+public:
+	typedef enum
+	{
+		eIso = 0,
+		eEmc2
+	} eDialect_t;
+
+	/**
+		Same as format.Format with its default settings.  The number is written as Python's str()
+		would, truncated (not rounded) to the number of decimal places and with trailing zeros removed.
+	 */
+	class CFormat
+	{
+	public:
+		CFormat( const int number_of_decimal_places ) : m_number_of_decimal_places(number_of_decimal_places) { }
+
+		std::string String( const double number ) const;
+
+		int m_number_of_decimal_places;
+	}; // End CFormat class definition.
+
+	CIsoCreator( const eDialect_t dialect = eIso );
+	~CIsoCreator();
+
+	eDialect_t Dialect() const { return(m_dialect); }
+	double X() const { return(m_x); }
+	double Y() const { return(m_y); }
+	double Z() const { return(m_z); }
+
+	// Internals
+	bool FileOpen( const char *file_name );
+	void FileClose();
+	void Write( const std::string & text );
+	const std::string & Output() const { return(m_output); }	// Everything written while no file was open.
+
+	// Programs
+	void ProgramBegin( const int id, const std::string & name );
+	void ProgramStop( const bool optional = false );
+	void ProgramEnd();
+	void FlushNC();
+
+	// Subprograms
+	void SubBegin( const int id, const std::string & name );
+	void SubCall( const int id );
+	void SubEnd();
+	void ResetModal();
+
+	// Settings
+	void Imperial();
+	void Metric();
+	void MachineUnitsMetric( const bool is_metric ) { }	// Only the probing routines (not written here) need to know.
+	void Absolute();
+	void Incremental();
+	void Polar( const bool on = true );
+	void SetPlane( const int plane );
+	void SetTemporaryOrigin( const double *x, const double *y, const double *z, const double *a, const double *b, const double *c );
+	void RemoveTemporaryOrigin();
+
+	// Tools
+	void ToolChange( const int id, const char *description = NULL );
+	void PredefinedPosition( const std::string & type );
+	void ToolDefn( const int id, const double *radius, const double *length );
+	void Workplane( const int id );
+
+	// Rates + Modes
+	void Feedrate( const double f );
+	void FeedrateHV( const double fh, const double fv );
+	void Spindle( const double s, const bool clockwise = true );
+	void Coolant( const int mode = 0 );
+
+	// Moves
+	void Rapid( const double *x, const double *y, const double *z, const double *a = NULL, const double *b = NULL, const double *c = NULL, const bool machine_coordinates = false );
+	void Feed( const double *x, const double *y, const double *z );
+	void Arc( const bool cw, const double *x, const double *y, const double *z, const double *i, const double *j, const double *k, const double *r );
+	void NurbsBeginDefinition( const double *degree, const double *x, const double *y, const double *weight );
+	void NurbsAddPole( const double *x, const double *y, const double *weight );
+	void NurbsEndDefinition();
+	void Dwell( const double t );
+	void SetMachineCoordinates();
+
+	// Cutter radius compensation
+	bool StartCRC( const bool left = true );	// Returns false if no tool has been selected yet.
+	void EndCRC();
+
+	// Cycles
+	void Drill( const double *x, const double *y, const double *z, const double *depth, const double *standoff, const double *dwell, const double *peck_depth, const double *clearance_height );
+	void EndCannedCycle();
+
+	// Misc
+	void Comment( const std::string & text );
+	void VariableSet( const int id, const double value );
+	void VariableSet( const std::string & id, const std::string & value );
+	void Message( const std::string & text );
+	void DebugMessage( const std::string & text );
+	void LogMessage( const std::string & text );
+
+private:
+	// Codes that differ between the dialects.
+	std::string FeedrateCode() const;
+	std::string CommentText( const std::string & text ) const;
+
+	void WriteBlockNumber();
+	void WritePreps();
+	void WriteMisc();
+	void WriteSpindle();
+	void WriteFeedrate() { Write(m_f); }
+	void WriteAxis( const char *address, const double *value, double & current );
+	void CalcFeedrateHV( const double h, const double v );
+	bool SameXYZ( const double *x, const double *y, const double *z ) const;
+	void WriteInBraces( const char *prefix, const std::string & text );
+
+	eDialect_t m_dialect;
+
+	FILE *m_file;
+	std::string m_output;
+
+	CFormat m_fmt;		// Coordinates.  3 decimal places for metric and 4 for imperial.
+	CFormat m_ffmt;		// Feed rates and spindle speeds.
+
+	int m_n;			// Next block number
+	double m_x, m_y, m_z, m_a, m_b, m_c;
+	bool m_absolute_flag;
+
+	std::string m_f;	// Feed rate, written with every feed move.
+	bool m_fhv;
+	double m_fh, m_fv;
+
+	std::string m_plane;			// Pending plane selection, written only when it changes.
+	std::string m_previous_plane;
+	std::vector<std::string> m_g_list;
+	std::vector<std::string> m_m;
+	std::string m_s;				// Pending spindle speed and direction.
+
+	int m_tool_number;				// -1 until the first tool change.
+}; // End CIsoCreator class definition.
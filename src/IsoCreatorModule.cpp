@@ -0,0 +1,648 @@
+// IsoCreatorModule.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+// The 'nciso' Python extension.  Its Creator type has the same methods as nc.Creator and
+// passes them straight on to a CIsoCreator so that nc/iso_native.py and nc/emc2_native.py
+// can write the same G-code as nc/iso.py and nc/emc2.py without running them in Python.
+
+#include <Python.h>	// This needs to be above any of the standard template library files.
+#include "IsoCreator.h"
+
+typedef struct
+{
+	PyObject_HEAD
+	CIsoCreator *m_creator;
+} CreatorObject;
+
+/**
+	Convert an optional Python number.  None (or a missing argument) becomes a NULL pointer.
+ */
+static bool Optional( PyObject *object, double *value, const double **pointer )
+{
+	*pointer = NULL;
+	if ((object == NULL) || (object == Py_None)) return(true);
+
+	*value = PyFloat_AsDouble(object);
+	if ((*value == -1.0) && (PyErr_Occurred() != NULL)) return(false);
+	*pointer = value;
+	return(true);
+}
+
+static bool IsTrue( PyObject *object, const bool default_value )
+{
+	if ((object == NULL) || (object == Py_None)) return(default_value);
+	return(PyObject_IsTrue(object) == 1);
+}
+
+static void Creator_dealloc( CreatorObject *self )
+{
+	delete self->m_creator;
+	self->ob_type->tp_free((PyObject *) self);
+}
+
+static PyObject *Creator_new( PyTypeObject *type, PyObject *args, PyObject *kwds )
+{
+	CreatorObject *self = (CreatorObject *) type->tp_alloc(type, 0);
+	if (self != NULL) self->m_creator = new CIsoCreator();
+	return((PyObject *) self);
+}
+
+static int Creator_init( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "dialect", NULL };
+	int dialect = int(CIsoCreator::eIso);
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &dialect)) return(-1);
+	if ((dialect != int(CIsoCreator::eIso)) && (dialect != int(CIsoCreator::eEmc2)))
+	{
+		PyErr_SetString(PyExc_ValueError, "dialect must be nciso.ISO or nciso.EMC2");
+		return(-1);
+	}
+
+	delete self->m_creator;
+	self->m_creator = new CIsoCreator(CIsoCreator::eDialect_t(dialect));
+	return(0);
+}
+
+// Internals
+
+static PyObject *Creator_file_open( CreatorObject *self, PyObject *args )
+{
+	const char *name = NULL;
+	if (! PyArg_ParseTuple(args, "s", &name)) return(NULL);
+	if (! self->m_creator->FileOpen(name)) return(PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *) name));
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_file_close( CreatorObject *self )
+{
+	self->m_creator->FileClose();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_write( CreatorObject *self, PyObject *args )
+{
+	const char *text = NULL;
+	int length = 0;
+	if (! PyArg_ParseTuple(args, "s#", &text, &length)) return(NULL);
+	self->m_creator->Write(std::string(text, length));
+	Py_RETURN_NONE;
+}
+
+// Programs
+
+static PyObject *Creator_program_begin( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "id", (char *) "name", NULL };
+	int id = 0;
+	const char *name = "";
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|s", kwlist, &id, &name)) return(NULL);
+	self->m_creator->ProgramBegin(id, name);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_program_stop( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "optional", NULL };
+	PyObject *optional = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &optional)) return(NULL);
+	self->m_creator->ProgramStop(IsTrue(optional, false));
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_program_end( CreatorObject *self )
+{
+	self->m_creator->ProgramEnd();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_flush_nc( CreatorObject *self )
+{
+	self->m_creator->FlushNC();
+	Py_RETURN_NONE;
+}
+
+// Subprograms
+
+static PyObject *Creator_sub_begin( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "id", (char *) "name", NULL };
+	int id = 0;
+	const char *name = "";
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|s", kwlist, &id, &name)) return(NULL);
+	self->m_creator->SubBegin(id, name);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_sub_call( CreatorObject *self, PyObject *args )
+{
+	int id = 0;
+	if (! PyArg_ParseTuple(args, "i", &id)) return(NULL);
+	self->m_creator->SubCall(id);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_sub_end( CreatorObject *self )
+{
+	self->m_creator->SubEnd();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_reset_modal( CreatorObject *self )
+{
+	self->m_creator->ResetModal();
+	Py_RETURN_NONE;
+}
+
+// Settings
+
+static PyObject *Creator_imperial( CreatorObject *self )
+{
+	self->m_creator->Imperial();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_metric( CreatorObject *self )
+{
+	self->m_creator->Metric();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_machine_units_metric( CreatorObject *self, PyObject *args )
+{
+	PyObject *is_metric = NULL;
+	if (! PyArg_ParseTuple(args, "O", &is_metric)) return(NULL);
+	self->m_creator->MachineUnitsMetric(IsTrue(is_metric, false));
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_absolute( CreatorObject *self )
+{
+	self->m_creator->Absolute();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_incremental( CreatorObject *self )
+{
+	self->m_creator->Incremental();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_polar( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "on", NULL };
+	PyObject *on = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &on)) return(NULL);
+	self->m_creator->Polar(IsTrue(on, true));
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_set_plane( CreatorObject *self, PyObject *args )
+{
+	int plane = 0;
+	if (! PyArg_ParseTuple(args, "i", &plane)) return(NULL);
+	self->m_creator->SetPlane(plane);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_set_temporary_origin( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "x", (char *) "y", (char *) "z", (char *) "a", (char *) "b", (char *) "c", NULL };
+	PyObject *objects[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|OOOOOO", kwlist, &objects[0], &objects[1], &objects[2], &objects[3], &objects[4], &objects[5])) return(NULL);
+
+	double values[6];
+	const double *pointers[6];
+	for (int i = 0; i < 6; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	self->m_creator->SetTemporaryOrigin(pointers[0], pointers[1], pointers[2], pointers[3], pointers[4], pointers[5]);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_remove_temporary_origin( CreatorObject *self )
+{
+	self->m_creator->RemoveTemporaryOrigin();
+	Py_RETURN_NONE;
+}
+
+// Tools
+
+static PyObject *Creator_tool_change( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "id", (char *) "description", NULL };
+	int id = 0;
+	const char *description = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|z", kwlist, &id, &description)) return(NULL);
+	self->m_creator->ToolChange(id, description);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_predefined_position( CreatorObject *self, PyObject *args )
+{
+	const char *type = NULL;
+	if (! PyArg_ParseTuple(args, "s", &type)) return(NULL);
+	self->m_creator->PredefinedPosition(type);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_tool_defn( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "id", (char *) "name", (char *) "radius", (char *) "length", (char *) "gradient", NULL };
+	int id = 0;
+	PyObject *name = NULL, *radius = NULL, *length = NULL, *gradient = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "i|OOOO", kwlist, &id, &name, &radius, &length, &gradient)) return(NULL);
+
+	double radius_value, length_value;
+	const double *pRadius, *pLength;
+	if (! Optional(radius, &radius_value, &pRadius)) return(NULL);
+	if (! Optional(length, &length_value, &pLength)) return(NULL);
+	self->m_creator->ToolDefn(id, pRadius, pLength);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_workplane( CreatorObject *self, PyObject *args )
+{
+	int id = 0;
+	if (! PyArg_ParseTuple(args, "i", &id)) return(NULL);
+	self->m_creator->Workplane(id);
+	Py_RETURN_NONE;
+}
+
+// Rates + Modes
+
+static PyObject *Creator_feedrate( CreatorObject *self, PyObject *args )
+{
+	double f = 0.0;
+	if (! PyArg_ParseTuple(args, "d", &f)) return(NULL);
+	self->m_creator->Feedrate(f);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_feedrate_hv( CreatorObject *self, PyObject *args )
+{
+	double fh = 0.0, fv = 0.0;
+	if (! PyArg_ParseTuple(args, "dd", &fh, &fv)) return(NULL);
+	self->m_creator->FeedrateHV(fh, fv);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_spindle( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "s", (char *) "clockwise", NULL };
+	double s = 0.0;
+	PyObject *clockwise = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "d|O", kwlist, &s, &clockwise)) return(NULL);
+	self->m_creator->Spindle(s, IsTrue(clockwise, true));
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_coolant( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "mode", NULL };
+	int mode = 0;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &mode)) return(NULL);
+	self->m_creator->Coolant(mode);
+	Py_RETURN_NONE;
+}
+
+// Moves
+
+static PyObject *Creator_rapid( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "x", (char *) "y", (char *) "z", (char *) "a", (char *) "b", (char *) "c", (char *) "machine_coordinates", NULL };
+	PyObject *objects[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+	PyObject *machine_coordinates = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|OOOOOOO", kwlist, &objects[0], &objects[1], &objects[2], &objects[3], &objects[4], &objects[5], &machine_coordinates)) return(NULL);
+
+	double values[6];
+	const double *pointers[6];
+	for (int i = 0; i < 6; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	self->m_creator->Rapid(pointers[0], pointers[1], pointers[2], pointers[3], pointers[4], pointers[5], IsTrue(machine_coordinates, false));
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_feed( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "x", (char *) "y", (char *) "z", NULL };
+	PyObject *objects[3] = { NULL, NULL, NULL };
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|OOO", kwlist, &objects[0], &objects[1], &objects[2])) return(NULL);
+
+	double values[3];
+	const double *pointers[3];
+	for (int i = 0; i < 3; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	self->m_creator->Feed(pointers[0], pointers[1], pointers[2]);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Arc( CreatorObject *self, const bool cw, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "x", (char *) "y", (char *) "z", (char *) "i", (char *) "j", (char *) "k", (char *) "r", NULL };
+	PyObject *objects[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|OOOOOOO", kwlist, &objects[0], &objects[1], &objects[2], &objects[3], &objects[4], &objects[5], &objects[6])) return(NULL);
+
+	double values[7];
+	const double *pointers[7];
+	for (int i = 0; i < 7; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	self->m_creator->Arc(cw, pointers[0], pointers[1], pointers[2], pointers[3], pointers[4], pointers[5], pointers[6]);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_arc_cw( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	return(Arc(self, true, args, kwds));
+}
+
+static PyObject *Creator_arc_ccw( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	return(Arc(self, false, args, kwds));
+}
+
+static PyObject *Creator_nurbs_begin_definition( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "id", (char *) "degree", (char *) "x", (char *) "y", (char *) "weight", NULL };
+	PyObject *id = NULL;
+	PyObject *objects[4] = { NULL, NULL, NULL, NULL };
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "O|OOOO", kwlist, &id, &objects[0], &objects[1], &objects[2], &objects[3])) return(NULL);
+
+	double values[4];
+	const double *pointers[4];
+	for (int i = 0; i < 4; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	self->m_creator->NurbsBeginDefinition(pointers[0], pointers[1], pointers[2], pointers[3]);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_nurbs_add_pole( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "id", (char *) "x", (char *) "y", (char *) "weight", NULL };
+	PyObject *id = NULL;
+	PyObject *objects[3] = { NULL, NULL, NULL };
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "O|OOO", kwlist, &id, &objects[0], &objects[1], &objects[2])) return(NULL);
+
+	double values[3];
+	const double *pointers[3];
+	for (int i = 0; i < 3; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	self->m_creator->NurbsAddPole(pointers[0], pointers[1], pointers[2]);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_nurbs_end_definition( CreatorObject *self, PyObject *args )
+{
+	PyObject *id = NULL;
+	if (! PyArg_ParseTuple(args, "O", &id)) return(NULL);
+	self->m_creator->NurbsEndDefinition();
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_dwell( CreatorObject *self, PyObject *args )
+{
+	double t = 0.0;
+	if (! PyArg_ParseTuple(args, "d", &t)) return(NULL);
+	self->m_creator->Dwell(t);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_set_machine_coordinates( CreatorObject *self )
+{
+	self->m_creator->SetMachineCoordinates();
+	Py_RETURN_NONE;
+}
+
+// Cutter radius compensation
+
+static PyObject *Creator_use_CRC( CreatorObject *self )
+{
+	Py_RETURN_FALSE;
+}
+
+static PyObject *Creator_CRC_nominal_path( CreatorObject *self )
+{
+	Py_RETURN_FALSE;
+}
+
+static PyObject *Creator_start_CRC( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "left", (char *) "radius", NULL };
+	PyObject *left = NULL;
+	double radius = 0.0;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|Od", kwlist, &left, &radius)) return(NULL);
+	if (! self->m_creator->StartCRC(IsTrue(left, true)))
+	{
+		PyErr_SetString(PyExc_RuntimeError, "No tool specified for start_CRC()");
+		return(NULL);
+	}
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_end_CRC( CreatorObject *self )
+{
+	self->m_creator->EndCRC();
+	Py_RETURN_NONE;
+}
+
+// Cycles
+
+static PyObject *Creator_drill( CreatorObject *self, PyObject *args, PyObject *kwds )
+{
+	static char *kwlist[] = { (char *) "x", (char *) "y", (char *) "z", (char *) "depth", (char *) "standoff", (char *) "dwell", (char *) "peck_depth", (char *) "retract_mode", (char *) "spindle_mode", (char *) "clearance_height", NULL };
+	PyObject *objects[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	PyObject *retract_mode = NULL, *spindle_mode = NULL, *clearance_height = NULL;
+	if (! PyArg_ParseTupleAndKeywords(args, kwds, "|OOOOOOOOOO", kwlist, &objects[0], &objects[1], &objects[2], &objects[3], &objects[4], &objects[5], &objects[6], &retract_mode, &spindle_mode, &clearance_height)) return(NULL);
+
+	double values[8];
+	const double *pointers[8];
+	for (int i = 0; i < 7; i++)
+	{
+		if (! Optional(objects[i], &values[i], &pointers[i])) return(NULL);
+	}
+	if (! Optional(clearance_height, &values[7], &pointers[7])) return(NULL);
+
+	self->m_creator->Drill(pointers[0], pointers[1], pointers[2], pointers[3], pointers[4], pointers[5], pointers[6], pointers[7]);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_end_canned_cycle( CreatorObject *self )
+{
+	self->m_creator->EndCannedCycle();
+	Py_RETURN_NONE;
+}
+
+// Misc
+
+static PyObject *Creator_comment( CreatorObject *self, PyObject *args )
+{
+	const char *text = NULL;
+	if (! PyArg_ParseTuple(args, "s", &text)) return(NULL);
+	self->m_creator->Comment(text);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_variable_set( CreatorObject *self, PyObject *args )
+{
+	PyObject *id = NULL, *value = NULL;
+	if (! PyArg_ParseTuple(args, "OO", &id, &value)) return(NULL);
+
+	if (PyString_Check(id))
+	{
+		// A variable name and an expression, as used by nc/emc2.py.
+		PyObject *text = PyObject_Str(value);
+		if (text == NULL) return(NULL);
+		self->m_creator->VariableSet(std::string(PyString_AsString(id)), std::string(PyString_AsString(text)));
+		Py_DECREF(text);
+		Py_RETURN_NONE;
+	}
+
+	long number = PyInt_AsLong(id);
+	if ((number == -1) && (PyErr_Occurred() != NULL)) return(NULL);
+	double number_value = PyFloat_AsDouble(value);
+	if ((number_value == -1.0) && (PyErr_Occurred() != NULL)) return(NULL);
+	self->m_creator->VariableSet(int(number), number_value);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Message( CreatorObject *self, PyObject *args, void (CIsoCreator::*method)( const std::string & ) )
+{
+	const char *text = NULL;
+	if (! PyArg_ParseTuple(args, "|z", &text)) return(NULL);
+	if (text != NULL) (self->m_creator->*method)(text);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Creator_message( CreatorObject *self, PyObject *args )
+{
+	return(Message(self, args, &CIsoCreator::Message));
+}
+
+static PyObject *Creator_debug_message( CreatorObject *self, PyObject *args )
+{
+	return(Message(self, args, &CIsoCreator::DebugMessage));
+}
+
+static PyObject *Creator_log_message( CreatorObject *self, PyObject *args )
+{
+	return(Message(self, args, &CIsoCreator::LogMessage));
+}
+
+// The current position, read by nc/attach.py.
+
+static PyObject *Creator_get_x( CreatorObject *self, void *closure )
+{
+	return(PyFloat_FromDouble(self->m_creator->X()));
+}
+
+static PyObject *Creator_get_y( CreatorObject *self, void *closure )
+{
+	return(PyFloat_FromDouble(self->m_creator->Y()));
+}
+
+static PyObject *Creator_get_z( CreatorObject *self, void *closure )
+{
+	return(PyFloat_FromDouble(self->m_creator->Z()));
+}
+
+static PyGetSetDef Creator_getset[] =
+{
+	{ (char *) "x", (getter) Creator_get_x, NULL, NULL, NULL },
+	{ (char *) "y", (getter) Creator_get_y, NULL, NULL, NULL },
+	{ (char *) "z", (getter) Creator_get_z, NULL, NULL, NULL },
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+#define NOARGS(name) { #name, (PyCFunction) Creator_##name, METH_NOARGS, NULL }
+#define VARARGS(name) { #name, (PyCFunction) Creator_##name, METH_VARARGS, NULL }
+#define KEYWORDS(name) { #name, (PyCFunction) Creator_##name, METH_VARARGS | METH_KEYWORDS, NULL }
+
+static PyMethodDef Creator_methods[] =
+{
+	VARARGS(file_open), NOARGS(file_close), VARARGS(write),
+	KEYWORDS(program_begin), KEYWORDS(program_stop), NOARGS(program_end), NOARGS(flush_nc),
+	KEYWORDS(sub_begin), VARARGS(sub_call), NOARGS(sub_end), NOARGS(reset_modal),
+	NOARGS(imperial), NOARGS(metric), VARARGS(machine_units_metric), NOARGS(absolute), NOARGS(incremental),
+	KEYWORDS(polar), VARARGS(set_plane), KEYWORDS(set_temporary_origin), NOARGS(remove_temporary_origin),
+	KEYWORDS(tool_change), VARARGS(predefined_position), KEYWORDS(tool_defn), VARARGS(workplane),
+	VARARGS(feedrate), VARARGS(feedrate_hv), KEYWORDS(spindle), KEYWORDS(coolant),
+	KEYWORDS(rapid), KEYWORDS(feed), KEYWORDS(arc_cw), KEYWORDS(arc_ccw),
+	KEYWORDS(nurbs_begin_definition), KEYWORDS(nurbs_add_pole), VARARGS(nurbs_end_definition),
+	VARARGS(dwell), NOARGS(set_machine_coordinates),
+	NOARGS(use_CRC), NOARGS(CRC_nominal_path), KEYWORDS(start_CRC), NOARGS(end_CRC),
+	KEYWORDS(drill), NOARGS(end_canned_cycle),
+	VARARGS(comment), VARARGS(variable_set), VARARGS(message), VARARGS(debug_message), VARARGS(log_message),
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject CreatorType =
+{
+	PyObject_HEAD_INIT(NULL)
+	0,										// ob_size
+	"nciso.Creator",						// tp_name
+	sizeof(CreatorObject),					// tp_basicsize
+	0,										// tp_itemsize
+	(destructor) Creator_dealloc,			// tp_dealloc
+	0,										// tp_print
+	0,										// tp_getattr
+	0,										// tp_setattr
+	0,										// tp_compare
+	0,										// tp_repr
+	0,										// tp_as_number
+	0,										// tp_as_sequence
+	0,										// tp_as_mapping
+	0,										// tp_hash
+	0,										// tp_call
+	0,										// tp_str
+	0,										// tp_getattro
+	0,										// tp_setattro
+	0,										// tp_as_buffer
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,	// tp_flags
+	"ISO or EMC2 G-code creator",			// tp_doc
+	0,										// tp_traverse
+	0,										// tp_clear
+	0,										// tp_richcompare
+	0,										// tp_weaklistoffset
+	0,										// tp_iter
+	0,										// tp_iternext
+	Creator_methods,						// tp_methods
+	0,										// tp_members
+	Creator_getset,							// tp_getset
+	0,										// tp_base
+	0,										// tp_dict
+	0,										// tp_descr_get
+	0,										// tp_descr_set
+	0,										// tp_dictoffset
+	(initproc) Creator_init,				// tp_init
+	0,										// tp_alloc
+	Creator_new,							// tp_new
+};
+
+static PyMethodDef module_methods[] =
+{
+	{ NULL, NULL, 0, NULL }
+};
+
+PyMODINIT_FUNC initnciso(void)
+{
+	if (PyType_Ready(&CreatorType) < 0) return;
+
+	PyObject *module = Py_InitModule3("nciso", module_methods, "Native ISO and EMC2 G-code creator");
+	if (module == NULL) return;
+
+	Py_INCREF(&CreatorType);
+	PyModule_AddObject(module, "Creator", (PyObject *) &CreatorType);
+	PyModule_AddIntConstant(module, "ISO", int(CIsoCreator::eIso));
+	PyModule_AddIntConstant(module, "EMC2", int(CIsoCreator::eEmc2));
+}
@@ -0,0 +1,144 @@
+// LinkPlanner.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "LinkPlanner.h"
+#include "Program.h"
+#include "CNCConfig.h"
+#include "interface/HeeksObj.h"
+
+#include <math.h>
+
+void CLinkPlanner::FindObstacles( HeeksObj *parent )
+{
+	if (parent == NULL) return;
+
+	for (HeeksObj *object = parent->GetFirstChild(); object != NULL; object = parent->GetNextChild())
+	{
+		if ((object->GetType() == SolidType) || (object->GetType() == StlSolidType))
+		{
+			CBox box;
+			object->GetBox(box);
+			if (box.m_valid) m_solid_boxes.push_back(box);
+		}
+		else if (object->GetType() != ProgramType)
+		{
+			FindObstacles( object );
+		}
+	} // End for
+} // End FindObstacles() method
+
+/**
+	Return the bounding boxes of all the solids once they've been moved to suit this fixture.
+ */
+const CLinkPlanner::Obstacles_t & CLinkPlanner::Obstacles( CFixture & fixture )
+{
+	if (! m_obstacles_found)
+	{
+		CNCConfig config(CProgram::ConfigScope());
+		config.Read(_T("LinkClearance"), &m_margin, 2.0);
+
+		FindObstacles( heeksCAD->GetMainObject() );
+		m_obstacles_found = true;
+	}
+
+	std::map<CFixture::eCoordinateSystemNumber_t, Obstacles_t>::iterator l_itObstacles = m_obstacles.find(fixture.m_coordinate_system_number);
+	if (l_itObstacles != m_obstacles.end()) return(l_itObstacles->second);
+
+	Obstacles_t & obstacles = m_obstacles[fixture.m_coordinate_system_number];
+	for (Obstacles_t::const_iterator l_itBox = m_solid_boxes.begin(); l_itBox != m_solid_boxes.end(); l_itBox++)
+	{
+		// The fixture may rotate the solid so move all eight corners and box them up again.
+		CBox adjusted;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			gp_Pnt point( l_itBox->m_x[(corner & 1)?3:0], l_itBox->m_x[(corner & 2)?4:1], l_itBox->m_x[(corner & 4)?5:2] );
+			point = fixture.Adjustment(point);
+
+			double xyz[3] = { point.X(), point.Y(), point.Z() };
+			adjusted.Insert(xyz);
+		}
+
+		obstacles.push_back(adjusted);
+	} // End for
+
+	return(obstacles);
+} // End Obstacles() method
+
+/**
+	Returns true if a tool of this radius would pass over the box (in the XY plane ONLY) while
+	moving in a straight line between the two points.  The box is grown by the tool's radius
+	and the line is clipped against it.
+ */
+/* static */ bool CLinkPlanner::Crosses( const CNCPoint & from, const CNCPoint & to, const CBox & box, const double tool_radius )
+{
+	double start[2] = { from.X(), from.Y() };
+	double delta[2] = { to.X() - from.X(), to.Y() - from.Y() };
+	double minimum[2] = { box.MinX() - tool_radius, box.MinY() - tool_radius };
+	double maximum[2] = { box.MaxX() + tool_radius, box.MaxY() + tool_radius };
+
+	double enter = 0.0;
+	double leave = 1.0;
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (fabs(delta[axis]) < 1e-12)
+		{
+			if ((start[axis] < minimum[axis]) || (start[axis] > maximum[axis])) return(false);
+			continue;
+		}
+
+		double t1 = (minimum[axis] - start[axis]) / delta[axis];
+		double t2 = (maximum[axis] - start[axis]) / delta[axis];
+		if (t1 > t2) { double temp = t1; t1 = t2; t2 = temp; }
+
+		if (t1 > enter) enter = t1;
+		if (t2 < leave) leave = t2;
+		if (enter > leave) return(false);
+	} // End for
+
+	return(true);
+} // End Crosses() method
+
+/**
+	Return the height (in drawing units) at which the tool can safely rapid between these two
+	points.  It's the lowest height that's at least 'lowest' and clears every solid under the
+	path by the LinkClearance margin.  If that's above 'highest' then 'highest' is returned as
+	it always has been.  So is it if there are no solids in the drawing at all since then we
+	know nothing about what's on the table.
+ */
+double CLinkPlanner::LinkHeight( CFixture fixture, const CNCPoint & from, const CNCPoint & to,
+								 const double tool_radius, const double lowest, const double highest )
+{
+	if (lowest >= highest) return(highest);
+
+	LinkKey_t key;
+	key.push_back( double(fixture.m_coordinate_system_number) );
+	key.push_back( from.X() );
+	key.push_back( from.Y() );
+	key.push_back( to.X() );
+	key.push_back( to.Y() );
+	key.push_back( tool_radius );
+	key.push_back( lowest );
+	key.push_back( highest );
+
+	std::map<LinkKey_t, double>::const_iterator l_itLink = m_links.find(key);
+	if (l_itLink != m_links.end()) return(l_itLink->second);
+
+	const Obstacles_t & obstacles = Obstacles(fixture);
+	if (obstacles.size() == 0) return(highest);
+
+	double height = lowest;
+	for (Obstacles_t::const_iterator l_itBox = obstacles.begin(); (l_itBox != obstacles.end()) && (height < highest); l_itBox++)
+	{
+		if ((l_itBox->MaxZ() + m_margin > height) && (Crosses(from, to, *l_itBox, tool_radius)))
+		{
+			height = l_itBox->MaxZ() + m_margin;
+		}
+	} // End for
+
+	if (height > highest) height = highest;
+
+	m_links.insert( std::make_pair( key, height ) );
+	return(height);
+} // End LinkHeight() method
@@ -0,0 +1,51 @@
+// LinkPlanner.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include "Fixture.h"
+#include "CNCPoint.h"
+#include "interface/Box.h"
+
+#include <map>
+#include <vector>
+
+class HeeksObj;
+
+/**
+	The CLinkPlanner class decides how high the tool needs to be lifted to rapid from one place
+	to another within an operation.  Operations have always gone all the way up to their
+	clearance height for every such move.  Instead, this looks at the solids in the drawing
+	(the part model, adjusted for the fixture being used) and only lifts high enough to clear
+	the ones whose bounding boxes lie under the path of the tool.  The move is never made
+	lower than the 'lowest' height given (i.e. the operation's rapid safety height, which is
+	above any stock it's cutting) nor higher than its clearance height.  It's only used if the
+	program's 'lower links' option is set, and even then only if the drawing has some solids in it.
+
+	The solids' bounding boxes are gathered once per CMachineState (i.e. once per rewrite of
+	the Python program) and each link's height is remembered so that repeated moves between
+	the same two places are only checked once.
+ */
+class CLinkPlanner
+{
+public:
+	CLinkPlanner() : m_margin(2.0), m_obstacles_found(false) { }
+
+	double LinkHeight( CFixture fixture, const CNCPoint & from, const CNCPoint & to,
+					   const double tool_radius, const double lowest, const double highest );
+
+private:
+	typedef std::vector<CBox> Obstacles_t;
+	typedef std::vector<double> LinkKey_t;	// coordinate system, from (x,y), to (x,y), tool radius, lowest, highest
+
+	void FindObstacles( HeeksObj *parent );
+	const Obstacles_t & Obstacles( CFixture & fixture );
+	static bool Crosses( const CNCPoint & from, const CNCPoint & to, const CBox & box, const double tool_radius );
+
+	double m_margin;	// How far above an obstacle the tool must pass.
+	bool m_obstacles_found;
+	Obstacles_t m_solid_boxes;	// in drawing coordinates
+	std::map<CFixture::eCoordinateSystemNumber_t, Obstacles_t> m_obstacles;	// adjusted for each fixture
+	std::map<LinkKey_t, double> m_links;
+}; // End CLinkPlanner class definition.
@@ -6,6 +6,7 @@
  */
 
 #include <stdafx.h>
+#include <math.h>
 #include "MachineState.h"
 #include "CTool.h"
 #include "CNCPoint.h"
@@ -50,9 +51,8 @@ CMachineState & CMachineState::operator= ( CMachineState & rhs )
         m_tool_number = rhs.Tool();
         m_fixture_has_been_set = rhs.m_fixture_has_been_set;
 		m_attached_to_surface = rhs.m_attached_to_surface;
-		m_previous_locations.clear();
-		std::copy( rhs.m_previous_locations.begin(), rhs.m_previous_locations.end(),
-			std::inserter( m_previous_locations, m_previous_locations.begin() ));
+		m_previous_locations = rhs.m_previous_locations;
+		m_link_planner = rhs.m_link_planner;
     }
 
     return(*this);
@@ -214,8 +214,15 @@ Python CMachineState::Fixture( CFixture new_fixture )
 
 		python << _T("rapid(z=") << PROGRAM->m_machine.m_safety_height / PROGRAM->m_units << _T(", machine_coordinates=True)\n");
 
+		// The old fixture's height map doesn't apply to the new one.
+		if ((m_fixture_has_been_set) && (m_fixture.m_params.m_height_map.size() > 0))
+		{
+			python << _T("nc.level.level_end()\n");
+		}
+
 		// Invoke new coordinate system.
 		python << new_fixture.AppendTextToProgram();
+		python << new_fixture.HeightMapBegin();
 
 		if (m_fixture_has_been_set == true)
 		{
@@ -245,49 +252,47 @@ Python CMachineState::Fixture( CFixture new_fixture )
 }
 
 /**
-	Look to see if this object has been handled for this fixture already.
+	Move up to the machine's safety height and forget where we are, just as a change of
+	fixture does.  This leaves the machine in the same state no matter how it got here.  We
+	need that before generating code that will be run from more than one place (such as a
+	subroutine that's called once in each fixture).
  */
-bool CMachineState::AlreadyProcessed( const HeeksObj *object, const CFixture fixture )
+Python CMachineState::Retract()
 {
-    Instance instance;
-    instance.Object(object);
-    instance.Fixture(fixture);
+	Python python;
+
+	if ((m_location_is_known) && (PROGRAM->m_machine.m_safety_height_defined))
+	{
+		python << _T("rapid(z=") << PROGRAM->m_machine.m_safety_height / PROGRAM->m_units << _T(", machine_coordinates=True)\n");
+	}
 
-    return(m_already_processed.find(instance) != m_already_processed.end());
+	// Don't leave the old location where operations can compare it with their start points.  The
+	// safety height is in machine coordinates but it's still the best guess we've got for Z.
+	m_location.SetZ(PROGRAM->m_machine.m_safety_height / PROGRAM->m_units);
+	m_location_is_known = false;
+	return(python);
 }
 
 /**
-	Remember which objects have been processed for which fixtures.
+	Look to see if this object has been handled for this fixture already.
  */
-void CMachineState::MarkAsProcessed( const HeeksObj *object, const CFixture fixture )
-{
-    Instance instance;
-    instance.Object(object);
-    instance.Fixture(fixture);
-
-	m_already_processed.insert( instance );
-}
-
-CMachineState::Instance::Instance( const CMachineState::Instance & rhs ) : m_fixture(rhs.m_fixture)
+bool CMachineState::AlreadyProcessed( const HeeksObj *object, const CFixture & fixture ) const
 {
-    *this = rhs;
+    return(m_already_processed.find(Instance(object, fixture)) != m_already_processed.end());
 }
 
-CMachineState::Instance & CMachineState::Instance::operator= ( const CMachineState::Instance & rhs )
+/**
+	Remember which objects have been processed for which fixtures.
+ */
+void CMachineState::MarkAsProcessed( const HeeksObj *object, const CFixture & fixture )
 {
-    if (this != &rhs)
-    {
-        m_object = rhs.m_object;
-        m_fixture = rhs.m_fixture;
-    }
-
-    return(*this);
+	m_already_processed.insert( Instance(object, fixture) );
 }
 
 bool CMachineState::Instance::operator== ( const CMachineState::Instance & rhs ) const
 {
     if (m_object != rhs.m_object) return(false);
-    if (m_fixture != rhs.m_fixture) return(false);
+    if (m_coordinate_system_number != rhs.m_coordinate_system_number) return(false);
 
     return(true);
 }
@@ -297,7 +302,7 @@ bool CMachineState::Instance::operator< ( const CMachineState::Instance & rhs )
     if (m_object < rhs.m_object) return(true);
     if (m_object > rhs.m_object) return(false);
 
-    return(m_fixture < rhs.m_fixture);
+    return(m_coordinate_system_number < rhs.m_coordinate_system_number);
 }
 
 
@@ -482,7 +487,7 @@ Python CMachineState::ToolChangeMovement_Preamble(std::set<CFixture> & fixtures)
 void CMachineState::Location( const CNCPoint rhs )
 {
 	m_location = rhs; m_location_is_known = true;
-	m_previous_locations.insert( std::make_pair( Fixture(), rhs ) );	// Remember where we've been.
+	m_previous_locations[m_fixture.m_coordinate_system_number].Insert( rhs );	// Remember where we've been.
 }
 
 /**
@@ -493,17 +498,14 @@ void CMachineState::Location( const CNCPoint rhs )
 	We could just feed down to this previously machined location and then ramp
 	from there.
  */
-bool CMachineState::NearestLocation(CFixture fixture, CNCPoint location, CNCPoint *pPreviousLocation) const
+bool CMachineState::NearestLocation(const CFixture & fixture, const CNCPoint & location, CNCPoint *pPreviousLocation) const
 {
 	double tolerance = heeksCAD->GetTolerance();
 	std::list<CNCPoint> options;
-	for (std::multimap<CFixture, CNCPoint>::const_iterator itLocation = m_previous_locations.lower_bound(fixture);
-		itLocation != m_previous_locations.upper_bound(fixture); itLocation++)
+	std::map<CFixture::eCoordinateSystemNumber_t, Locations>::const_iterator l_itLocations = m_previous_locations.find(fixture.m_coordinate_system_number);
+	if (l_itLocations != m_previous_locations.end())
 	{
-		if (itLocation->second.XYDistance(location) < tolerance)
-		{
-			options.push_back(itLocation->second);
-		}
+		l_itLocations->second.Within(location, tolerance, &options);
 	}
 
 	options.sort();
@@ -516,3 +518,87 @@ bool CMachineState::NearestLocation(CFixture fixture, CNCPoint location, CNCPoin
 	return(false);	// Nothing found that matches the X,Y coordinate pair.
 }
 
+/**
+	Return the height (in drawing units) to which the tool must be raised before it rapids from
+	its current location to the one given.  See CLinkPlanner for how this is chosen.  Unless
+	the program asks for lower links, or if we don't know where the tool is, we have to go all
+	the way up to the 'highest' height.
+ */
+double CMachineState::LinkHeight(const CNCPoint & to, const double lowest, const double highest)
+{
+	if ((PROGRAM == NULL) || (! PROGRAM->m_lower_links)) return(highest);
+	if (! m_location_is_known) return(highest);
+
+	double tool_radius = 0.0;
+	CTool *pTool = CTool::Find(m_tool_number);
+	if (pTool != NULL) tool_radius = pTool->m_params.m_diameter / 2.0;
+
+	return(m_link_planner.LinkHeight(m_fixture, m_location, to, tool_radius, lowest, highest));
+}
+
+CMachineState::Locations::Cell_t CMachineState::Locations::Cell( const double x, const double y ) const
+{
+	return(Cell_t( int(floor(x / m_cell_size)), int(floor(y / m_cell_size)) ));
+}
+
+void CMachineState::Locations::Insert( const CNCPoint & location )
+{
+	if (m_cell_size <= 0.0)
+	{
+		// NearestLocation() looks within the tolerance so cells of twice that size mean
+		// each search only looks in two or four of them.
+		m_cell_size = heeksCAD->GetTolerance() * 2.0;
+		if (m_cell_size <= 0.0) m_cell_size = 0.02;
+	}
+
+	m_cells[Cell(location.X(), location.Y())].push_back( std::make_pair( m_count++, location ) );
+}
+
+/**
+	Add all the locations within the radius given (in the XY plane ONLY) to the list.  They're
+	added in the order in which they were visited.
+ */
+void CMachineState::Locations::Within( const CNCPoint & location, const double radius, std::list<CNCPoint> *pLocations ) const
+{
+	if (m_cells.size() == 0) return;
+
+	Cell_t lower = Cell(location.X() - radius, location.Y() - radius);
+	Cell_t upper = Cell(location.X() + radius, location.Y() + radius);
+
+	std::map<unsigned int, CNCPoint> found;
+	double columns = double(upper.first) - double(lower.first) + 1.0;
+	double rows = double(upper.second) - double(lower.second) + 1.0;
+	if (columns * rows > double(m_cells.size()))
+	{
+		// The radius is large compared with the cells.  Just look at all of them.
+		for (std::map< Cell_t, Visits_t >::const_iterator l_itCell = m_cells.begin(); l_itCell != m_cells.end(); l_itCell++)
+		{
+			for (Visits_t::const_iterator l_itVisit = l_itCell->second.begin(); l_itVisit != l_itCell->second.end(); l_itVisit++)
+			{
+				if (l_itVisit->second.XYDistance(location) < radius) found.insert( *l_itVisit );
+			}
+		}
+	}
+	else
+	{
+		for (int column = lower.first; column <= upper.first; column++)
+		{
+			for (int row = lower.second; row <= upper.second; row++)
+			{
+				std::map< Cell_t, Visits_t >::const_iterator l_itCell = m_cells.find( Cell_t(column, row) );
+				if (l_itCell == m_cells.end()) continue;
+
+				for (Visits_t::const_iterator l_itVisit = l_itCell->second.begin(); l_itVisit != l_itCell->second.end(); l_itVisit++)
+				{
+					if (l_itVisit->second.XYDistance(location) < radius) found.insert( *l_itVisit );
+				}
+			}
+		}
+	}
+
+	for (std::map<unsigned int, CNCPoint>::const_iterator l_itFound = found.begin(); l_itFound != found.end(); l_itFound++)
+	{
+		pLocations->push_back( l_itFound->second );
+	}
+} // End Within() method
+
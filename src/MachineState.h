@@ -10,8 +10,12 @@
 #include "Fixture.h"
 #include "PythonStuff.h"
 #include "CNCPoint.h"
+#include "LinkPlanner.h"
 
+#include <list>
 #include <map>
+#include <vector>
+#include <utility>
 
 class Python;
 class CFixture;
@@ -39,28 +43,52 @@ class CMachineState
 private:
 	/**
 		This class remembers an individual machine operation along with
-		the fixture used for gcode generation.  It's really just a placeholder
-		for a tuple of two values so we can keep track of what we've already
-		processed.
+		the coordinate system of the fixture used for gcode generation.  Fixtures
+		are only ever told apart by their coordinate system number so that's all
+		we keep.  Copying and comparing a whole CFixture (with its parameters and
+		child objects) for every lookup is far more work than this needs.
 	 */
    class Instance
     {
     public:
-        Instance() : m_fixture(NULL, CFixture::G54) { }
-        ~Instance() { }
-        Instance & operator= ( const Instance & rhs );
-        Instance( const Instance & rhs );
+        Instance( const HeeksObj *object, const CFixture & fixture )
+			: m_object(object), m_coordinate_system_number(fixture.m_coordinate_system_number) { }
+
         bool operator==( const Instance & rhs ) const;
         bool operator< ( const Instance & rhs ) const;
 
-        void Object(const HeeksObj *object) { m_object = object; }
-        void Fixture( const CFixture fixture ) { m_fixture = fixture; }
-
     private:
         const HeeksObj	*m_object;
-        CFixture    m_fixture;
+        CFixture::eCoordinateSystemNumber_t    m_coordinate_system_number;
     }; // End Instance class definition
 
+	/**
+		This class holds the locations visited within a single fixture.  They're kept in
+		a grid of square cells (in the XY plane) so that finding those within a small
+		distance of a point only means looking in the few cells around it rather than
+		at every location the program has visited so far.  Each location also keeps the
+		order in which it was visited so that equally good matches are chosen in the
+		same order as they always have been.
+	 */
+	class Locations
+	{
+	public:
+		Locations() : m_cell_size(0.0), m_count(0) { }
+
+		void Insert( const CNCPoint & location );
+		void Within( const CNCPoint & location, const double radius, std::list<CNCPoint> *pLocations ) const;
+
+	private:
+		typedef std::pair<int, int> Cell_t;
+		typedef std::vector< std::pair<unsigned int, CNCPoint> > Visits_t;	// visit order, location
+
+		Cell_t Cell( const double x, const double y ) const;
+
+		double m_cell_size;
+		unsigned int m_count;
+		std::map< Cell_t, Visits_t > m_cells;
+	}; // End Locations class definition
+
 public:
 	CAttachOp* m_attached_to_surface;
 
@@ -78,15 +106,17 @@ public:
 
     CNCPoint Location() const { return(m_location); }
     void Location( const CNCPoint rhs );
-	bool NearestLocation(CFixture fixture, CNCPoint location, CNCPoint *pPreviousLocation) const;
+	Python Retract();
+	bool NearestLocation(const CFixture & fixture, const CNCPoint & location, CNCPoint *pPreviousLocation) const;
+	double LinkHeight(const CNCPoint & to, const double lowest, const double highest);
 
 	bool LocationIsKnown() const { return(m_location_is_known); }
 
     bool operator== ( const CMachineState & rhs ) const;
     bool operator!= ( const CMachineState & rhs ) const { return(! (*this == rhs)); }
 
-	bool AlreadyProcessed( const HeeksObj *object, const CFixture fixture );
-	void MarkAsProcessed( const HeeksObj *object, const CFixture fixture );
+	bool AlreadyProcessed( const HeeksObj *object, const CFixture & fixture ) const;
+	void MarkAsProcessed( const HeeksObj *object, const CFixture & fixture );
 	Python ToolChangeMovement_Preamble(std::set<CFixture> & fixtures);
 
 private:
@@ -101,6 +131,9 @@ private:
 
 	// Keep a list of visited points so we can avoid 
 	// unnesseary ramping when we could feed down to a previously visited location.
-	std::multimap<CFixture, CNCPoint> m_previous_locations;
+	std::map<CFixture::eCoordinateSystemNumber_t, Locations> m_previous_locations;
+
+	// Decides how high to lift the tool when moving between places within an operation.
+	CLinkPlanner m_link_planner;
 
 }; // End CMachineState class definition
@@ -515,11 +515,20 @@ double CNCCodeBlock::multiplier = 1.0;
 
 HeeksObj *CNCCodeBlock::MakeACopy(void)const{return new CNCCodeBlock(*this);}
 
-void CNCCodeBlock::WriteNCCode(wxTextFile &f, double ox, double oy)
+/**
+	Write the block's moves turned by angle (degrees, anti-clockwise about the origin) and then
+	moved by (ox, oy).  Once turned, a move along X alone moves along Y too, so position holds
+	the X and Y the code has got to (before it's turned) from one block to the next.  Arc centres
+	(I and J) are turned with it.
+ */
+void CNCCodeBlock::WriteNCCode(wxTextFile &f, double ox, double oy, double angle, double *position)
 {
 	//TODO: offset is always in millimeters, but this gcode block could be in anything
 	//I used inches, so I hacked it into working.
 	wxString movement;
+	bool moves_xy = false;
+	bool has_centre = false;
+	double centre[2] = {0, 0};
 	std::list<ColouredText>::iterator it;
 	for(it = m_text.begin(); it != m_text.end(); it++)
 	{
@@ -541,12 +550,27 @@ void CNCCodeBlock::WriteNCCode(wxTextFile &f, double ox, double oy)
 					ct.m_str.SubString(1,ct.m_str.size()-1).ToDouble(&pos);
 					if(axis == 'X' || axis == 'x')
 					{
+						position[0] = pos;
+						moves_xy = true;
 						str = wxString::Format(_T("%c%f"),axis,pos+ox/25.4);
 					}
 					if(axis == 'Y' || axis == 'y')
 					{
+						position[1] = pos;
+						moves_xy = true;
 						str = wxString::Format(_T("%c%f"),axis,pos+oy/25.4);
 					}
+					if(angle != 0.0)
+					{
+						// Turned moves are written once all of the block's words have been read.
+						if(axis == 'I' || axis == 'i' || axis == 'J' || axis == 'j')
+						{
+							centre[(axis == 'I' || axis == 'i')?0:1] = pos;
+							has_centre = true;
+							str.Empty();
+						}
+						if(axis == 'X' || axis == 'x' || axis == 'Y' || axis == 'y') str.Empty();
+					}
 					movement.append(str);
 				}
 				break;
@@ -555,6 +579,22 @@ void CNCCodeBlock::WriteNCCode(wxTextFile &f, double ox, double oy)
 		}
 	}
 
+	if(angle != 0.0)
+	{
+		double c = cos(angle * PI/180);
+		double s = sin(angle * PI/180);
+		if(moves_xy)
+		{
+			movement.append(wxString::Format(_T("X%f"),position[0] * c - position[1] * s + ox/25.4));
+			movement.append(wxString::Format(_T("Y%f"),position[0] * s + position[1] * c + oy/25.4));
+		}
+		if(has_centre)
+		{
+			movement.append(wxString::Format(_T("I%f"),centre[0] * c - centre[1] * s));
+			movement.append(wxString::Format(_T("J%f"),centre[0] * s + centre[1] * c));
+		}
+	}
+
 	if(movement.size())
 		f.AddLine(movement);
 }
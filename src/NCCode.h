@@ -156,7 +156,7 @@ public:
 
 	CNCCodeBlock():m_from_pos(-1), m_to_pos(-1), m_formatted(false) {}
 
-	void WriteNCCode(wxTextFile &f, double ox, double oy);
+	void WriteNCCode(wxTextFile &f, double ox, double oy, double angle, double *position);
 
 	// HeeksObj's virtual functions
 	int GetType()const{return NCCodeBlockType;}
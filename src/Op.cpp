@@ -34,6 +34,7 @@
 
 #include <iterator>
 #include <vector>
+#include <wx/tokenzr.h>
 
 const wxBitmap& COp::GetInactiveIcon()
 {
@@ -70,6 +71,7 @@ void COp::WriteBaseXML(TiXmlElement *element)
 	element->SetAttribute( "title", m_title.utf8_str());
 	element->SetAttribute( "execution_order", m_execution_order);
 	element->SetAttribute( "tool_number", m_tool_number);
+	if(m_must_follow.size() > 0)element->SetAttribute( "must_follow", MustFollowString().utf8_str());
 
 	ObjList::WriteBaseXML(element);
 }
@@ -120,12 +122,17 @@ void COp::ReadBaseXML(TiXmlElement* element)
         } // End if - else
 	} // End if - else
 
+	const char* must_follow = element->Attribute("must_follow");
+	m_must_follow.clear();
+	if(must_follow)SetMustFollow(wxString(Ctt(must_follow)));
+
 	ObjList::ReadBaseXML(element);
 }
 
 static void on_set_comment(const wxChar* value, HeeksObj* object){((COp*)object)->m_comment = value;}
 static void on_set_active(bool value, HeeksObj* object){((COp*)object)->m_active = value;heeksCAD->Changed();}
 static void on_set_execution_order(int value, HeeksObj* object){((COp*)object)->m_execution_order = value;heeksCAD->Changed();}
+static void on_set_must_follow(const wxChar* value, HeeksObj* object){((COp*)object)->SetMustFollow(value);heeksCAD->Changed();}
 
 static void on_set_tool_number(int zero_based_choice, HeeksObj* object)
 {
@@ -151,6 +158,7 @@ void COp::GetProperties(std::list<Property *> *list)
 	list->push_back(new PropertyString(_("comment"), m_comment, this, on_set_comment));
 	list->push_back(new PropertyCheck(_("active"), m_active, this, on_set_active));
 	list->push_back(new PropertyInt(_("execution_order"), m_execution_order, this, on_set_execution_order));
+	list->push_back(new PropertyString(_("must follow (operation ids)"), MustFollowString(), this, on_set_must_follow));
 
 	if(UsesTool()){
 		std::vector< std::pair< int, wxString > > tools = FIND_ALL_TOOLS();
@@ -199,6 +207,7 @@ COp & COp::operator= ( const COp & rhs )
 		m_execution_order = rhs.m_execution_order;
 		m_tool_number = rhs.m_tool_number;
 		m_operation_type = rhs.m_operation_type;
+		m_must_follow = rhs.m_must_follow;
 	}
 
 	return(*this);
@@ -262,6 +271,7 @@ void COp::ReadDefaultValues()
 			break;
 		case ZigZagType:
 		case WaterlineType:
+		case HeightmapRoughType:
 			default_tool = FIND_FIRST_TOOL( CToolParams::eEndmill );
 			if (default_tool <= 0) default_tool = FIND_FIRST_TOOL( CToolParams::eBallEndMill );
 			if (default_tool <= 0) default_tool = FIND_FIRST_TOOL( CToolParams::eSlotCutter );
@@ -405,10 +415,58 @@ bool COp::operator==(const COp & rhs) const
 	if (m_execution_order != rhs.m_execution_order) return(false);
 	if (m_tool_number != rhs.m_tool_number) return(false);
 	if (m_operation_type != rhs.m_operation_type) return(false);
+	if (m_must_follow != rhs.m_must_follow) return(false);
 
 	return(ObjList::operator==(rhs));
 }
 
+/**
+	Returns true if this operation has been linked to the other one so that it must be run after it.
+	Links are by id alone so, if operations of different kinds share that id, this must follow them all.
+ */
+bool COp::MustFollow( const COp *other ) const
+{
+	if ((other == NULL) || (other == this)) return(false);
+
+	for (std::list<int>::const_iterator l_itId = m_must_follow.begin(); l_itId != m_must_follow.end(); l_itId++)
+	{
+		if (*l_itId == ((HeeksObj *) other)->m_id) return(true);
+	}
+
+	return(false);
+} // End MustFollow() method
+
+/**
+	The ids of the operations this one must follow, separated by spaces, as they're edited and stored.
+ */
+wxString COp::MustFollowString() const
+{
+	wxString ids;
+	for (std::list<int>::const_iterator l_itId = m_must_follow.begin(); l_itId != m_must_follow.end(); l_itId++)
+	{
+		if (l_itId != m_must_follow.begin()) ids << _T(" ");
+		ids << *l_itId;
+	}
+
+	return(ids);
+} // End MustFollowString() method
+
+/**
+	Read the ids, separated by spaces or commas, of the operations this one must follow.  Anything that
+	isn't a whole number is ignored.
+ */
+void COp::SetMustFollow( const wxString & ids )
+{
+	m_must_follow.clear();
+
+	wxStringTokenizer tokens(ids, _T(" ,;\t"));
+	while (tokens.HasMoreTokens())
+	{
+		long id;
+		if (tokens.GetNextToken().ToLong(&id)) m_must_follow.push_back(int(id));
+	}
+} // End SetMustFollow() method
+
 
 std::set<COp::ToolNumber_t> COp::GetMachineTools() const
 {
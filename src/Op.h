@@ -11,6 +11,7 @@
 #include "interface/ObjList.h"
 #include "PythonStuff.h"
 #include <set>
+#include <list>
 
 #ifndef OP_SKETCHES_AS_CHILDREN
 	#define OP_SKETCHES_AS_CHILDREN
@@ -30,6 +31,7 @@ public:
 	int m_execution_order;	// Order by which the GCode sequences are generated.
 	ToolNumber_t m_tool_number;	// joins the m_tool_number in one of the CTool objects in the tools list.
 	int m_operation_type; // Type of operation (because GetType() overloading does not allow this class to call the parent's method)
+	std::list<int> m_must_follow;	// ids of the operations that must be run before this one.  Operations of other kinds with the same id are included too.
 
 	COp(const wxString& title, const int tool_number = 0, const int operation_type = UnknownType )
             :m_active(true), m_title(title), m_execution_order(0), m_tool_number(tool_number),
@@ -72,6 +74,10 @@ public:
 	virtual std::list<wxString> DesignRulesAdjustment(const bool apply_changes);
 	virtual wxString DesignRulesPreamble() const;
 
+	bool MustFollow( const COp *other ) const;
+	wxString MustFollowString() const;
+	void SetMustFollow( const wxString & ids );
+
 	bool operator==(const COp & rhs) const;
 	bool operator!=(const COp & rhs) const { return(! (*this == rhs)); }
 	bool IsDifferent(HeeksObj *other) { return( *this != (*((COp *)other)) ); }
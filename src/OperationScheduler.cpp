@@ -0,0 +1,283 @@
+// OperationScheduler.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "OperationScheduler.h"
+#include "Op.h"
+#include "CTool.h"
+#include "Operations.h"
+#include "MachineState.h"
+#include "Program.h"
+#include "CNCConfig.h"
+#include "PythonStuff.h"
+#include "interface/Box.h"
+
+#include <list>
+
+COperationScheduler::CJob::CJob( COp *pOp, const CFixture *pFixture ) : m_pOp(pOp), m_pFixture(pFixture), m_location_is_known(false)
+{
+	m_tool_number = (pOp->UsesTool())?pOp->m_tool_number:-1;
+
+	CBox box;
+	((HeeksObj *) pOp)->GetBox(box);
+	if (box.m_valid)
+	{
+		double centre[3];
+		box.Centre(centre);
+		m_location = CNCPoint(m_pFixture->Adjustment(gp_Pnt(centre[0], centre[1], centre[2])));
+		m_location_is_known = true;
+	}
+} // End constructor
+
+/**
+	Returns true if the lhs operation must be run before the rhs operation.  This is the
+	order that the operations have always been sorted into, other than by tool number;
+		- explicit links (one operation must follow the other)
+		- execution order
+		- centre drilling operations
+		- drilling operations
+		- tapping operations
+		- all other operations
+		- chamfer operations
+ */
+/* static */ bool COperationScheduler::Before( const COp *lhs, const COp *rhs )
+{
+	if (rhs->MustFollow(lhs)) return(true);
+	if (lhs->MustFollow(rhs)) return(false);
+
+	if (lhs->m_execution_order < rhs->m_execution_order) return(true);
+	if (lhs->m_execution_order > rhs->m_execution_order) return(false);
+
+	// We want to run through all the centre drilling, then drilling, then milling then chamfering.
+
+	if ((((HeeksObj *)lhs)->GetType() == ChamferType) && (((HeeksObj *)rhs)->GetType() != ChamferType)) return(false);
+	if ((((HeeksObj *)lhs)->GetType() != ChamferType) && (((HeeksObj *)rhs)->GetType() == ChamferType)) return(true);
+
+	if ((((HeeksObj *)lhs)->GetType() == DrillingType) && (((HeeksObj *)rhs)->GetType() != DrillingType)) return(true);
+	if ((((HeeksObj *)lhs)->GetType() != DrillingType) && (((HeeksObj *)rhs)->GetType() == DrillingType)) return(false);
+
+	if ((((HeeksObj *)lhs)->GetType() == TappingType) && (((HeeksObj *)rhs)->GetType() != TappingType)) return(true);
+	if ((((HeeksObj *)lhs)->GetType() != TappingType) && (((HeeksObj *)rhs)->GetType() == TappingType)) return(false);
+
+	if ((((HeeksObj *)lhs)->GetType() == DrillingType) && (((HeeksObj *)rhs)->GetType() == DrillingType))
+	{
+		// They're both drilling operations.  Select centre drilling over normal drilling.
+		CTool *lhsPtr = (CTool *) CTool::Find( lhs->m_tool_number );
+		CTool *rhsPtr = (CTool *) CTool::Find( rhs->m_tool_number );
+
+		if ((lhsPtr != NULL) && (rhsPtr != NULL))
+		{
+			if ((lhsPtr->m_params.m_type == CToolParams::eCentreDrill) &&
+			    (rhsPtr->m_params.m_type != CToolParams::eCentreDrill)) return(true);
+
+			if ((lhsPtr->m_params.m_type != CToolParams::eCentreDrill) &&
+			    (rhsPtr->m_params.m_type == CToolParams::eCentreDrill)) return(false);
+
+			// There is no preference for centre drill.  Neither tool is a centre drill.  Give preference
+			// to a normal drill bit over a milling bit now.
+
+			if ((lhsPtr->m_params.m_type == CToolParams::eDrill) &&
+			    (rhsPtr->m_params.m_type != CToolParams::eDrill)) return(true);
+
+			if ((lhsPtr->m_params.m_type != CToolParams::eDrill) &&
+			    (rhsPtr->m_params.m_type == CToolParams::eDrill)) return(false);
+
+			// Finally, give preference to a milling bit over a chamfer bit.
+			if ((lhsPtr->m_params.m_type == CToolParams::eChamfer) &&
+			    (rhsPtr->m_params.m_type != CToolParams::eChamfer)) return(false);
+
+			if ((lhsPtr->m_params.m_type != CToolParams::eChamfer) &&
+			    (rhsPtr->m_params.m_type == CToolParams::eChamfer)) return(true);
+		} // End if - then
+	} // End if - then
+
+	return(false);
+} // End Before() method
+
+COperationScheduler::COperationScheduler( const Operations_t & sorted_operations, const std::set<CFixture> & fixtures, const CMachineState & machine )
+{
+	CNCConfig config(CProgram::ConfigScope());
+	config.Read(_T("ToolChangeSeconds"), &m_tool_change_seconds, 30.0);
+	config.Read(_T("FixtureChangeSeconds"), &m_fixture_change_seconds, 20.0);
+	config.Read(_T("RapidRate"), &m_rapid_rate, 2000.0);
+	if (m_rapid_rate <= 0.0) m_rapid_rate = 2000.0;
+
+	m_initial_tool_number = machine.Tool();
+
+	// Sorting can't be relied on to honour the links between operations (they don't form a
+	// strict weak ordering together with the rest of Before()) so move each operation after
+	// any it must follow, keeping the sorted order otherwise.
+	Operations_t operations;
+	std::set<COp *> placed;
+	for (Operations_t::const_iterator l_itOp = sorted_operations.begin(); l_itOp != sorted_operations.end(); l_itOp++)
+	{
+		Place( *l_itOp, sorted_operations, placed, operations );
+	}
+
+	// Gather the stages.  Each one holds the jobs, in their original order, for operations
+	// that can be run in any order with respect to each other.
+	std::list<Jobs_t> stages;
+	const COp *stage_start = NULL;
+	for (Operations_t::const_iterator l_itOp = operations.begin(); l_itOp != operations.end(); l_itOp++)
+	{
+		COp *pOp = *l_itOp;
+		if ((pOp == NULL) || (! COperations::IsAnOperation(((HeeksObj *) pOp)->GetType())) || (! pOp->m_active)) continue;
+
+		bool new_stage = ((stage_start == NULL) || Before(stage_start, pOp));
+		if (! new_stage)
+		{
+			for (Jobs_t::const_iterator l_itJob = stages.back().begin(); l_itJob != stages.back().end(); l_itJob++)
+			{
+				if (pOp->MustFollow(l_itJob->m_pOp)) new_stage = true;
+			}
+		}
+
+		if (new_stage)
+		{
+			stages.push_back(Jobs_t());
+			stage_start = pOp;
+		}
+
+		std::list<CFixture> private_fixtures = pOp->PrivateFixtures();
+		for (std::set<CFixture>::const_iterator l_itFixture = fixtures.begin(); l_itFixture != fixtures.end(); l_itFixture++)
+		{
+			bool include = (private_fixtures.size() == 0);
+			for (std::list<CFixture>::iterator l_itPrivate = private_fixtures.begin(); l_itPrivate != private_fixtures.end(); l_itPrivate++)
+			{
+				if (*l_itPrivate == *l_itFixture) include = true;
+			}
+
+			if (include)
+			{
+				stages.back().push_back(CJob(pOp, &(*l_itFixture)));
+				m_original_jobs.push_back(stages.back().back());
+			}
+		} // End for
+	} // End for
+
+	// Within each stage, keep choosing whichever job is cheapest to move on to.
+	int tool_number = m_initial_tool_number;
+	for (std::list<Jobs_t>::iterator l_itStage = stages.begin(); l_itStage != stages.end(); l_itStage++)
+	{
+		std::vector<bool> done(l_itStage->size(), false);
+		for (Jobs_t::size_type count = 0; count < l_itStage->size(); count++)
+		{
+			const CJob *pPrevious = (m_jobs.size() == 0)?NULL:&(m_jobs.back());
+			Jobs_t::size_type best = l_itStage->size();
+			double best_cost = 0.0;
+			for (Jobs_t::size_type i = 0; i < l_itStage->size(); i++)
+			{
+				if (done[i]) continue;
+				double cost = Cost(pPrevious, tool_number, (*l_itStage)[i]);
+				if ((best == l_itStage->size()) || (cost < best_cost))
+				{
+					best = i;
+					best_cost = cost;
+				}
+			} // End for
+
+			done[best] = true;
+			m_jobs.push_back((*l_itStage)[best]);
+			if (m_jobs.back().m_tool_number >= 0) tool_number = m_jobs.back().m_tool_number;
+		} // End for
+	} // End for
+
+	if (Cost(m_jobs) >= Cost(m_original_jobs))
+	{
+		m_jobs = m_original_jobs;
+	}
+} // End constructor
+
+/**
+	Add the operation to the ordered list, after the operations (from the same list) that it
+	must follow.  Operations that are already placed are skipped, which also stops links that go
+	round in a circle from looping forever.
+ */
+/* static */ void COperationScheduler::Place( COp *pOp, const Operations_t & operations, std::set<COp *> & placed, Operations_t & ordered )
+{
+	if (pOp == NULL) return;
+	if (! placed.insert(pOp).second) return;
+
+	for (Operations_t::const_iterator l_itOp = operations.begin(); l_itOp != operations.end(); l_itOp++)
+	{
+		if (pOp->MustFollow(*l_itOp)) Place( *l_itOp, operations, placed, ordered );
+	}
+
+	ordered.push_back(pOp);
+} // End Place() method
+
+/**
+	Estimated time (in seconds) to get from the end of one job to the start of the next.  The
+	tool_number is whatever is in the spindle at the time.  The first job (pFrom == NULL) only
+	pays for a tool change.
+ */
+double COperationScheduler::Cost( const CJob *pFrom, const int tool_number, const CJob & to ) const
+{
+	double cost = 0.0;
+	if ((to.m_tool_number >= 0) && (to.m_tool_number != tool_number)) cost += m_tool_change_seconds;
+	if (pFrom == NULL) return(cost);
+
+	if (pFrom->m_pFixture != to.m_pFixture) cost += m_fixture_change_seconds;	// Each fixture is only in the set once.
+	if (pFrom->m_location_is_known && to.m_location_is_known)
+	{
+		cost += pFrom->m_location.Distance(to.m_location) / m_rapid_rate * 60.0;
+	}
+
+	return(cost);
+} // End Cost() method
+
+double COperationScheduler::Cost( const Jobs_t & jobs ) const
+{
+	double cost = 0.0;
+	const CJob *pPrevious = NULL;
+	int tool_number = m_initial_tool_number;
+	for (Jobs_t::const_iterator l_itJob = jobs.begin(); l_itJob != jobs.end(); l_itJob++)
+	{
+		// A job that doesn't use a tool leaves the previous one in the spindle.
+		cost += Cost(pPrevious, tool_number, *l_itJob);
+		if (l_itJob->m_tool_number >= 0) tool_number = l_itJob->m_tool_number;
+		pPrevious = &(*l_itJob);
+	}
+
+	return(cost);
+} // End Cost() method
+
+void COperationScheduler::Count( const Jobs_t & jobs, unsigned int *pToolChanges, unsigned int *pFixtureChanges ) const
+{
+	*pToolChanges = 0;
+	*pFixtureChanges = 0;
+
+	int tool_number = m_initial_tool_number;
+	for (Jobs_t::const_iterator l_itJob = jobs.begin(); l_itJob != jobs.end(); l_itJob++)
+	{
+		if ((l_itJob->m_tool_number >= 0) && (l_itJob->m_tool_number != tool_number))
+		{
+			(*pToolChanges)++;
+			tool_number = l_itJob->m_tool_number;
+		}
+
+		if ((l_itJob != jobs.begin()) && ((l_itJob - 1)->m_pFixture != l_itJob->m_pFixture)) (*pFixtureChanges)++;
+	}
+} // End Count() method
+
+/**
+	Return a Python comment describing what the new order saves (or nothing if the original order was kept).
+ */
+wxString COperationScheduler::Report() const
+{
+	wxString report;
+
+	double saved = Cost(m_original_jobs) - Cost(m_jobs);
+	if (saved <= 0.0) return(report);
+
+	unsigned int tool_changes, fixture_changes, original_tool_changes, original_fixture_changes;
+	Count( m_jobs, &tool_changes, &fixture_changes );
+	Count( m_original_jobs, &original_tool_changes, &original_fixture_changes );
+
+	wxString comment;
+	comment << _("Operations reordered: ") << tool_changes << _(" tool changes and ") << fixture_changes << _(" fixture changes (instead of ")
+			<< original_tool_changes << _(" and ") << original_fixture_changes << _("), saving about ") << int(saved + 0.5) << _(" seconds");
+	report << _T("comment(") << PythonString(comment) << _T(")\n");
+	return(report);
+} // End Report() method
@@ -0,0 +1,68 @@
+// OperationScheduler.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include "Fixture.h"
+#include "CNCPoint.h"
+
+#include <set>
+#include <vector>
+
+class COp;
+class CMachineState;
+
+/**
+	The COperationScheduler class decides the order in which each operation is run in each fixture.
+
+	Operations are first sorted into stages by their execution order and then by the kind of work they
+	do (centre drilling before drilling before tapping before milling before chamfering).  An operation
+	that has been linked to others (its 'must follow' ids) is put in a later stage than all of them,
+	whatever its execution order.  No operation is ever moved into a different stage.  Within a stage,
+	every (operation, fixture) pair is placed by picking the next one that costs least to move to.  The
+	cost is the time for a tool change, a fixture change and the rapid move between the centres of the
+	operations' bounding boxes.
+
+	The original order (each operation in turn for each fixture) is kept if the new order isn't
+	estimated to be any quicker.
+ */
+class COperationScheduler
+{
+public:
+	class CJob
+	{
+	public:
+		CJob( COp *pOp, const CFixture *pFixture );
+
+		COp *m_pOp;
+		const CFixture *m_pFixture;	// Points into the set of fixtures given to the scheduler, which must outlive it.
+		int m_tool_number;		// -1 if the operation doesn't use a tool.
+		bool m_location_is_known;
+		CNCPoint m_location;	// Centre of the operation's bounding box, adjusted for the fixture.
+	}; // End CJob class definition.
+
+	typedef std::vector< COp * > Operations_t;
+	typedef std::vector< CJob > Jobs_t;
+
+	COperationScheduler( const Operations_t & sorted_operations, const std::set<CFixture> & fixtures, const CMachineState & machine );
+
+	const Jobs_t & Jobs() const { return(m_jobs); }
+	wxString Report() const;
+
+	static bool Before( const COp *lhs, const COp *rhs );
+
+private:
+	static void Place( COp *pOp, const Operations_t & operations, std::set<COp *> & placed, Operations_t & ordered );
+	double Cost( const CJob *pFrom, const int tool_number, const CJob & to ) const;
+	double Cost( const Jobs_t & jobs ) const;
+	void Count( const Jobs_t & jobs, unsigned int *pToolChanges, unsigned int *pFixtureChanges ) const;
+
+	Jobs_t m_jobs;
+	Jobs_t m_original_jobs;
+	int m_initial_tool_number;
+
+	double m_tool_change_seconds;
+	double m_fixture_change_seconds;
+	double m_rapid_rate;	// mm/minute
+}; // End COperationScheduler class definition.
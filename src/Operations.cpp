@@ -163,6 +163,7 @@ bool COperations::IsAnOperation(int object_type)
 		case PocketType:
 		case ZigZagType:
 		case WaterlineType:
+		case HeightmapRoughType:
 		case DrillingType:
 		case CounterBoreType:
 		case TurnRoughType:
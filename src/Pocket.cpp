@@ -23,8 +23,10 @@
 #include "Reselect.h"
 #include "MachineState.h"
 #include "PocketDlg.h"
+#include "SplineBiarcs.h"
 
 #include <sstream>
+#include <algorithm>
 
 // static
 double CPocket::max_deviation_for_spline_to_arc = 0.1;
@@ -211,16 +213,21 @@ static wxString WriteSketchDefn(HeeksObj* sketch, CMachineState *pMachineState)
 
 	double prev_e[3];
 
+	// The sketch's own spans are used as they are.  Splines are replaced by copies of their (cached) biarcs.
 	std::list<HeeksObj*> new_spans;
+	std::list<HeeksObj*> biarcs;	// ours to delete
 	for(HeeksObj* span = sketch->GetFirstChild(); span; span = sketch->GetNextChild())
 	{
 		if(span->GetType() == SplineType)
 		{
-			heeksCAD->SplineToBiarcs(span, new_spans, CPocket::max_deviation_for_spline_to_arc);
+			std::list<HeeksObj*> span_biarcs;
+			CSplineBiarcs::Biarcs(span, CPocket::max_deviation_for_spline_to_arc, span_biarcs);
+			std::copy( span_biarcs.begin(), span_biarcs.end(), std::back_inserter( new_spans ) );
+			biarcs.splice( biarcs.end(), span_biarcs );
 		}
 		else
 		{
-			new_spans.push_back(span->MakeACopy());
+			new_spans.push_back(span);
 		}
 	}
 
@@ -318,8 +325,8 @@ static wxString WriteSketchDefn(HeeksObj* sketch, CMachineState *pMachineState)
 		started = false;
 	}
 
-	// delete the spans made
-	for(std::list<HeeksObj*>::iterator It = new_spans.begin(); It != new_spans.end(); It++)
+	// delete the biarcs made
+	for(std::list<HeeksObj*>::iterator It = biarcs.begin(); It != biarcs.end(); It++)
 	{
 		HeeksObj* span = *It;
 		delete span;
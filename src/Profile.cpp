@@ -25,6 +25,7 @@
 #include "MachineState.h"
 #include "Tags.h"
 #include "Tag.h"
+#include "SplineBiarcs.h"
 
 #include <gp_Pnt.hxx>
 #include <gp_Ax1.hxx>
@@ -414,23 +415,25 @@ Python CProfile::WriteSketchDefn(HeeksObj* sketch, CMachineState *pMachineState,
 	}
 
 	std::list<HeeksObj*> new_spans;
+	std::list<HeeksObj*> biarcs;	// ours to delete, unlike the sketch's own spans
 	for(std::list<HeeksObj*>::iterator It = spans.begin(); It != spans.end(); It++)
 	{
 		HeeksObj* span = *It;
 		if(span->GetType() == SplineType)
 		{
 			std::list<HeeksObj*> new_spans2;
-			heeksCAD->SplineToBiarcs(span, new_spans2, CProfile::max_deviation_for_spline_to_arc);
+			CSplineBiarcs::Biarcs(span, CProfile::max_deviation_for_spline_to_arc, new_spans2);
 			for(std::list<HeeksObj*>::iterator It2 = new_spans2.begin(); It2 != new_spans2.end(); It2++)
 			{
 				HeeksObj* s = *It2;
 				if(reversed)new_spans.push_front(s);
 				else new_spans.push_back(s);
+				biarcs.push_back(s);
 			}
 		}
 		else
 		{
-			new_spans.push_back(span->MakeACopy());
+			new_spans.push_back(span);
 		}
 	}
 
@@ -542,8 +545,8 @@ Python CProfile::WriteSketchDefn(HeeksObj* sketch, CMachineState *pMachineState,
 		}
 	}
 
-	// delete the spans made
-	for(std::list<HeeksObj*>::iterator It = new_spans.begin(); It != new_spans.end(); It++)
+	// delete the biarcs made
+	for(std::list<HeeksObj*>::iterator It = biarcs.begin(); It != biarcs.end(); It++)
 	{
 		HeeksObj* span = *It;
 		delete span;
@@ -34,6 +34,7 @@
 #include "interface/strconv.h"
 #include "MachineState.h"
 #include "AttachOp.h"
+#include "OperationScheduler.h"
 
 #include <wx/stdpaths.h>
 #include <wx/filename.h>
@@ -71,6 +72,8 @@ CProgram::CProgram():m_nc_code(NULL), m_operations(NULL), m_tools(NULL), m_speed
 
 	config.Read(_T("OutputFileNameFollowsDataFileName"), &m_output_file_name_follows_data_file_name, true);
 	config.Read(_T("UseInternalBackplotting"), &m_use_internal_backplotting,  true);
+	config.Read(_T("FixtureSubroutines"), &m_fixture_subroutines, false);
+	config.Read(_T("LowerLinks"), &m_lower_links, false);
 	config.Read(_T("Emc2VariablesUnits"), (int *) &m_emc2_variables_units,  int(CProgram::eUndefined));
 
     wxStandardPaths standard_paths;
@@ -85,6 +88,7 @@ CProgram::CProgram():m_nc_code(NULL), m_operations(NULL), m_tools(NULL), m_speed
 	config.Read(_("ProgramNaiveCamTolerance"), &m_naive_cam_tolerance, 0.0001);
 
 	config.Read(_("ClearanceSource"), (int *) &m_clearance_source, int(CProgram::eClearanceDefinedByOperation) );
+	config.Read(_T("KeepSketchWiresBetweenRewrites"), &m_sketch_wires.m_keep_between_rewrites, true);
 }
 
 const wxBitmap &CProgram::GetIcon()
@@ -115,6 +119,8 @@ CProgram::CProgram( const CProgram & rhs ) : ObjList(rhs)
     m_emc2_variables_file_name = rhs.m_emc2_variables_file_name;
     m_output_file_name_follows_data_file_name = rhs.m_output_file_name_follows_data_file_name;
     m_use_internal_backplotting = rhs.m_use_internal_backplotting;
+    m_fixture_subroutines = rhs.m_fixture_subroutines;
+    m_lower_links = rhs.m_lower_links;
     m_emc2_variables_units = rhs.m_emc2_variables_units;
 
     m_script_edited = rhs.m_script_edited;
@@ -170,6 +176,8 @@ void CProgram::CopyFrom(const HeeksObj* object)
 		m_emc2_variables_file_name = rhs->m_emc2_variables_file_name;
 		m_output_file_name_follows_data_file_name = rhs->m_output_file_name_follows_data_file_name;
 		m_use_internal_backplotting = rhs->m_use_internal_backplotting;
+		m_fixture_subroutines = rhs->m_fixture_subroutines;
+		m_lower_links = rhs->m_lower_links;
 		m_emc2_variables_units = rhs->m_emc2_variables_units;
 
 		m_script_edited = rhs->m_script_edited;
@@ -202,6 +210,8 @@ CProgram & CProgram::operator= ( const CProgram & rhs )
 		m_emc2_variables_file_name = rhs.m_emc2_variables_file_name;
 		m_output_file_name_follows_data_file_name = rhs.m_output_file_name_follows_data_file_name;
 		m_use_internal_backplotting = rhs.m_use_internal_backplotting;
+		m_fixture_subroutines = rhs.m_fixture_subroutines;
+		m_lower_links = rhs.m_lower_links;
 		m_emc2_variables_units = rhs.m_emc2_variables_units;
 
 		m_script_edited = rhs.m_script_edited;
@@ -354,6 +364,26 @@ static void on_set_use_internal_backplotting(int zero_based_choice, HeeksObj *ob
 	config.Write(_T("UseInternalBackplotting"), pProgram->m_use_internal_backplotting );
 }
 
+static void on_set_fixture_subroutines(int zero_based_choice, HeeksObj *object)
+{
+	CProgram *pProgram = (CProgram *) object;
+	pProgram->m_fixture_subroutines = (zero_based_choice != 0);
+	heeksCAD->RefreshProperties();
+
+	CNCConfig config(CProgram::ConfigScope());
+	config.Write(_T("FixtureSubroutines"), pProgram->m_fixture_subroutines );
+}
+
+static void on_set_lower_links(int zero_based_choice, HeeksObj *object)
+{
+	CProgram *pProgram = (CProgram *) object;
+	pProgram->m_lower_links = (zero_based_choice != 0);
+	heeksCAD->RefreshProperties();
+
+	CNCConfig config(CProgram::ConfigScope());
+	config.Write(_T("LowerLinks"), pProgram->m_lower_links );
+}
+
 static void on_set_emc2_variables_units(int zero_based_choice, HeeksObj *object)
 {
 	CProgram *pProgram = (CProgram *) object;
@@ -437,6 +467,24 @@ void CProgram::GetProperties(std::list<Property *> *list)
 		list->push_back(new PropertyChoice(_("Backplotting"), choices, choice, this, on_set_use_internal_backplotting));
 	}
 
+	{
+		std::list<wxString> choices;
+		int choice = int(m_fixture_subroutines?1:0);
+		choices.push_back(_T("False"));
+		choices.push_back(_T("True"));
+
+		list->push_back(new PropertyChoice(_("use subroutines for identical fixtures"), choices, choice, this, on_set_fixture_subroutines));
+	}
+
+	{
+		std::list<wxString> choices;
+		int choice = int(m_lower_links?1:0);
+		choices.push_back(_T("False"));
+		choices.push_back(_T("True"));
+
+		list->push_back(new PropertyChoice(_("only lift over solids between regions"), choices, choice, this, on_set_lower_links));
+	}
+
     if (m_use_internal_backplotting)
     {
         list->push_back(new PropertyFile(_("EMC2 Variables File Name"), m_emc2_variables_file_name, this, on_set_emc2_variables_file_name));
@@ -809,6 +857,8 @@ void CProgram::WriteXML(TiXmlNode *root)
 	element->SetAttribute( "machine", m_machine.file_name.utf8_str());
 	element->SetAttribute( "output_file", m_output_file.utf8_str());
 	element->SetAttribute( "output_file_name_follows_data_file_name", (int) (m_output_file_name_follows_data_file_name?1:0));
+	element->SetAttribute( "fixture_subroutines", (int) (m_fixture_subroutines?1:0));
+	element->SetAttribute( "lower_links", (int) (m_lower_links?1:0));
 
 	element->SetAttribute( "program", theApp.m_program_canvas->m_textCtrl->GetValue().utf8_str());
 	element->SetDoubleAttribute( "units", m_units);
@@ -888,6 +938,8 @@ HeeksObj* CProgram::ReadFromXMLElement(TiXmlElement* pElem)
 		else if(name == "emc2_variables_file_name"){new_object->m_emc2_variables_file_name.assign(Ctt(a->Value()));}
 		else if(name == "output_file_name_follows_data_file_name"){new_object->m_output_file_name_follows_data_file_name = (atoi(a->Value()) != 0); }
 		else if(name == "use_internal_backplotting"){new_object->m_use_internal_backplotting = (atoi(a->Value()) != 0); }
+		else if(name == "fixture_subroutines"){new_object->m_fixture_subroutines = (atoi(a->Value()) != 0); }
+		else if(name == "lower_links"){new_object->m_lower_links = (atoi(a->Value()) != 0); }
 		else if(name == "emc2_variables_units"){new_object->m_emc2_variables_units = CProgram::eUnits_t(atoi(a->Value())); }
 		else if(name == "program"){theApp.m_program_canvas->m_textCtrl->SetValue(Ctt(a->Value()));}
 		else if(name == "units"){new_object->m_units = a->DoubleValue();}
@@ -981,51 +1033,8 @@ struct sort_operations : public std::binary_function< bool, COp *, COp * >
 {
 	bool operator() ( const COp *lhs, const COp *rhs ) const
 	{
-		if (lhs->m_execution_order < rhs->m_execution_order) return(true);
-		if (lhs->m_execution_order > rhs->m_execution_order) return(false);
-
-		// We want to run through all the centre drilling, then drilling, then milling then chamfering.
-
-		if ((((HeeksObj *)lhs)->GetType() == ChamferType) && (((HeeksObj *)rhs)->GetType() != ChamferType)) return(false);
-		if ((((HeeksObj *)lhs)->GetType() != ChamferType) && (((HeeksObj *)rhs)->GetType() == ChamferType)) return(true);
-
-		if ((((HeeksObj *)lhs)->GetType() == DrillingType) && (((HeeksObj *)rhs)->GetType() != DrillingType)) return(true);
-		if ((((HeeksObj *)lhs)->GetType() != DrillingType) && (((HeeksObj *)rhs)->GetType() == DrillingType)) return(false);
-
-		if ((((HeeksObj *)lhs)->GetType() == TappingType) && (((HeeksObj *)rhs)->GetType() != TappingType)) return(true);
-		if ((((HeeksObj *)lhs)->GetType() != TappingType) && (((HeeksObj *)rhs)->GetType() == TappingType)) return(false);
-
-		if ((((HeeksObj *)lhs)->GetType() == DrillingType) && (((HeeksObj *)rhs)->GetType() == DrillingType))
-		{
-			// They're both drilling operations.  Select centre drilling over normal drilling.
-			CTool *lhsPtr = (CTool *) CTool::Find( lhs->m_tool_number );
-			CTool *rhsPtr = (CTool *) CTool::Find( rhs->m_tool_number );
-
-			if ((lhsPtr != NULL) && (rhsPtr != NULL))
-			{
-				if ((lhsPtr->m_params.m_type == CToolParams::eCentreDrill) &&
-				    (rhsPtr->m_params.m_type != CToolParams::eCentreDrill)) return(true);
-
-				if ((lhsPtr->m_params.m_type != CToolParams::eCentreDrill) &&
-				    (rhsPtr->m_params.m_type == CToolParams::eCentreDrill)) return(false);
-
-				// There is no preference for centre drill.  Neither tool is a centre drill.  Give preference
-				// to a normal drill bit over a milling bit now.
-
-				if ((lhsPtr->m_params.m_type == CToolParams::eDrill) &&
-				    (rhsPtr->m_params.m_type != CToolParams::eDrill)) return(true);
-
-				if ((lhsPtr->m_params.m_type != CToolParams::eDrill) &&
-				    (rhsPtr->m_params.m_type == CToolParams::eDrill)) return(false);
-
-				// Finally, give preference to a milling bit over a chamfer bit.
-				if ((lhsPtr->m_params.m_type == CToolParams::eChamfer) &&
-				    (rhsPtr->m_params.m_type != CToolParams::eChamfer)) return(false);
-
-				if ((lhsPtr->m_params.m_type != CToolParams::eChamfer) &&
-				    (rhsPtr->m_params.m_type == CToolParams::eChamfer)) return(true);
-			} // End if - then
-		} // End if - then
+		if (COperationScheduler::Before(lhs, rhs)) return(true);
+		if (COperationScheduler::Before(rhs, lhs)) return(false);
 
 		// The execution orders are the same.  Let's group on tool number so as
 		// to avoid unnecessary tool change operations.
@@ -1126,9 +1135,6 @@ Python CProgram::RewritePythonProgram()
 
 
 	theApp.m_program_canvas->m_textCtrl->Clear();
-	CZigZag::number_for_stl_file = 1;
-	CWaterline::number_for_stl_file = 1;
-	CAttachOp::number_for_stl_file = 1;
 
 	// call any OnRewritePython functions from other plugins
 	for(std::list< void(*)() >::iterator It = theApp.m_OnRewritePython_list.begin(); It != theApp.m_OnRewritePython_list.end(); It++)
@@ -1170,6 +1176,7 @@ Python CProgram::RewritePythonProgram()
 
 			case PocketType:
 			case InlayType:
+			case HeightmapRoughType:
 				area_module_needed = true;
 				area_funcs_needed = true;
 				break;
@@ -1416,52 +1423,106 @@ Python CProgram::RewritePythonProgram()
     // Go through and probe each fixture (and the tool length switch) to determine the height offsets (if appropriate)
 	python << machine.ToolChangeMovement_Preamble(fixtures);
 
-	// And then all the rest of the operations.
-	for (OperationsMap_t::const_iterator l_itOperation = operations.begin(); l_itOperation != operations.end(); l_itOperation++)
+	m_sketch_wires.Begin();
+
+	// And then all the rest of the operations, in whatever order (within the constraints of
+	// sort_operations) saves the most tool changes, fixture changes and rapid movements.
+	COperationScheduler scheduler(operations, fixtures, machine);
+	python << scheduler.Report();
+
+	// Subroutines (if m_fixture_subroutines is set) are written after the end of the main program.
+	Python subroutines;
+	int subroutine_id = 1000;
+
+	for (COperationScheduler::Jobs_t::const_iterator l_itJob = scheduler.Jobs().begin(); l_itJob != scheduler.Jobs().end(); l_itJob++)
 	{
-		HeeksObj *object = (HeeksObj *) *l_itOperation;
-		if (object == NULL) continue;
+		HeeksObj *object = (HeeksObj *) l_itJob->m_pOp;
+
+		bool already_processed = false;
+		std::list<CFixture> private_fixtures = ((COp *) object)->PrivateFixtures();
+		for (std::list<CFixture>::iterator itFix = private_fixtures.begin();
+				itFix != private_fixtures.end(); itFix++)
+		{
+			if (machine.AlreadyProcessed(object, *itFix)) already_processed = true;
+		}
+
+		// When this operation is called as a subroutine, its later jobs have already been done.
+		// Don't move to their fixtures for nothing.
+		if (m_fixture_subroutines && (private_fixtures.size() == 0) &&
+			(machine.AlreadyProcessed(object, *(l_itJob->m_pFixture)))) continue;
 
-		for (std::set<CFixture>::const_iterator l_itFixture = fixtures.begin(); l_itFixture != fixtures.end(); l_itFixture++)
+		if (private_fixtures.size() == 0)
 		{
-			if(COperations::IsAnOperation(object->GetType()))
+			// Make sure the public fixture is in place.
+			python << machine.Fixture(*(l_itJob->m_pFixture));
+		}
+
+		// Find all the fixtures that would produce the same GCode as this one.  If there is
+		// more than one then generate this operation once and call it in each of them.  Operations
+		// that only change the state that the others are generated in (attach, unattach and
+		// scripts) mean nothing inside a subroutine so they're always written inline.
+		bool changes_state = (object->GetType() == AttachOpType) || (object->GetType() == UnattachOpType) || (object->GetType() == ScriptOpType);
+		std::list<CFixture> calls;
+		if (m_fixture_subroutines && (private_fixtures.size() == 0) && (! changes_state))
+		{
+			CFixture this_fixture(*(l_itJob->m_pFixture));
+			calls.push_back(this_fixture);
+			for (std::set<CFixture>::const_iterator l_itFixture = fixtures.begin(); l_itFixture != fixtures.end(); l_itFixture++)
 			{
-				bool private_fixture_matches = false;
-			    bool already_processed = false;
-			    std::list<CFixture> private_fixtures = ((COp *) object)->PrivateFixtures();
-			    for (std::list<CFixture>::iterator itFix = private_fixtures.begin();
-                        itFix != private_fixtures.end(); itFix++)
-                {
-                    if (machine.AlreadyProcessed(object, *itFix)) already_processed = true;
-
-					// Check to see if this private fixture is the same as the one we're processing.  If it's not then
-					// don't process this time around.
-					if (*itFix == *l_itFixture)
-					{
-						private_fixture_matches = true;
-					}
-                }
-
-                if (private_fixtures.size() == 0)
-                {
-                    // Make sure the public fixture is in place.
-                    python << machine.Fixture(*l_itFixture);
-                }
-				else
-				{
-					if (! private_fixture_matches) continue;	// Don't process this time around.
-				}
+				CFixture other(*l_itFixture);
+				if ((other != this_fixture) &&
+					(! machine.AlreadyProcessed(object, other)) &&
+					(this_fixture.SameToolpathsAs(other))) calls.push_back(other);
+			}
+		}
 
-				if ((! already_processed) &&
-                    (((COp*)object)->m_active) &&
-                    (! machine.AlreadyProcessed(object, *l_itFixture)))
-				{
-					python << ((COp*)object)->AppendTextToProgram( &machine );
-					machine.MarkAsProcessed(object, machine.Fixture());
-				}
+		if (calls.size() > 1)
+		{
+			// Load the tool and move up out of the way first.  The subroutine then starts from the
+			// same state no matter which fixture it's called in.
+			if (((COp*)object)->UsesTool()) python << machine.Tool(((COp*)object)->m_tool_number);
+			python << machine.Retract();
+
+			// The subroutines' Python runs after the main program's, so each one has to set up the
+			// levelling and attachment that its moves were generated under (and undo them again).
+			CAttachOp *attached_to_surface = machine.m_attached_to_surface;
+			subroutines << _T("sub_begin(") << subroutine_id << _T(", ") << PythonString(object->GetShortString()) << _T(")\n");
+			subroutines << machine.Fixture().HeightMapBegin();
+			if (attached_to_surface != NULL) subroutines << attached_to_surface->AppendTextToProgram( &machine );
+			subroutines << ((COp*)object)->AppendTextToProgram( &machine );
+			if (attached_to_surface != NULL) subroutines << _T("nc.attach.attach_end()\n");
+			if (machine.Fixture().m_params.m_height_map.size() > 0) subroutines << _T("nc.level.level_end()\n");
+			subroutines << _T("sub_end()\n");
+
+			CNCPoint end = machine.Location();
+			bool end_is_known = machine.LocationIsKnown();
+
+			for (std::list<CFixture>::iterator l_itCall = calls.begin(); l_itCall != calls.end(); l_itCall++)
+			{
+				python << machine.Fixture(*l_itCall);
+				python << _T("sub_call(") << subroutine_id << _T(")\n");
+				machine.MarkAsProcessed(object, *l_itCall);
 			}
-		} // End for - fixture
-	} // End for - operation
+
+			if (end_is_known) machine.Location(end);
+			subroutine_id++;
+		}
+		else if ((! already_processed) &&
+			(! machine.AlreadyProcessed(object, *(l_itJob->m_pFixture))))
+		{
+			python << ((COp*)object)->AppendTextToProgram( &machine );
+			machine.MarkAsProcessed(object, machine.Fixture());
+		}
+	} // End for - job
+
+	m_sketch_wires.End();
+
+	if (subroutines.Length() > 0)
+	{
+		// Leave the main program's attachment and levelling behind before the subroutines set up their own.
+		if (machine.m_attached_to_surface != NULL) python << _T("nc.attach.attach_end()\n");
+		if (machine.Fixture().m_params.m_height_map.size() > 0) python << _T("nc.level.level_end()\n");
+	}
 
     if (m_machine.m_safety_height_defined)
     {
@@ -1469,6 +1530,7 @@ Python CProgram::RewritePythonProgram()
     }
 
 	python << _T("program_end()\n");
+	python << subroutines;
 	m_python_program = python;
 	theApp.m_program_canvas->m_textCtrl->AppendText(python);
 	if (python.Length() > theApp.m_program_canvas->m_textCtrl->GetValue().Length())
@@ -1720,6 +1782,8 @@ bool CProgram::operator==( const CProgram & rhs ) const
 	if (m_emc2_variables_file_name != rhs.m_emc2_variables_file_name) return(false);
 	if (m_output_file_name_follows_data_file_name != rhs.m_output_file_name_follows_data_file_name) return(false);
 	if (m_use_internal_backplotting != rhs.m_use_internal_backplotting) return(false);
+	if (m_fixture_subroutines != rhs.m_fixture_subroutines) return(false);
+	if (m_lower_links != rhs.m_lower_links) return(false);
 	if (m_emc2_variables_units != rhs.m_emc2_variables_units) return(false);
 	if (m_script_edited != rhs.m_script_edited) return(false);
 	if (m_units != rhs.m_units) return(false);
@@ -11,6 +11,7 @@
 #include "RawMaterial.h"
 #include "SpeedReferences.h"
 #include "Op.h"
+#include "SketchWires.h"
 
 class CNCCode;
 class CProgram;
@@ -122,6 +123,8 @@ public:
 	wxString m_output_file;		// NOTE: Only relevant if the filename does NOT follow the data file's name.
 	bool m_output_file_name_follows_data_file_name;	// Just change the extension to determine the NC file name
 	bool m_use_internal_backplotting;
+	bool m_fixture_subroutines;	// Generate each operation once and call it as a subroutine in each (identical) fixture
+	bool m_lower_links;	// Only lift as high as the solids under the way need between regions (see CLinkPlanner)
 	wxString m_emc2_variables_file_name;
 	eUnits_t m_emc2_variables_units;
 
@@ -136,6 +139,7 @@ public:
 	bool m_script_edited;
 	double m_units; // 1.0 for mm, 25.4 for inches
 	Python m_python_program;
+	CSketchWires m_sketch_wires;	// Sketches converted to wires during (and possibly between) RewritePythonProgram() calls
 
 	CProgram();
 	CProgram( const CProgram & rhs );
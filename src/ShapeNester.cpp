@@ -0,0 +1,1189 @@
+// ShapeNester.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "ShapeNester.h"
+#include "TrsfNCCode.h"
+#include "NCCode.h"
+#include "CTool.h"
+#include "WorkerThreads.h"
+#include "interface/Box.h"
+
+#include <math.h>
+#include <algorithm>
+#include <set>
+
+CShapeNester::CPiece::CPiece( const Polygon_t & outline ) : m_outline(outline), m_min_x(0.0), m_min_y(0.0), m_max_x(0.0), m_max_y(0.0)
+{
+	for (Polygon_t::size_type i = 0; i < m_outline.size(); i++)
+	{
+		const gp_Pnt2d & a = m_outline[i];
+
+		if ((i == 0) || (a.X() < m_min_x)) m_min_x = a.X();
+		if ((i == 0) || (a.X() > m_max_x)) m_max_x = a.X();
+		if ((i == 0) || (a.Y() < m_min_y)) m_min_y = a.Y();
+		if ((i == 0) || (a.Y() > m_max_y)) m_max_y = a.Y();
+	}
+}
+
+CShapeNester::CCandidate::CCandidate( const gp_Pnt2d & position, const int orientation, const COrientation & shape ) : m_position(position), m_orientation(orientation)
+{
+	m_top = position.Y() + shape.m_max_y;
+	m_left = position.X() + shape.m_min_x;
+}
+
+/**
+	Lowest first, then leftmost.  The rest only keeps the order the same every time.
+ */
+bool CShapeNester::CCandidate::operator< ( const CCandidate & rhs ) const
+{
+	if (m_top != rhs.m_top) return(m_top < rhs.m_top);
+	if (m_left != rhs.m_left) return(m_left < rhs.m_left);
+	if (m_orientation != rhs.m_orientation) return(m_orientation < rhs.m_orientation);
+	if (m_position.X() != rhs.m_position.X()) return(m_position.X() < rhs.m_position.X());
+	return(m_position.Y() < rhs.m_position.Y());
+}
+
+CShapeNester::Cell_t CShapeNester::CNoFitPolygon::Cell( const gp_Pnt2d & point ) const
+{
+	return(Cell_t( int(floor(point.X() / m_cell_size)), int(floor(point.Y() / m_cell_size)) ));
+}
+
+/**
+	Returns true if the point is strictly inside any of the pieces.
+ */
+bool CShapeNester::CNoFitPolygon::StrictlyInside( const gp_Pnt2d & point ) const
+{
+	std::map< Cell_t, std::vector<int> >::const_iterator l_itCell = m_cells.find(Cell(point));
+	if (l_itCell == m_cells.end()) return(false);
+
+	for (std::vector<int>::const_iterator l_itPiece = l_itCell->second.begin(); l_itPiece != l_itCell->second.end(); l_itPiece++)
+	{
+		const CPiece & piece = m_pieces[*l_itPiece];
+		if ((point.X() <= piece.m_min_x) || (point.X() >= piece.m_max_x) || (point.Y() <= piece.m_min_y) || (point.Y() >= piece.m_max_y)) continue;
+		if (CShapeNester::StrictlyInside(piece.m_outline, point)) return(true);
+	}
+
+	return(false);
+}
+
+/**
+	Works out a share of the no-fit polygons needed to place the next part.
+ */
+class CShapeNester::CNoFitJob : public CWorkerJob
+{
+public:
+	const CShapeNester *m_pNester;
+	const std::vector< std::pair<Oriented_t, Oriented_t> > *m_pKeys;
+	const std::vector<CNoFitPolygon *> *m_pNoFitPolygons;	// where to put them
+	std::vector<CNoFitPolygon *>::size_type m_first;
+	std::vector<CNoFitPolygon *>::size_type m_step;
+
+	void Run()
+	{
+		for (std::vector<CNoFitPolygon *>::size_type i = m_first; i < m_pNoFitPolygons->size(); i += m_step)
+		{
+			const std::pair<Oriented_t, Oriented_t> & key = (*m_pKeys)[i];
+			MakeNoFitPolygon( m_pNester->Orientation(key.first), m_pNester->Orientation(key.second), *((*m_pNoFitPolygons)[i]) );
+		}
+	}
+}; // End CNoFitJob class definition.
+
+/**
+	Looks through every m_step'th candidate position, starting at m_first, for the first one
+	at each rotation where the part doesn't overlap anything.
+ */
+class CShapeNester::CCandidateJob : public CWorkerJob
+{
+public:
+	const CShapeNester *m_pNester;
+	const std::vector<CCandidate> *m_pCandidates;
+	int m_shape;
+	int m_rotations;	// the number of rotations with any candidates
+	std::vector<CCandidate>::size_type m_first;
+	std::vector<CCandidate>::size_type m_step;
+	std::vector<int> m_found;	// index into the candidates for each rotation (-1 if none)
+
+	void Run()
+	{
+		int remaining = m_rotations;
+		for (std::vector<CCandidate>::size_type i = m_first; (i < m_pCandidates->size()) && (remaining > 0); i += m_step)
+		{
+			const CCandidate & candidate = (*m_pCandidates)[i];
+			if (m_found[candidate.m_orientation] >= 0) continue;
+
+			if (! m_pNester->Overlaps(Oriented_t(m_shape, candidate.m_orientation), candidate.m_position))
+			{
+				m_found[candidate.m_orientation] = int(i);
+				remaining--;
+			}
+		}
+	}
+}; // End CCandidateJob class definition.
+
+CShapeNester::CShapeNester( const double width, const double gap, const int rotations ) : m_width(width), m_gap(gap), m_rotations(std::max(1, rotations)), m_cell_size(10.0)
+{
+}
+
+static bool ByXThenY( const gp_Pnt2d & lhs, const gp_Pnt2d & rhs )
+{
+	if (lhs.X() != rhs.X()) return(lhs.X() < rhs.X());
+	return(lhs.Y() < rhs.Y());
+}
+
+static double Cross( const gp_Pnt2d & o, const gp_Pnt2d & a, const gp_Pnt2d & b )
+{
+	return((a.X() - o.X()) * (b.Y() - o.Y()) - (a.Y() - o.Y()) * (b.X() - o.X()));
+}
+
+static double Area( const CShapeNester::Polygon_t & polygon )
+{
+	double area = 0.0;
+	for (CShapeNester::Polygon_t::size_type i = 0; i < polygon.size(); i++)
+	{
+		const gp_Pnt2d & a = polygon[i];
+		const gp_Pnt2d & b = polygon[(i + 1) % polygon.size()];
+		area += (a.X() * b.Y() - b.X() * a.Y()) / 2.0;
+	}
+
+	return(area);
+}
+
+static double DistanceToSegment( const gp_Pnt2d & point, const gp_Pnt2d & a, const gp_Pnt2d & b )
+{
+	double dx = b.X() - a.X(), dy = b.Y() - a.Y();
+	double length_squared = dx * dx + dy * dy;
+	if (length_squared <= 0.0) return(point.Distance(a));
+
+	double t = ((point.X() - a.X()) * dx + (point.Y() - a.Y()) * dy) / length_squared;
+	t = std::max(0.0, std::min(1.0, t));
+	return(point.Distance(gp_Pnt2d(a.X() + t * dx, a.Y() + t * dy)));
+}
+
+/**
+	Returns true if the segments ab and cd cross each other, rather than just touching.
+ */
+static bool Crosses( const gp_Pnt2d & a, const gp_Pnt2d & b, const gp_Pnt2d & c, const gp_Pnt2d & d, const double tolerance )
+{
+	double t1 = tolerance * a.Distance(b);
+	double d1 = Cross(a, b, c), d2 = Cross(a, b, d);
+	if (! (((d1 > t1) && (d2 < -t1)) || ((d1 < -t1) && (d2 > t1)))) return(false);
+
+	double t2 = tolerance * c.Distance(d);
+	double d3 = Cross(c, d, a), d4 = Cross(c, d, b);
+	return(((d3 > t2) && (d4 < -t2)) || ((d3 < -t2) && (d4 > t2)));
+}
+
+/**
+	Where the segments ab and cd meet, if they do.
+ */
+static bool Intersection( const gp_Pnt2d & a, const gp_Pnt2d & b, const gp_Pnt2d & c, const gp_Pnt2d & d, gp_Pnt2d & point )
+{
+	double abx = b.X() - a.X(), aby = b.Y() - a.Y();
+	double cdx = d.X() - c.X(), cdy = d.Y() - c.Y();
+	double denominator = abx * cdy - aby * cdx;
+	if (fabs(denominator) <= 1e-12 * (fabs(abx) + fabs(aby)) * (fabs(cdx) + fabs(cdy))) return(false);	// parallel
+
+	double t = ((c.X() - a.X()) * cdy - (c.Y() - a.Y()) * cdx) / denominator;
+	double u = ((c.X() - a.X()) * aby - (c.Y() - a.Y()) * abx) / denominator;
+	if ((t < 0.0) || (t > 1.0) || (u < 0.0) || (u > 1.0)) return(false);
+
+	point = gp_Pnt2d(a.X() + t * abx, a.Y() + t * aby);
+	return(true);
+}
+
+/**
+	Returns true if the point is inside the (not necessarily convex) polygon or within tolerance of its edges.
+ */
+static bool InsideOrOn( const CShapeNester::Polygon_t & polygon, const gp_Pnt2d & point, const double tolerance )
+{
+	bool inside = false;
+	for (CShapeNester::Polygon_t::size_type i = 0; i < polygon.size(); i++)
+	{
+		const gp_Pnt2d & a = polygon[i];
+		const gp_Pnt2d & b = polygon[(i + 1) % polygon.size()];
+		if (DistanceToSegment(point, a, b) <= tolerance) return(true);
+
+		if ((a.Y() > point.Y()) != (b.Y() > point.Y()))
+		{
+			double x = a.X() + (b.X() - a.X()) * (point.Y() - a.Y()) / (b.Y() - a.Y());
+			if (point.X() < x) inside = ! inside;
+		}
+	}
+
+	return(inside);
+}
+
+/**
+	Returns true if no two edges of the polygon cross.
+ */
+static bool Simple( const CShapeNester::Polygon_t & polygon )
+{
+	const CShapeNester::Polygon_t::size_type n = polygon.size();
+	for (CShapeNester::Polygon_t::size_type i = 0; i < n; i++)
+	{
+		for (CShapeNester::Polygon_t::size_type j = i + 2; j < n; j++)
+		{
+			if ((i == 0) && (j == n - 1)) continue;	// they share a vertex.
+			if (Crosses(polygon[i], polygon[(i + 1) % n], polygon[j], polygon[(j + 1) % n], 1e-9)) return(false);
+		}
+	}
+
+	return(true);
+}
+
+/**
+	Douglas-Peucker.  Every vertex dropped from the closed polygon is within tolerance of
+	what's left of it.
+ */
+static CShapeNester::Polygon_t Simplify( const CShapeNester::Polygon_t & polygon, const double tolerance )
+{
+	const CShapeNester::Polygon_t::size_type n = polygon.size();
+	if (n < 4) return(polygon);
+
+	// Split it at the first vertex and the one farthest from it.
+	CShapeNester::Polygon_t::size_type farthest = 0;
+	for (CShapeNester::Polygon_t::size_type i = 1; i < n; i++)
+	{
+		if (polygon[i].Distance(polygon[0]) > polygon[farthest].Distance(polygon[0])) farthest = i;
+	}
+	if (farthest == 0) return(polygon);
+
+	std::vector<bool> keep(n + 1, false);	// vertex n is vertex 0 again.
+	keep[0] = keep[farthest] = keep[n] = true;
+
+	std::vector< std::pair<CShapeNester::Polygon_t::size_type, CShapeNester::Polygon_t::size_type> > spans;
+	spans.push_back(std::make_pair(CShapeNester::Polygon_t::size_type(0), farthest));
+	spans.push_back(std::make_pair(farthest, n));
+	while (spans.size() > 0)
+	{
+		CShapeNester::Polygon_t::size_type first = spans.back().first, last = spans.back().second;
+		spans.pop_back();
+
+		CShapeNester::Polygon_t::size_type worst = first;
+		double worst_distance = tolerance;
+		for (CShapeNester::Polygon_t::size_type i = first + 1; i < last; i++)
+		{
+			double distance = DistanceToSegment(polygon[i], polygon[first], polygon[last % n]);
+			if (distance > worst_distance)
+			{
+				worst = i;
+				worst_distance = distance;
+			}
+		}
+
+		if (worst != first)
+		{
+			keep[worst] = true;
+			spans.push_back(std::make_pair(first, worst));
+			spans.push_back(std::make_pair(worst, last));
+		}
+	}
+
+	CShapeNester::Polygon_t simplified;
+	for (CShapeNester::Polygon_t::size_type i = 0; i < n; i++)
+	{
+		if (keep[i]) simplified.push_back(polygon[i]);
+	}
+
+	return(simplified);
+}
+
+/**
+	Andrew's monotone chain.  The hull is returned anti-clockwise without any collinear points.
+ */
+/* static */ CShapeNester::Polygon_t CShapeNester::ConvexHull( std::vector<gp_Pnt2d> points )
+{
+	std::sort( points.begin(), points.end(), ByXThenY );
+	if (points.size() < 3) return(points);
+
+	Polygon_t hull(2 * points.size());
+	Polygon_t::size_type k = 0;
+	for (Polygon_t::size_type i = 0; i < points.size(); i++)
+	{
+		while ((k >= 2) && (Cross(hull[k-2], hull[k-1], points[i]) <= 0.0)) k--;
+		hull[k++] = points[i];
+	}
+
+	for (Polygon_t::size_type i = points.size() - 1, t = k + 1; i > 0; i--)
+	{
+		while ((k >= t) && (Cross(hull[k-2], hull[k-1], points[i-1]) <= 0.0)) k--;
+		hull[k++] = points[i-1];
+	}
+
+	hull.resize(k - 1);
+	return(hull);
+}
+
+/**
+	Grow the convex polygon outwards by this distance.  Each corner is replaced by a polygon
+	around a circle of that radius (big enough to contain the circle) and the hull taken of
+	the lot.  A single line segment grows into a slot around it.
+ */
+/* static */ CShapeNester::Polygon_t CShapeNester::Grow( const Polygon_t & polygon, const double distance )
+{
+	if (distance <= 0.0) return(polygon);
+
+	const int segments = 16;
+	double radius = distance / cos(PI / segments);
+
+	std::vector<gp_Pnt2d> points;
+	for (Polygon_t::const_iterator l_itPoint = polygon.begin(); l_itPoint != polygon.end(); l_itPoint++)
+	{
+		for (int i = 0; i < segments; i++)
+		{
+			double angle = 2.0 * PI * i / segments;
+			points.push_back(gp_Pnt2d(l_itPoint->X() + radius * cos(angle), l_itPoint->Y() + radius * sin(angle)));
+		}
+	}
+
+	return(ConvexHull(points));
+}
+
+/**
+	Returns true if the point is inside the (anti-clockwise, convex) polygon.  Points on its
+	boundary are outside.  That's where two parts touch.
+ */
+/* static */ bool CShapeNester::StrictlyInside( const Polygon_t & polygon, const gp_Pnt2d & point )
+{
+	if (polygon.size() < 3) return(false);
+
+	const double tolerance = 1e-7;
+	for (Polygon_t::size_type i = 0; i < polygon.size(); i++)
+	{
+		const gp_Pnt2d & a = polygon[i];
+		const gp_Pnt2d & b = polygon[(i + 1) % polygon.size()];
+		if (Cross(a, b, point) <= tolerance * a.Distance(b)) return(false);
+	}
+
+	return(true);
+}
+
+static bool Convex( const std::vector<int> & piece, const CShapeNester::Polygon_t & points )
+{
+	for (std::vector<int>::size_type i = 0; i < piece.size(); i++)
+	{
+		const gp_Pnt2d & a = points[piece[(i + piece.size() - 1) % piece.size()]];
+		const gp_Pnt2d & b = points[piece[i]];
+		const gp_Pnt2d & c = points[piece[(i + 1) % piece.size()]];
+		if (Cross(a, b, c) < -1e-9 * a.Distance(c)) return(false);
+	}
+
+	return(true);
+}
+
+/**
+	Split the simple, anti-clockwise polygon into convex pieces.  It's cut into triangles by
+	ear clipping and then neighbouring pieces are merged (Hertel-Mehlhorn) wherever the result
+	is still convex.  Returns no pieces if the polygon couldn't be cut up.
+ */
+/* static */ std::vector<CShapeNester::Polygon_t> CShapeNester::ConvexPieces( const Polygon_t & polygon )
+{
+	std::vector< std::vector<int> > pieces;	// vertex indices
+
+	std::vector<int> remaining;
+	for (Polygon_t::size_type i = 0; i < polygon.size(); i++) remaining.push_back(int(i));
+
+	while (remaining.size() > 3)
+	{
+		bool clipped = false;
+		for (std::vector<int>::size_type i = 0; (i < remaining.size()) && (! clipped); i++)
+		{
+			int a = remaining[(i + remaining.size() - 1) % remaining.size()];
+			int b = remaining[i];
+			int c = remaining[(i + 1) % remaining.size()];
+
+			double cross = Cross(polygon[a], polygon[b], polygon[c]);
+			if (fabs(cross) <= 1e-9 * polygon[a].Distance(polygon[c]))
+			{
+				// A straight (or doubled back) vertex doesn't hold any area.
+				remaining.erase(remaining.begin() + i);
+				clipped = true;
+				continue;
+			}
+			if (cross < 0.0) continue;	// not a corner of the polygon's inside.
+
+			bool ear = true;
+			for (std::vector<int>::const_iterator l_itOther = remaining.begin(); (l_itOther != remaining.end()) && ear; l_itOther++)
+			{
+				if ((*l_itOther == a) || (*l_itOther == b) || (*l_itOther == c)) continue;
+
+				const gp_Pnt2d & point = polygon[*l_itOther];
+				if ((Cross(polygon[a], polygon[b], point) >= 0.0) && (Cross(polygon[b], polygon[c], point) >= 0.0) && (Cross(polygon[c], polygon[a], point) >= 0.0)) ear = false;
+			}
+
+			if (ear)
+			{
+				std::vector<int> triangle;
+				triangle.push_back(a);
+				triangle.push_back(b);
+				triangle.push_back(c);
+				pieces.push_back(triangle);
+				remaining.erase(remaining.begin() + i);
+				clipped = true;
+			}
+		} // End for
+
+		if (! clipped) return(std::vector<Polygon_t>());
+	} // End while
+
+	if ((remaining.size() == 3) && (Cross(polygon[remaining[0]], polygon[remaining[1]], polygon[remaining[2]]) > 0.0)) pieces.push_back(remaining);
+
+	// Remove the diagonals between pieces that would still be convex without them.
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+
+		std::map< std::pair<int, int>, int > edges;	// (from vertex, to vertex) -> piece
+		for (std::vector< std::vector<int> >::size_type i = 0; i < pieces.size(); i++)
+		{
+			for (std::vector<int>::size_type j = 0; j < pieces[i].size(); j++)
+			{
+				edges[std::make_pair(pieces[i][j], pieces[i][(j + 1) % pieces[i].size()])] = int(i);
+			}
+		}
+
+		for (std::vector< std::vector<int> >::size_type i = 0; (i < pieces.size()) && (! merged); i++)
+		{
+			const std::vector<int> & piece = pieces[i];
+			for (std::vector<int>::size_type j = 0; (! merged) && (j < piece.size()); j++)
+			{
+				int a = piece[j];
+				int b = piece[(j + 1) % piece.size()];
+				std::map< std::pair<int, int>, int >::const_iterator l_itEdge = edges.find(std::make_pair(b, a));
+				if ((l_itEdge == edges.end()) || (l_itEdge->second == int(i))) continue;
+
+				// Go round this piece from b to a and then round the other from a to b.
+				const std::vector<int> & other = pieces[l_itEdge->second];
+				std::vector<int> joined;
+				for (std::vector<int>::size_type k = 1; k <= piece.size(); k++) joined.push_back(piece[(j + k) % piece.size()]);
+
+				std::vector<int>::size_type start = std::find(other.begin(), other.end(), a) - other.begin();
+				for (std::vector<int>::size_type k = 1; k < other.size() - 1; k++) joined.push_back(other[(start + k) % other.size()]);
+
+				if (Convex(joined, polygon))
+				{
+					std::vector< std::vector<int> >::size_type other_index = l_itEdge->second;
+					pieces[i] = joined;
+					pieces.erase(pieces.begin() + other_index);
+					merged = true;
+				}
+			} // End for
+		} // End for
+	} // End while
+
+	std::vector<Polygon_t> convex_pieces;
+	for (std::vector< std::vector<int> >::const_iterator l_itPiece = pieces.begin(); l_itPiece != pieces.end(); l_itPiece++)
+	{
+		Polygon_t piece;
+		for (std::vector<int>::const_iterator l_itIndex = l_itPiece->begin(); l_itIndex != l_itPiece->end(); l_itIndex++) piece.push_back(polygon[*l_itIndex]);
+		convex_pieces.push_back(piece);
+	}
+
+	return(convex_pieces);
+}
+
+void CShapeNester::Add( CTrsfNCCode *code )
+{
+	// Copies of the same part share one shape so that their no-fit polygons are only calculated once.
+	CNCCode *nc_code = code->Code();
+	std::map< const CNCCode *, int >::iterator l_itShape = m_shape_ids.find(nc_code);
+	if (l_itShape == m_shape_ids.end())
+	{
+		l_itShape = m_shape_ids.insert( std::make_pair( (const CNCCode *) nc_code, AddShape(nc_code) ) ).first;
+	}
+
+	m_parts.push_back(CPart(code, l_itShape->second));
+}
+
+/**
+	Take the shape of this block of NC code from its feed moves (its rapid moves don't cut
+	anything).  Returns its index into m_shapes.
+ */
+int CShapeNester::AddShape( CNCCode *nc_code )
+{
+	const double tolerance = 0.01;	// for simplifying the outline.  The pieces are grown by this much more to make up for it.
+
+	std::vector<Polygon_t> chains;	// points along each unbroken run of feed moves
+	std::vector<gp_Pnt2d> all_points;
+	double tool_radius = 0.0;
+
+	const PathObject *prev_po = NULL;
+	bool feeding = false;
+	if (nc_code != NULL)
+	{
+		for (std::list<CNCCodeBlock*>::iterator l_itBlock = nc_code->m_blocks.begin(); l_itBlock != nc_code->m_blocks.end(); l_itBlock++)
+		{
+			for (std::list<ColouredPath>::iterator l_itPath = (*l_itBlock)->m_line_strips.begin(); l_itPath != (*l_itBlock)->m_line_strips.end(); l_itPath++)
+			{
+				for (std::list<PathObject *>::iterator l_itPo = l_itPath->m_points.begin(); l_itPo != l_itPath->m_points.end(); l_itPo++)
+				{
+					PathObject *po = *l_itPo;
+					std::vector<gp_Pnt2d> points;
+					if (prev_po != NULL) points.push_back(gp_Pnt2d(prev_po->m_x[0], prev_po->m_x[1]));
+					if ((po->GetType() == int(PathObject::eArc)) && (prev_po != NULL))
+					{
+						std::list<gp_Pnt> arc = ((PathArc *) po)->Interpolate( prev_po, 16 );
+						for (std::list<gp_Pnt>::iterator l_itPoint = arc.begin(); l_itPoint != arc.end(); l_itPoint++)
+						{
+							points.push_back(gp_Pnt2d(l_itPoint->X(), l_itPoint->Y()));
+						}
+					}
+					points.push_back(gp_Pnt2d(po->m_x[0], po->m_x[1]));
+
+					all_points.insert(all_points.end(), points.begin(), points.end());
+					if (l_itPath->m_color_type != ColorRapidType)
+					{
+						if (! feeding) chains.push_back(Polygon_t());
+						feeding = true;
+
+						// Plunges and the like don't move in XY.
+						for (std::vector<gp_Pnt2d>::const_iterator l_itPoint = points.begin(); l_itPoint != points.end(); l_itPoint++)
+						{
+							if ((chains.back().size() == 0) || (chains.back().back().Distance(*l_itPoint) > 1e-6)) chains.back().push_back(*l_itPoint);
+						}
+
+						CTool *pTool = CTool::Find(po->m_tool_number);
+						if ((pTool != NULL) && (pTool->CuttingRadius() > tool_radius)) tool_radius = pTool->CuttingRadius();
+					}
+					else
+					{
+						feeding = false;
+					}
+
+					prev_po = po;
+				} // End for
+			} // End for
+		} // End for
+	} // End if - then
+
+	// Find the closed loops the tool goes around.  A profile cut at several depths goes
+	// around the same loop several times.
+	const double precision = 0.001;
+	std::vector<Polygon_t> loops;
+	for (std::vector<Polygon_t>::const_iterator l_itChain = chains.begin(); l_itChain != chains.end(); l_itChain++)
+	{
+		std::map< std::pair<long, long>, Polygon_t::size_type > seen;	// since the last loop
+		for (Polygon_t::size_type i = 0; i < l_itChain->size(); i++)
+		{
+			const gp_Pnt2d & point = (*l_itChain)[i];
+			std::pair<long, long> key( long(floor(point.X() / precision + 0.5)), long(floor(point.Y() / precision + 0.5)) );
+
+			std::map< std::pair<long, long>, Polygon_t::size_type >::iterator l_itSeen = seen.find(key);
+			if ((l_itSeen != seen.end()) && (i - l_itSeen->second >= 3))
+			{
+				Polygon_t loop(l_itChain->begin() + l_itSeen->second, l_itChain->begin() + i);
+				double area = Area(loop);
+				if (fabs(area) > precision * precision)
+				{
+					if (area < 0.0) std::reverse(loop.begin(), loop.end());
+					loops.push_back(Simplify(loop, tolerance));
+				}
+				seen.clear();
+			}
+			seen[key] = i;
+		} // End for
+	} // End for
+
+	// The outline is made of the loops that aren't inside bigger ones.
+	std::vector< std::pair<double, int> > by_area;
+	for (std::vector<Polygon_t>::size_type i = 0; i < loops.size(); i++) by_area.push_back(std::make_pair(-Area(loops[i]), int(i)));
+	std::sort(by_area.begin(), by_area.end());
+
+	std::vector<CPiece> outer_loops;
+	for (std::vector< std::pair<double, int> >::const_iterator l_itLoop = by_area.begin(); l_itLoop != by_area.end(); l_itLoop++)
+	{
+		const Polygon_t & loop = loops[l_itLoop->second];
+		bool inside = false;
+		for (std::vector<CPiece>::const_iterator l_itOuter = outer_loops.begin(); (l_itOuter != outer_loops.end()) && (! inside); l_itOuter++)
+		{
+			inside = true;
+			for (Polygon_t::const_iterator l_itPoint = loop.begin(); (l_itPoint != loop.end()) && inside; l_itPoint++)
+			{
+				inside = InsideOrOn(l_itOuter->m_outline, *l_itPoint, 2.0 * tolerance);
+			}
+		}
+
+		if (! inside) outer_loops.push_back(CPiece(loop));
+	}
+
+	std::vector<Polygon_t> pieces;
+	for (std::vector<CPiece>::const_iterator l_itOuter = outer_loops.begin(); l_itOuter != outer_loops.end(); l_itOuter++)
+	{
+		std::vector<Polygon_t> convex_pieces;
+		if (Simple(l_itOuter->m_outline)) convex_pieces = ConvexPieces(l_itOuter->m_outline);
+		if (convex_pieces.size() == 0) convex_pieces.push_back(ConvexHull(l_itOuter->m_outline));
+		pieces.insert(pieces.end(), convex_pieces.begin(), convex_pieces.end());
+	}
+
+	// Add the feed moves that aren't within the outline.
+	std::vector<Polygon_t> segments;
+	for (std::vector<Polygon_t>::const_iterator l_itChain = chains.begin(); l_itChain != chains.end(); l_itChain++)
+	{
+		// Each pair of points along the chain (or the only point of a chain that doesn't move in XY).
+		for (Polygon_t::size_type i = 0; (i == 0) || (i + 1 < l_itChain->size()); i++)
+		{
+			const gp_Pnt2d & a = (*l_itChain)[i];
+			const gp_Pnt2d & b = (*l_itChain)[(i + 1 < l_itChain->size())?(i + 1):i];
+
+			bool within = false;
+			for (std::vector<CPiece>::const_iterator l_itOuter = outer_loops.begin(); (l_itOuter != outer_loops.end()) && (! within); l_itOuter++)
+			{
+				const CPiece & outer = *l_itOuter;
+				if ((std::min(a.X(), b.X()) < outer.m_min_x - tolerance) || (std::max(a.X(), b.X()) > outer.m_max_x + tolerance) ||
+					(std::min(a.Y(), b.Y()) < outer.m_min_y - tolerance) || (std::max(a.Y(), b.Y()) > outer.m_max_y + tolerance)) continue;
+				if ((! InsideOrOn(outer.m_outline, a, tolerance)) || (! InsideOrOn(outer.m_outline, b, tolerance))) continue;
+
+				within = true;
+				for (Polygon_t::size_type j = 0; (j < outer.m_outline.size()) && within; j++)
+				{
+					if (Crosses(a, b, outer.m_outline[j], outer.m_outline[(j + 1) % outer.m_outline.size()], tolerance)) within = false;
+				}
+			} // End for
+
+			if (within) continue;
+
+			Polygon_t segment;
+			segment.push_back(a);
+			if (b.Distance(a) > 0.0) segment.push_back(b);
+			segments.push_back(segment);
+		} // End for
+	} // End for
+
+	if (segments.size() <= 32)
+	{
+		pieces.insert(pieces.end(), segments.begin(), segments.end());
+	}
+	else
+	{
+		// Too many to handle one by one.  Cover them all at once.
+		std::vector<gp_Pnt2d> points;
+		for (std::vector<Polygon_t>::const_iterator l_itSegment = segments.begin(); l_itSegment != segments.end(); l_itSegment++)
+		{
+			points.insert(points.end(), l_itSegment->begin(), l_itSegment->end());
+		}
+		pieces.push_back(ConvexHull(points));
+	}
+
+	if (pieces.size() == 0)
+	{
+		if (all_points.size() == 0) all_points.push_back(gp_Pnt2d(0.0, 0.0));
+		pieces.push_back(ConvexHull(all_points));
+	}
+
+	for (std::vector<Polygon_t>::iterator l_itPiece = pieces.begin(); l_itPiece != pieces.end(); l_itPiece++)
+	{
+		*l_itPiece = Grow(*l_itPiece, tool_radius + m_gap / 2.0 + tolerance);
+	}
+
+	// Turn it to each of the rotation steps.
+	CShape shape;
+	for (int rotation = 0; rotation < m_rotations; rotation++)
+	{
+		COrientation orientation;
+		orientation.m_angle = 360.0 * rotation / m_rotations;
+
+		double c = cos(orientation.m_angle * PI / 180.0);
+		double s = sin(orientation.m_angle * PI / 180.0);
+		for (std::vector<Polygon_t>::const_iterator l_itPiece = pieces.begin(); l_itPiece != pieces.end(); l_itPiece++)
+		{
+			Polygon_t rotated;
+			for (Polygon_t::const_iterator l_itPoint = l_itPiece->begin(); l_itPoint != l_itPiece->end(); l_itPoint++)
+			{
+				rotated.push_back(gp_Pnt2d(l_itPoint->X() * c - l_itPoint->Y() * s, l_itPoint->X() * s + l_itPoint->Y() * c));
+			}
+
+			CPiece piece(rotated);
+			bool first = (orientation.m_pieces.size() == 0);
+			if (first || (piece.m_min_x < orientation.m_min_x)) orientation.m_min_x = piece.m_min_x;
+			if (first || (piece.m_max_x > orientation.m_max_x)) orientation.m_max_x = piece.m_max_x;
+			if (first || (piece.m_min_y < orientation.m_min_y)) orientation.m_min_y = piece.m_min_y;
+			if (first || (piece.m_max_y > orientation.m_max_y)) orientation.m_max_y = piece.m_max_y;
+			orientation.m_pieces.push_back(piece);
+		}
+
+		shape.m_orientations.push_back(orientation);
+	} // End for
+
+	const COrientation & unrotated = shape.m_orientations[0];
+	shape.m_area = (unrotated.m_max_x - unrotated.m_min_x) * (unrotated.m_max_y - unrotated.m_min_y);
+
+	m_shapes.push_back(shape);
+	return(int(m_shapes.size() - 1));
+}
+
+/**
+	The moving shape overlaps the fixed one (placed at the origin) if, and only if, its
+	position is strictly inside one of the pieces of this polygon, i.e. if one of the moving
+	shape's convex pieces overlaps one of the fixed shape's.  The corners are the places
+	where the two can touch in more than one place, which is where they fit best together.
+
+	This doesn't use anything but the two orientations, so it can be run on a worker thread.
+ */
+/* static */ void CShapeNester::MakeNoFitPolygon( const COrientation & fixed, const COrientation & moving, CNoFitPolygon & nfp )
+{
+	nfp.m_pieces.clear();
+	nfp.m_corners.clear();
+	nfp.m_cells.clear();
+
+	double size = 0.0;
+	for (std::vector<CPiece>::const_iterator l_itFixed = fixed.m_pieces.begin(); l_itFixed != fixed.m_pieces.end(); l_itFixed++)
+	{
+		for (std::vector<CPiece>::const_iterator l_itMoving = moving.m_pieces.begin(); l_itMoving != moving.m_pieces.end(); l_itMoving++)
+		{
+			std::vector<gp_Pnt2d> points;
+			for (Polygon_t::const_iterator l_itF = l_itFixed->m_outline.begin(); l_itF != l_itFixed->m_outline.end(); l_itF++)
+			{
+				for (Polygon_t::const_iterator l_itM = l_itMoving->m_outline.begin(); l_itM != l_itMoving->m_outline.end(); l_itM++)
+				{
+					points.push_back(gp_Pnt2d(l_itF->X() - l_itM->X(), l_itF->Y() - l_itM->Y()));
+				}
+			}
+
+			nfp.m_pieces.push_back(CPiece(ConvexHull(points)));
+			size += std::max(nfp.m_pieces.back().m_max_x - nfp.m_pieces.back().m_min_x, nfp.m_pieces.back().m_max_y - nfp.m_pieces.back().m_min_y);
+		} // End for
+	} // End for
+
+	// Index the pieces by the cells their bounding boxes touch.  The cells are about the size of a piece.
+	nfp.m_cell_size = (nfp.m_pieces.size() > 0)?(size / nfp.m_pieces.size()):0.0;
+	if (nfp.m_cell_size <= 0.0) nfp.m_cell_size = 1.0;
+	for (std::vector<CPiece>::size_type i = 0; i < nfp.m_pieces.size(); i++)
+	{
+		const CPiece & piece = nfp.m_pieces[i];
+		Cell_t lower = nfp.Cell(gp_Pnt2d(piece.m_min_x, piece.m_min_y));
+		Cell_t upper = nfp.Cell(gp_Pnt2d(piece.m_max_x, piece.m_max_y));
+		for (int column = lower.first; column <= upper.first; column++)
+		{
+			for (int row = lower.second; row <= upper.second; row++)
+			{
+				nfp.m_cells[Cell_t(column, row)].push_back(int(i));
+			}
+		}
+	}
+
+	// The union's corners are the pieces' vertices and the places where their edges cross,
+	// wherever they aren't inside another piece.
+	std::vector<gp_Pnt2d> points;
+	std::set< std::pair<int, int> > compared;
+	for (std::map< Cell_t, std::vector<int> >::const_iterator l_itCell = nfp.m_cells.begin(); l_itCell != nfp.m_cells.end(); l_itCell++)
+	{
+		for (std::vector<int>::const_iterator l_itFirst = l_itCell->second.begin(); l_itFirst != l_itCell->second.end(); l_itFirst++)
+		{
+			for (std::vector<int>::const_iterator l_itSecond = l_itFirst + 1; l_itSecond != l_itCell->second.end(); l_itSecond++)
+			{
+				if (! compared.insert(std::make_pair(*l_itFirst, *l_itSecond)).second) continue;
+
+				const CPiece & first = nfp.m_pieces[*l_itFirst];
+				const CPiece & second = nfp.m_pieces[*l_itSecond];
+				if ((first.m_min_x > second.m_max_x) || (first.m_max_x < second.m_min_x) || (first.m_min_y > second.m_max_y) || (first.m_max_y < second.m_min_y)) continue;
+
+				for (Polygon_t::size_type i = 0; i < first.m_outline.size(); i++)
+				{
+					const gp_Pnt2d & a = first.m_outline[i];
+					const gp_Pnt2d & b = first.m_outline[(i + 1) % first.m_outline.size()];
+					if ((std::min(a.X(), b.X()) > second.m_max_x) || (std::max(a.X(), b.X()) < second.m_min_x) ||
+						(std::min(a.Y(), b.Y()) > second.m_max_y) || (std::max(a.Y(), b.Y()) < second.m_min_y)) continue;
+
+					for (Polygon_t::size_type j = 0; j < second.m_outline.size(); j++)
+					{
+						gp_Pnt2d point;
+						if (Intersection(a, b, second.m_outline[j], second.m_outline[(j + 1) % second.m_outline.size()], point)) points.push_back(point);
+					}
+				} // End for
+			} // End for
+		} // End for
+	} // End for
+
+	for (std::vector<CPiece>::const_iterator l_itPiece = nfp.m_pieces.begin(); l_itPiece != nfp.m_pieces.end(); l_itPiece++)
+	{
+		points.insert(points.end(), l_itPiece->m_outline.begin(), l_itPiece->m_outline.end());
+	}
+
+	for (std::vector<gp_Pnt2d>::const_iterator l_itPoint = points.begin(); l_itPoint != points.end(); l_itPoint++)
+	{
+		if (! nfp.StrictlyInside(*l_itPoint)) nfp.m_corners.push_back(*l_itPoint);
+	}
+}
+
+/**
+	Only for pairs already worked out by MakeNoFitPolygons().
+ */
+const CShapeNester::CNoFitPolygon & CShapeNester::NoFitPolygon( const Oriented_t & fixed, const Oriented_t & moving ) const
+{
+	return(m_no_fit_polygons.find(std::make_pair(fixed, moving))->second);
+}
+
+/**
+	Work out any no-fit polygons that placing the shape at these rotations will need, i.e.
+	between it and each of the (shape, rotation) pairs placed so far.
+ */
+void CShapeNester::MakeNoFitPolygons( const int shape, const std::vector<bool> & allowed )
+{
+	std::set<Oriented_t> fixed;
+	for (std::vector<int>::const_iterator l_itPlaced = m_placed.begin(); l_itPlaced != m_placed.end(); l_itPlaced++)
+	{
+		fixed.insert(Oriented_t(m_parts[*l_itPlaced].m_shape, m_parts[*l_itPlaced].m_orientation));
+	}
+
+	std::vector< std::pair<Oriented_t, Oriented_t> > keys;
+	std::vector<CNoFitPolygon *> no_fit_polygons;
+	for (std::set<Oriented_t>::const_iterator l_itFixed = fixed.begin(); l_itFixed != fixed.end(); l_itFixed++)
+	{
+		for (std::vector<bool>::size_type rotation = 0; rotation < allowed.size(); rotation++)
+		{
+			if (! allowed[rotation]) continue;
+
+			std::pair<Oriented_t, Oriented_t> key(*l_itFixed, Oriented_t(shape, int(rotation)));
+			if (m_no_fit_polygons.find(key) != m_no_fit_polygons.end()) continue;
+
+			// Make room for it here.  The jobs only fill them in.
+			keys.push_back(key);
+			no_fit_polygons.push_back(&(m_no_fit_polygons[key]));
+		}
+	}
+
+	if (keys.size() == 0) return;
+
+	std::vector<CNoFitJob> jobs(std::min((unsigned int) keys.size(), CWorkerThreads::Count()));
+	std::vector<CWorkerJob *> job_pointers;
+	for (std::vector<CNoFitJob>::size_type i = 0; i < jobs.size(); i++)
+	{
+		jobs[i].m_pNester = this;
+		jobs[i].m_pKeys = &keys;
+		jobs[i].m_pNoFitPolygons = &no_fit_polygons;
+		jobs[i].m_first = i;
+		jobs[i].m_step = jobs.size();
+		job_pointers.push_back(&(jobs[i]));
+	}
+	CWorkerThreads::Run(job_pointers);
+}
+
+CShapeNester::Cell_t CShapeNester::Cell( const double x, const double y ) const
+{
+	return(Cell_t( int(floor(x / m_cell_size)), int(floor(y / m_cell_size)) ));
+}
+
+/**
+	Remember which cells the placed part's bounding box covers.
+ */
+void CShapeNester::Index( const int part )
+{
+	const COrientation & orientation = Orientation(Oriented_t(m_parts[part].m_shape, m_parts[part].m_orientation));
+	const gp_Pnt2d & position = m_parts[part].m_position;
+
+	Cell_t lower = Cell(position.X() + orientation.m_min_x, position.Y() + orientation.m_min_y);
+	Cell_t upper = Cell(position.X() + orientation.m_max_x, position.Y() + orientation.m_max_y);
+	for (int column = lower.first; column <= upper.first; column++)
+	{
+		for (int row = lower.second; row <= upper.second; row++)
+		{
+			m_cells[Cell_t(column, row)].push_back(part);
+		}
+	}
+}
+
+/**
+	Returns true if the shape, at this rotation, would overlap any part placed so far if it
+	were put at this position.  It doesn't change anything so the candidate jobs can all
+	call it at once.
+ */
+bool CShapeNester::Overlaps( const Oriented_t & oriented, const gp_Pnt2d & position ) const
+{
+	const COrientation & moving = Orientation(oriented);
+	double min_x = position.X() + moving.m_min_x;
+	double max_x = position.X() + moving.m_max_x;
+	double min_y = position.Y() + moving.m_min_y;
+	double max_y = position.Y() + moving.m_max_y;
+
+	std::set<int> checked;
+	Cell_t lower = Cell(min_x, min_y);
+	Cell_t upper = Cell(max_x, max_y);
+	for (int column = lower.first; column <= upper.first; column++)
+	{
+		for (int row = lower.second; row <= upper.second; row++)
+		{
+			std::map< Cell_t, std::vector<int> >::const_iterator l_itCell = m_cells.find(Cell_t(column, row));
+			if (l_itCell == m_cells.end()) continue;
+
+			for (std::vector<int>::const_iterator l_itPart = l_itCell->second.begin(); l_itPart != l_itCell->second.end(); l_itPart++)
+			{
+				if (! checked.insert(*l_itPart).second) continue;
+
+				const CPart & part = m_parts[*l_itPart];
+				Oriented_t fixed_oriented(part.m_shape, part.m_orientation);
+				const COrientation & fixed = Orientation(fixed_oriented);
+				if ((min_x >= part.m_position.X() + fixed.m_max_x) || (max_x <= part.m_position.X() + fixed.m_min_x) ||
+					(min_y >= part.m_position.Y() + fixed.m_max_y) || (max_y <= part.m_position.Y() + fixed.m_min_y)) continue;
+
+				gp_Pnt2d relative(position.X() - part.m_position.X(), position.Y() - part.m_position.Y());
+				if (NoFitPolygon(fixed_oriented, oriented).StrictlyInside(relative)) return(true);
+			} // End for
+		} // End for
+	} // End for
+
+	return(false);
+}
+
+/**
+	Where the line (x = c when vertical, else y = c) crosses the convex polygon.  Returns false if it doesn't.
+ */
+static bool Crossing( const CShapeNester::Polygon_t & polygon, const bool vertical, const double c, double *pLow, double *pHigh )
+{
+	bool crosses = false;
+	for (CShapeNester::Polygon_t::size_type i = 0; i < polygon.size(); i++)
+	{
+		const gp_Pnt2d & a = polygon[i];
+		const gp_Pnt2d & b = polygon[(i + 1) % polygon.size()];
+		double a_c = vertical?a.X():a.Y(), b_c = vertical?b.X():b.Y();
+		double a_v = vertical?a.Y():a.X(), b_v = vertical?b.Y():b.X();
+		if ((c < std::min(a_c, b_c)) || (c > std::max(a_c, b_c))) continue;
+
+		double value = (a_c == b_c)?a_v:(a_v + (b_v - a_v) * (c - a_c) / (b_c - a_c));
+		if ((! crosses) || (value < *pLow)) *pLow = value;
+		if ((! crosses) || (value > *pHigh)) *pHigh = value;
+		if (a_c == b_c)
+		{
+			*pLow = std::min(*pLow, b_v);
+			*pHigh = std::max(*pHigh, b_v);
+		}
+		crosses = true;
+	}
+
+	return(crosses);
+}
+
+/**
+	Move the shape, from a position where it doesn't overlap anything, down and then left until
+	it touches the parts already placed (or the edges of the panel).  Moving along a line only
+	stops where that line enters one of the pieces of the no-fit polygons, i.e. at the highest
+	(or rightmost) point below the shape where the line leaves one of them.
+ */
+gp_Pnt2d CShapeNester::Slide( const Oriented_t & oriented, gp_Pnt2d position ) const
+{
+	const COrientation & moving = Orientation(oriented);
+	const double tolerance = 1e-7;
+
+	for (int pass = 0; pass < 20; pass++)
+	{
+		gp_Pnt2d start = position;
+		for (int direction = 0; direction < 2; direction++)
+		{
+			bool vertical = (direction == 0);	// i.e. moving down.
+			double c = vertical?position.X():position.Y();
+			double limit = vertical?(-moving.m_min_y):(-moving.m_min_x);
+			double current = vertical?position.Y():position.X();
+
+			for (std::vector<int>::const_iterator l_itPlaced = m_placed.begin(); l_itPlaced != m_placed.end(); l_itPlaced++)
+			{
+				const CPart & placed = m_parts[*l_itPlaced];
+				Oriented_t fixed_oriented(placed.m_shape, placed.m_orientation);
+				const COrientation & fixed = Orientation(fixed_oriented);
+
+				// Only parts alongside the line of travel can get in the way.
+				if (vertical)
+				{
+					if ((position.X() + moving.m_min_x >= placed.m_position.X() + fixed.m_max_x) || (position.X() + moving.m_max_x <= placed.m_position.X() + fixed.m_min_x)) continue;
+				}
+				else
+				{
+					if ((position.Y() + moving.m_min_y >= placed.m_position.Y() + fixed.m_max_y) || (position.Y() + moving.m_max_y <= placed.m_position.Y() + fixed.m_min_y)) continue;
+				}
+
+				double offset_c = vertical?placed.m_position.X():placed.m_position.Y();
+				double offset_v = vertical?placed.m_position.Y():placed.m_position.X();
+				const CNoFitPolygon & nfp = NoFitPolygon(fixed_oriented, oriented);
+				for (std::vector<CPiece>::const_iterator l_itPiece = nfp.m_pieces.begin(); l_itPiece != nfp.m_pieces.end(); l_itPiece++)
+				{
+					if (vertical)
+					{
+						if ((c - offset_c < l_itPiece->m_min_x) || (c - offset_c > l_itPiece->m_max_x)) continue;
+					}
+					else
+					{
+						if ((c - offset_c < l_itPiece->m_min_y) || (c - offset_c > l_itPiece->m_max_y)) continue;
+					}
+
+					double low, high;
+					if (! Crossing(l_itPiece->m_outline, vertical, c - offset_c, &low, &high)) continue;
+					if ((high + offset_v <= current + tolerance) && (high + offset_v > limit)) limit = high + offset_v;
+				} // End for
+			} // End for
+
+			if (limit < current)
+			{
+				if (vertical) position.SetY(limit);
+				else position.SetX(limit);
+			}
+		} // End for
+
+		if (start.Distance(position) < tolerance) break;
+	} // End for
+
+	return(position);
+}
+
+/**
+	Place every part and move its NC code into position.  Returns the length of the panel used.
+ */
+double CShapeNester::Nest()
+{
+	m_placed.clear();
+	m_cells.clear();
+
+	// The grid's cells are about the size of the largest part.
+	m_cell_size = 0.0;
+	for (std::vector<CShape>::const_iterator l_itShape = m_shapes.begin(); l_itShape != m_shapes.end(); l_itShape++)
+	{
+		for (std::vector<COrientation>::const_iterator l_itOrientation = l_itShape->m_orientations.begin(); l_itOrientation != l_itShape->m_orientations.end(); l_itOrientation++)
+		{
+			m_cell_size = std::max(m_cell_size, std::max(l_itOrientation->m_max_x - l_itOrientation->m_min_x, l_itOrientation->m_max_y - l_itOrientation->m_min_y));
+		}
+	}
+	if (m_cell_size <= 0.0) m_cell_size = 10.0;
+
+	// Largest parts first.  The small ones then fill in the gaps around them.
+	std::vector< std::pair<double, int> > order;
+	for (std::vector<CPart>::size_type i = 0; i < m_parts.size(); i++)
+	{
+		order.push_back(std::make_pair(-m_shapes[m_parts[i].m_shape].m_area, int(i)));
+	}
+	std::sort(order.begin(), order.end());
+
+	const double tolerance = 1e-7;
+	double length = 0.0;
+	for (std::vector< std::pair<double, int> >::const_iterator l_itOrder = order.begin(); l_itOrder != order.end(); l_itOrder++)
+	{
+		CPart & part = m_parts[l_itOrder->second];
+		const CShape & shape = m_shapes[part.m_shape];
+
+		// Only try the rotations that fit across the panel (or all of them if none do).
+		std::vector<bool> allowed(shape.m_orientations.size(), false);
+		int rotations = 0;
+		for (std::vector<COrientation>::size_type i = 0; i < shape.m_orientations.size(); i++)
+		{
+			const COrientation & orientation = shape.m_orientations[i];
+			if (orientation.m_max_x - orientation.m_min_x > m_width + tolerance) continue;
+			allowed[i] = true;
+			rotations++;
+		}
+		if (rotations == 0)
+		{
+			allowed.assign(shape.m_orientations.size(), true);
+			rotations = int(shape.m_orientations.size());
+		}
+
+		MakeNoFitPolygons(part.m_shape, allowed);
+
+		// Try the bottom left corner of the panel and the corners of every no-fit polygon.
+		std::vector<CCandidate> candidates;
+		for (std::vector<COrientation>::size_type i = 0; i < shape.m_orientations.size(); i++)
+		{
+			if (! allowed[i]) continue;
+
+			const COrientation & orientation = shape.m_orientations[i];
+			Oriented_t oriented(part.m_shape, int(i));
+
+			// The part's origin must stay within these limits to keep the part on the panel.
+			double left = -orientation.m_min_x;
+			double right = std::max(left, m_width - orientation.m_max_x);
+			double bottom = -orientation.m_min_y;
+
+			candidates.push_back(CCandidate(gp_Pnt2d(left, bottom), int(i), orientation));
+			candidates.push_back(CCandidate(gp_Pnt2d(left, std::max(bottom, length - orientation.m_min_y)), int(i), orientation));	// Always fits.
+			for (std::vector<int>::const_iterator l_itPlaced = m_placed.begin(); l_itPlaced != m_placed.end(); l_itPlaced++)
+			{
+				const CPart & placed = m_parts[*l_itPlaced];
+				const CNoFitPolygon & nfp = NoFitPolygon(Oriented_t(placed.m_shape, placed.m_orientation), oriented);
+				for (std::vector<gp_Pnt2d>::const_iterator l_itPoint = nfp.m_corners.begin(); l_itPoint != nfp.m_corners.end(); l_itPoint++)
+				{
+					double x = l_itPoint->X() + placed.m_position.X();
+					double y = std::max(bottom, l_itPoint->Y() + placed.m_position.Y());
+
+					if ((x >= left - tolerance) && (x <= right + tolerance)) candidates.push_back(CCandidate(gp_Pnt2d(std::min(right, std::max(left, x)), y), int(i), orientation));
+					candidates.push_back(CCandidate(gp_Pnt2d(left, y), int(i), orientation));	// slid across to the panel's edge.
+				}
+			}
+		} // End for
+
+		std::sort(candidates.begin(), candidates.end());
+
+		// Find the first candidate at each rotation that doesn't overlap anything.
+		std::vector<CCandidateJob> jobs(std::min((unsigned int) candidates.size(), CWorkerThreads::Count()));
+		std::vector<CWorkerJob *> job_pointers;
+		for (std::vector<CCandidateJob>::size_type i = 0; i < jobs.size(); i++)
+		{
+			jobs[i].m_pNester = this;
+			jobs[i].m_pCandidates = &candidates;
+			jobs[i].m_shape = part.m_shape;
+			jobs[i].m_rotations = rotations;
+			jobs[i].m_first = i;
+			jobs[i].m_step = jobs.size();
+			jobs[i].m_found.assign(shape.m_orientations.size(), -1);
+			job_pointers.push_back(&(jobs[i]));
+		}
+		CWorkerThreads::Run(job_pointers);
+
+		std::vector<int> found(shape.m_orientations.size(), -1);
+		for (std::vector<CCandidateJob>::const_iterator l_itJob = jobs.begin(); l_itJob != jobs.end(); l_itJob++)
+		{
+			for (std::vector<int>::size_type i = 0; i < found.size(); i++)
+			{
+				if ((l_itJob->m_found[i] >= 0) && ((found[i] < 0) || (l_itJob->m_found[i] < found[i]))) found[i] = l_itJob->m_found[i];
+			}
+		}
+
+		// Slide each rotation's into place and keep the one that ends up lowest.
+		std::vector<CCandidate> placements;
+		for (std::vector<int>::size_type i = 0; i < found.size(); i++)
+		{
+			if (found[i] < 0) continue;
+
+			const CCandidate & candidate = candidates[found[i]];
+			Oriented_t oriented(part.m_shape, int(i));
+			gp_Pnt2d position = Slide(oriented, candidate.m_position);
+			if (Overlaps(oriented, position)) position = candidate.m_position;
+			placements.push_back(CCandidate(position, int(i), shape.m_orientations[i]));
+		}
+
+		if (placements.size() == 0) placements.push_back(CCandidate(gp_Pnt2d(-shape.m_orientations[0].m_min_x, length - shape.m_orientations[0].m_min_y), 0, shape.m_orientations[0]));
+		// Rotating can leave a part a rounding error lower.  That's not worth turning it for.
+		std::vector<CCandidate>::size_type best_index = 0;
+		for (std::vector<CCandidate>::size_type i = 1; i < placements.size(); i++)
+		{
+			const CCandidate & best = placements[best_index];
+			if ((placements[i].m_top < best.m_top - tolerance) ||
+				((placements[i].m_top <= best.m_top + tolerance) && (placements[i].m_left < best.m_left - tolerance))) best_index = i;
+		}
+
+		const CCandidate & best = placements[best_index];
+		part.m_orientation = best.m_orientation;
+		part.m_position = best.m_position;
+
+		m_placed.push_back(l_itOrder->second);
+		Index(l_itOrder->second);
+		length = std::max(length, best.m_top);
+
+		part.m_code->m_x = part.m_position.X();
+		part.m_code->m_y = part.m_position.Y();
+		part.m_code->m_angle = shape.m_orientations[part.m_orientation].m_angle;
+	} // End for
+
+	return(length);
+}
+
+void CShapeNester::GetBox( const CTrsfNCCode *code, CBox & box ) const
+{
+	for (std::vector<CPart>::const_iterator l_itPart = m_parts.begin(); l_itPart != m_parts.end(); l_itPart++)
+	{
+		if (l_itPart->m_code != code) continue;
+
+		const COrientation & orientation = Orientation(Oriented_t(l_itPart->m_shape, l_itPart->m_orientation));
+		double min[3] = { l_itPart->m_position.X() + orientation.m_min_x, l_itPart->m_position.Y() + orientation.m_min_y, 0.0 };
+		double max[3] = { l_itPart->m_position.X() + orientation.m_max_x, l_itPart->m_position.Y() + orientation.m_max_y, 0.0 };
+		box.Insert(min);
+		box.Insert(max);
+	}
+}
@@ -0,0 +1,147 @@
+// ShapeNester.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include <gp_Pnt2d.hxx>
+
+#include <map>
+#include <vector>
+#include <utility>
+
+class CTrsfNCCode;
+class CNCCode;
+class CBox;
+
+/**
+	The CShapeNester class arranges blocks of NC code on a panel by the shapes they cut rather
+	than by their bounding boxes, turning them to one of a number of rotation steps as it goes.
+
+	A part's outline is the closed loop its toolpath follows around the outside of the part
+	(i.e. its profile cut), as backplotted.  Anything cut inside that loop is inside the part.
+	Any feed moves left over (lead-ins, engraving or parts without a profile) are added as
+	line segments.  The outline is split into convex pieces (ear clipping followed by
+	Hertel-Mehlhorn) and each piece is grown by the cutting tool's radius plus half the gap
+	wanted between parts.  Holes within a part are not used to hold other parts.
+
+	Parts are placed, largest first, at the lowest position where they touch but don't overlap
+	those already placed.  Those positions are found from the no-fit polygons (NFP) of each pair
+	of outlines, i.e. the places one outline's origin can't go without overlapping the other.
+	The NFP of two convex pieces is their Minkowski difference and the NFP of two outlines is the
+	union of those of their pieces.  NFPs only depend on the two outlines and their rotations so
+	they're calculated once for each pair (a BOM usually holds many copies of each part).
+
+	The NFPs and the candidate positions are worked through on CWorkerThreads.
+ */
+class CShapeNester
+{
+public:
+	typedef std::vector<gp_Pnt2d> Polygon_t;	// convex, anti-clockwise (unless stated otherwise)
+
+	CShapeNester( const double width, const double gap, const int rotations );
+
+	void Add( CTrsfNCCode *code );
+	double Nest();	// returns the length of the panel used.
+	void GetBox( const CTrsfNCCode *code, CBox & box ) const;	// of the part's outline, once nested.
+
+	static Polygon_t ConvexHull( std::vector<gp_Pnt2d> points );
+	static Polygon_t Grow( const Polygon_t & polygon, const double distance );
+	static bool StrictlyInside( const Polygon_t & polygon, const gp_Pnt2d & point );
+	static std::vector<Polygon_t> ConvexPieces( const Polygon_t & polygon );	// of a simple, anti-clockwise polygon
+
+private:
+	typedef std::pair<int, int> Cell_t;
+	typedef std::pair<int, int> Oriented_t;		// (shape, orientation)
+
+	class CPiece
+	{
+	public:
+		CPiece( const Polygon_t & outline );
+
+		Polygon_t m_outline;
+		double m_min_x, m_min_y, m_max_x, m_max_y;
+	}; // End CPiece class definition.
+
+	/**
+		A shape turned to one of the rotation steps.
+	 */
+	class COrientation
+	{
+	public:
+		COrientation() : m_angle(0.0), m_min_x(0.0), m_min_y(0.0), m_max_x(0.0), m_max_y(0.0) { }
+
+		double m_angle;		// degrees
+		std::vector<CPiece> m_pieces;
+		double m_min_x, m_min_y, m_max_x, m_max_y;
+	}; // End COrientation class definition.
+
+	class CShape
+	{
+	public:
+		std::vector<COrientation> m_orientations;	// one for each rotation step
+		double m_area;		// of its bounding box, unrotated.
+	}; // End CShape class definition.
+
+	class CPart
+	{
+	public:
+		CPart( CTrsfNCCode *code, const int shape ) : m_code(code), m_shape(shape), m_orientation(0) { }
+
+		CTrsfNCCode *m_code;
+		int m_shape;				// index into m_shapes
+		int m_orientation;			// index into the shape's m_orientations
+		gp_Pnt2d m_position;		// translation applied to the shape once it's rotated
+	}; // End CPart class definition.
+
+	class CNoFitPolygon
+	{
+	public:
+		CNoFitPolygon() : m_cell_size(1.0) { }
+
+		Cell_t Cell( const gp_Pnt2d & point ) const;
+		bool StrictlyInside( const gp_Pnt2d & point ) const;
+
+		std::vector<CPiece> m_pieces;
+		std::vector<gp_Pnt2d> m_corners;	// the pieces' vertices that aren't inside any other piece
+		double m_cell_size;
+		std::map< Cell_t, std::vector<int> > m_cells;	// pieces whose bounding boxes touch each cell
+	}; // End CNoFitPolygon class definition.
+
+	class CCandidate
+	{
+	public:
+		CCandidate( const gp_Pnt2d & position, const int orientation, const COrientation & shape );
+		bool operator< ( const CCandidate & rhs ) const;
+
+		gp_Pnt2d m_position;
+		int m_orientation;
+		double m_top, m_left;	// of the part if it's placed here
+	}; // End CCandidate class definition.
+
+	class CNoFitJob;
+	class CCandidateJob;
+	friend class CNoFitJob;
+	friend class CCandidateJob;
+
+	int AddShape( CNCCode *code );
+	static void MakeNoFitPolygon( const COrientation & fixed, const COrientation & moving, CNoFitPolygon & nfp );
+	const COrientation & Orientation( const Oriented_t & oriented ) const { return(m_shapes[oriented.first].m_orientations[oriented.second]); }
+	const CNoFitPolygon & NoFitPolygon( const Oriented_t & fixed, const Oriented_t & moving ) const;
+	void MakeNoFitPolygons( const int shape, const std::vector<bool> & allowed );
+	bool Overlaps( const Oriented_t & oriented, const gp_Pnt2d & position ) const;
+	gp_Pnt2d Slide( const Oriented_t & oriented, gp_Pnt2d position ) const;
+	Cell_t Cell( const double x, const double y ) const;
+	void Index( const int part );
+
+	double m_width;
+	double m_gap;
+	int m_rotations;
+	double m_cell_size;
+	std::vector<CShape> m_shapes;
+	std::map< const CNCCode *, int > m_shape_ids;	// NC code -> index into m_shapes
+	std::vector<CPart> m_parts;
+	std::vector<int> m_placed;		// indices into m_parts
+	std::map< std::pair<Oriented_t, Oriented_t>, CNoFitPolygon > m_no_fit_polygons;	// (fixed, moving)
+	std::map< Cell_t, std::vector<int> > m_cells;	// placed parts whose bounding boxes touch each cell
+}; // End CShapeNester class definition.
@@ -0,0 +1,125 @@
+// SketchWires.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "SketchWires.h"
+#include "interface/HeeksObj.h"
+#include "interface/Box.h"
+
+#include <TopoDS.hxx>
+#include <TopoDS_Wire.hxx>
+#include <ShapeFix_Wire.hxx>
+
+/**
+	Return the sketch's wires, each one already reordered by ShapeFix_Wire, or NULL if
+	HeeksCAD can't convert the sketch.  The wires are shared with any other operation
+	that uses this sketch so take a copy before adjusting them.
+ */
+const std::list<TopoDS_Shape> *CSketchWires::Wires( HeeksObj *sketch )
+{
+	return(Convert( sketch, false ));
+}
+
+/**
+	Return the faces made from the sketch or NULL if HeeksCAD can't convert it.
+ */
+const std::list<TopoDS_Shape> *CSketchWires::Faces( HeeksObj *sketch )
+{
+	return(Convert( sketch, true ));
+}
+
+const std::list<TopoDS_Shape> *CSketchWires::Convert( HeeksObj *sketch, const bool faces )
+{
+	if (sketch == NULL) return(NULL);
+
+	Key_t key( std::make_pair( sketch->m_id, faces ), Fingerprint( sketch ) );
+	Shapes_t::iterator l_itEntry = m_shapes.find( key );
+	if (l_itEntry == m_shapes.end())
+	{
+		// Any earlier version of this sketch won't be asked for again.
+		for (Shapes_t::iterator l_itOld = m_shapes.begin(); l_itOld != m_shapes.end(); /* increment within loop */ )
+		{
+			if (l_itOld->first.first == key.first) m_shapes.erase( l_itOld++ );
+			else l_itOld++;
+		}
+
+		l_itEntry = m_shapes.insert( std::make_pair( key, CEntry() ) ).first;
+		CEntry & entry = l_itEntry->second;
+
+		std::list<TopoDS_Shape> shapes;
+		entry.m_converted = heeksCAD->ConvertSketchToFaceOrWire( sketch, shapes, faces );
+		if (entry.m_converted)
+		{
+			for (std::list<TopoDS_Shape>::iterator l_itShape = shapes.begin(); l_itShape != shapes.end(); l_itShape++)
+			{
+				if (faces)
+				{
+					entry.m_shapes.push_back( *l_itShape );
+				}
+				else
+				{
+					ShapeFix_Wire fix;
+					fix.Load( TopoDS::Wire(*l_itShape) );
+					fix.FixReorder();
+
+					entry.m_shapes.push_back( fix.Wire() );
+				}
+			} // End for
+		} // End if - then
+	} // End if - then
+
+	l_itEntry->second.m_used = true;
+	if (! l_itEntry->second.m_converted) return(NULL);
+	return(&(l_itEntry->second.m_shapes));
+} // End Convert() method
+
+/**
+	The sketch's own id doesn't change when its lines and arcs are edited so the
+	key also includes the geometry of each of its child objects.
+ */
+/* static */ std::vector<double> CSketchWires::Fingerprint( HeeksObj *sketch )
+{
+	std::vector<double> fingerprint;
+
+	for (HeeksObj *child = sketch->GetFirstChild(); child != NULL; child = sketch->GetNextChild())
+	{
+		fingerprint.push_back( child->GetType() );
+		fingerprint.push_back( child->m_id );
+
+		double pos[3];
+		if (child->GetStartPoint( pos )) fingerprint.insert( fingerprint.end(), pos, pos + 3 );
+		if (child->GetEndPoint( pos )) fingerprint.insert( fingerprint.end(), pos, pos + 3 );
+		if (child->GetCentrePoint( pos )) fingerprint.insert( fingerprint.end(), pos, pos + 3 );
+
+		CBox box;
+		child->GetBox( box );
+		fingerprint.insert( fingerprint.end(), box.m_x, box.m_x + 6 );
+	} // End for
+
+	return(fingerprint);
+} // End Fingerprint() method
+
+void CSketchWires::Begin()
+{
+	for (Shapes_t::iterator l_itEntry = m_shapes.begin(); l_itEntry != m_shapes.end(); l_itEntry++)
+	{
+		l_itEntry->second.m_used = false;
+	}
+}
+
+void CSketchWires::End()
+{
+	if (! m_keep_between_rewrites)
+	{
+		m_shapes.clear();
+		return;
+	}
+
+	// Keep only the sketches that are still in use.
+	for (Shapes_t::iterator l_itEntry = m_shapes.begin(); l_itEntry != m_shapes.end(); /* increment within loop */ )
+	{
+		if (! l_itEntry->second.m_used) m_shapes.erase( l_itEntry++ );
+		else l_itEntry++;
+	}
+}
@@ -0,0 +1,60 @@
+// SketchWires.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include <TopoDS_Shape.hxx>
+
+#include <list>
+#include <map>
+#include <vector>
+#include <utility>
+
+class HeeksObj;
+
+/**
+	The CSketchWires class holds the result of converting sketches into OpenCascade wires (or faces) so
+	that each sketch is converted, and its wires reordered, only once no matter how many operations
+	refer to it.  It is owned by the CProgram object.  RewritePythonProgram() calls Begin() before
+	asking the operations for their Python and End() once they're all done.
+
+	Each entry is keyed by the sketch's id and a fingerprint of its child objects (their types, ids,
+	end points, centre points and bounding boxes) so that an edited sketch is never matched with the
+	wires from before the edit.  If m_keep_between_rewrites is set then End() only discards the
+	entries that weren't used during that rewrite.  Otherwise it discards them all.
+ */
+class CSketchWires
+{
+public:
+	CSketchWires() : m_keep_between_rewrites(true) { }
+
+	const std::list<TopoDS_Shape> *Wires( HeeksObj *sketch );
+	const std::list<TopoDS_Shape> *Faces( HeeksObj *sketch );
+
+	void Begin();
+	void End();
+	void Clear() { m_shapes.clear(); }
+
+	bool m_keep_between_rewrites;
+
+private:
+	typedef std::pair< std::pair<int, bool>, std::vector<double> > Key_t;	// (sketch id, faces), fingerprint
+
+	class CEntry
+	{
+	public:
+		CEntry() : m_converted(false), m_used(false) { }
+
+		std::list<TopoDS_Shape> m_shapes;
+		bool m_converted;	// false if HeeksCAD couldn't convert the sketch.
+		bool m_used;		// during the current rewrite
+	}; // End CEntry class definition.
+
+	typedef std::map< Key_t, CEntry > Shapes_t;
+
+	const std::list<TopoDS_Shape> *Convert( HeeksObj *sketch, const bool faces );
+	static std::vector<double> Fingerprint( HeeksObj *sketch );
+
+	Shapes_t m_shapes;
+}; // End CSketchWires class definition.
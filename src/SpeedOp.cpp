@@ -43,7 +43,7 @@ void CSpeedOpParams::ResetFeeds(const int tool_number)
 		// Use the 'feeds and speeds' class along with the tool properties to
 		// help set some logical values for the spindle speed.
 
-		if ((tool_number > 0) && (CTool::Find( tool_number ) != NULL))
+		if (tool_number > 0)
 		{
 			CTool *pTool = CTool::Find( tool_number );
 			if (pTool != NULL)
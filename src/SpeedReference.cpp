@@ -34,10 +34,11 @@ static void on_set_tool_material(int zero_based_choice, HeeksObj* object)
 
 	pSpeedReference->m_tool_material = zero_based_choice;
 	pSpeedReference->ResetTitle();
+	pSpeedReference->InvalidateTable();
 	heeksCAD->RefreshProperties();
 }
 
-static void on_set_brinell_hardness_of_raw_material(double value, HeeksObj* object){((CSpeedReference*)object)->m_brinell_hardness_of_raw_material = value; ((CSpeedReference*)object)->ResetTitle(); }
+static void on_set_brinell_hardness_of_raw_material(double value, HeeksObj* object){((CSpeedReference*)object)->m_brinell_hardness_of_raw_material = value; ((CSpeedReference*)object)->ResetTitle(); ((CSpeedReference*)object)->InvalidateTable(); }
 
 /**
 	This is either expressed in metres per minute (when m_units = 1) or feet per minute (when m_units = 25.4).  These
@@ -61,9 +62,10 @@ static void on_set_surface_speed(double value, HeeksObj* object)
 	} // End if - else
 
 	((CSpeedReference*)object)->ResetTitle();
+	((CSpeedReference*)object)->InvalidateTable();
 }
 
-static void on_set_material_name(const wxChar *value, HeeksObj* object){((CSpeedReference*)object)->m_material_name = value; ((CSpeedReference*)object)->ResetTitle(); }
+static void on_set_material_name(const wxChar *value, HeeksObj* object){((CSpeedReference*)object)->m_material_name = value; ((CSpeedReference*)object)->ResetTitle(); ((CSpeedReference*)object)->InvalidateTable(); }
 
 
 const wxBitmap &CSpeedReference::GetIcon()
@@ -116,6 +118,18 @@ HeeksObj *CSpeedReference::MakeACopy(void)const
 void CSpeedReference::CopyFrom(const HeeksObj* object)
 {
 	operator=(*((CSpeedReference*)object));
+	InvalidateTable();
+}
+
+/**
+	Let the CSpeedReferences list know that its lookup table no longer reflects our values.
+ */
+void CSpeedReference::InvalidateTable()
+{
+	if ((theApp.m_program) && (theApp.m_program->SpeedReferences()))
+	{
+		theApp.m_program->SpeedReferences()->InvalidateTable();
+	}
 }
 
 bool CSpeedReference::CanAddTo(HeeksObj* owner)
@@ -181,7 +195,9 @@ void CSpeedReference::ResetTitle()
 
 	l_ossTitle << m_material_name.c_str() << " (" << m_brinell_hardness_of_raw_material << ") with " << materials_map[m_tool_material].c_str();
 
-	OnEditString(l_ossTitle.str().c_str());
+	// Don't use OnEditString() here.  This is called from the constructor and we don't want every
+	// reference read during an import to mark the whole document as changed.
+	m_title.assign(l_ossTitle.str().c_str());
 } // End ResetTitle() method
 
 
@@ -35,6 +35,7 @@ public:
 	double m_surface_speed;				// tool/material speed in metres per minute
 
 	void ResetTitle();
+	void InvalidateTable();
 	//	Constructors.
         CSpeedReference( const wxString &material_name,
 			const int tool_material,
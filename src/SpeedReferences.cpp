@@ -180,25 +180,85 @@ void CSpeedReferences::GetProperties(std::list<Property *> *list)
 }
 
 
+static bool sort_by_hardness( const std::pair< double, double > & lhs, const std::pair< double, double > & rhs )
+{
+	return(lhs.first < rhs.first);
+}
+
+const CSpeedReferences::Table_t & CSpeedReferences::Table()
+{
+	// Also check the number of children in case they've been changed without going through Add() or Remove()
+	if ((m_table_valid) && (m_table_num_children == GetNumChildren())) return(m_table);
+
+	m_table.clear();
+	m_materials.clear();
+	m_hardness_for_material.clear();
+	m_all_hardness_values.clear();
+
+	for (std::list<HeeksObj*>::iterator l_itObject = m_objects.begin(); l_itObject != m_objects.end(); l_itObject++)
+	{
+		if ((*l_itObject)->GetType() != SpeedReferenceType) continue;
+		CSpeedReference *pReference = (CSpeedReference *) *l_itObject;
+
+		m_table[ TableKey_t( pReference->m_material_name, pReference->m_tool_material ) ].push_back(
+			std::make_pair( pReference->m_brinell_hardness_of_raw_material, pReference->m_surface_speed ) );
+
+		m_materials.insert( pReference->m_material_name );
+		m_hardness_for_material[ pReference->m_material_name ].insert( pReference->m_brinell_hardness_of_raw_material );
+		m_all_hardness_values.insert( pReference->m_brinell_hardness_of_raw_material );
+	} // End for
+
+	for (Table_t::iterator l_itEntry = m_table.begin(); l_itEntry != m_table.end(); l_itEntry++)
+	{
+		// A stable sort keeps the first of any duplicate hardness values at the front.  That's the
+		// one we've always used.
+		std::stable_sort( l_itEntry->second.begin(), l_itEntry->second.end(), sort_by_hardness );
+	} // End for
+
+	m_table_num_children = GetNumChildren();
+	m_table_valid = true;
+	return(m_table);
+}
+
+/**
+	Find the surface speed for this combination of raw material and tool material.  If there
+	isn't a reference for this exact hardness, interpolate between the references either
+	side of it.  We don't extrapolate beyond the hardest or softest reference as that could
+	suggest an unreasonable speed.  Return -1 if there's not enough data.
+ */
+double CSpeedReferences::SurfaceSpeed( const wxString & material_name, const int tool_material, const double brinell_hardness_of_raw_material )
+{
+	const Table_t & table = Table();
+	Table_t::const_iterator l_itEntry = table.find( TableKey_t( material_name, tool_material ) );
+	if (l_itEntry == table.end()) return(-1.0);
+
+	const HardnessAxis_t & axis = l_itEntry->second;
+	HardnessAxis_t::const_iterator l_itUpper = std::lower_bound( axis.begin(), axis.end(),
+		std::make_pair( brinell_hardness_of_raw_material, 0.0 ), sort_by_hardness );
+
+	if (l_itUpper == axis.end()) return(-1.0);	// Harder than anything we know about.
+	if (l_itUpper->first == brinell_hardness_of_raw_material) return(l_itUpper->second);
+	if (l_itUpper == axis.begin()) return(-1.0);	// Softer than anything we know about.
+
+	HardnessAxis_t::const_iterator l_itLower = l_itUpper;
+	l_itLower--;
+
+	double proportion = (brinell_hardness_of_raw_material - l_itLower->first) / (l_itUpper->first - l_itLower->first);
+	return(l_itLower->second + (proportion * (l_itUpper->second - l_itLower->second)));
+}
+
 /**
 	This method finds a distinct set of material names from the SpeedReferences list.
  */
 std::set< wxString > CSpeedReferences::GetMaterials()
 {
-	std::set< wxString > materials;
 	if ((theApp.m_program) && (theApp.m_program->SpeedReferences()))
 	{
-		for (HeeksObj *material = theApp.m_program->SpeedReferences()->GetFirstChild();
-			material != NULL;
-			material = theApp.m_program->SpeedReferences()->GetNextChild())
-		{
-			if (material->GetType() != SpeedReferenceType) continue;
-
-			materials.insert( ((CSpeedReference *)material)->m_material_name );
-		} // End for
+		theApp.m_program->SpeedReferences()->Table();
+		return(theApp.m_program->SpeedReferences()->m_materials);
 	} // End if - then
 
-	return(materials);
+	return(std::set< wxString >());
 } // End GetMaterials() method
 
 /**
@@ -206,23 +266,16 @@ std::set< wxString > CSpeedReferences::GetMaterials()
  */
 std::set< double > CSpeedReferences::GetHardnessForMaterial( const wxString & material_name )
 {
-	std::set< double > hardness_values;
 	if ((theApp.m_program) && (theApp.m_program->SpeedReferences()))
 	{
-		for (HeeksObj *material = theApp.m_program->SpeedReferences()->GetFirstChild();
-			material != NULL;
-			material = theApp.m_program->SpeedReferences()->GetNextChild())
-		{
-			if (material->GetType() != SpeedReferenceType) continue;
+		CSpeedReferences *pSpeedReferences = theApp.m_program->SpeedReferences();
+		pSpeedReferences->Table();
 
-			if (material_name == ((CSpeedReference *) material)->m_material_name)
-			{
-				hardness_values.insert( ((CSpeedReference *) material)->m_brinell_hardness_of_raw_material );
-			} // End if - then
-		} // End for
+		std::map< wxString, std::set< double > >::const_iterator l_itMaterial = pSpeedReferences->m_hardness_for_material.find( material_name );
+		if (l_itMaterial != pSpeedReferences->m_hardness_for_material.end()) return(l_itMaterial->second);
 	} // End if - then
 
-	return(hardness_values);
+	return(std::set< double >());
 
 } // End of GetHardnessForMaterial() method
 
@@ -231,19 +284,13 @@ std::set< double > CSpeedReferences::GetHardnessForMaterial( const wxString & ma
  */
 std::set< double > CSpeedReferences::GetAllHardnessValues()
 {
-	std::set< double > hardness_values;
 	if ((theApp.m_program) && (theApp.m_program->SpeedReferences()))
 	{
-		for (HeeksObj *material = theApp.m_program->SpeedReferences()->GetFirstChild();
-			material != NULL;
-			material = theApp.m_program->SpeedReferences()->GetNextChild())
-		{
-			if (material->GetType() != SpeedReferenceType) continue;
-			hardness_values.insert( ((CSpeedReference *) material)->m_brinell_hardness_of_raw_material );
-		} // End for
+		theApp.m_program->SpeedReferences()->Table();
+		return(theApp.m_program->SpeedReferences()->m_all_hardness_values);
 	} // End if - then
 
-	return(hardness_values);
+	return(std::set< double >());
 
 } // End of GetAllHardnessValues() method
 
@@ -255,25 +302,22 @@ double CSpeedReferences::GetSurfaceSpeed(
 	if (theApp.m_program == NULL) return(-1.0);
 	if (theApp.m_program->SpeedReferences() == NULL) return(-1.0);
 
-	for (HeeksObj *material = theApp.m_program->SpeedReferences()->GetFirstChild();
-		material != NULL;
-		material = theApp.m_program->SpeedReferences()->GetNextChild())
-	{
-		if (material->GetType() != SpeedReferenceType) continue;
-		if ((material_name == ((CSpeedReference *) material)->m_material_name) &&
-		    (tool_material == ((CSpeedReference *) material)->m_tool_material) &&
-		    (brinell_hardness_of_raw_material == ((CSpeedReference *) material)->m_brinell_hardness_of_raw_material))
-		{
-			return( ((CSpeedReference *) material)->m_surface_speed );
-		} // End if - then
-	} // End for
-
-	// The data doesn't exist for this combination of inputs.
-	return(-1.0);
+	return(theApp.m_program->SpeedReferences()->SurfaceSpeed( material_name, tool_material, brinell_hardness_of_raw_material ));
 
 } // End GetSurfaceSpeed() method
 
 
+bool CSpeedReferences::Add(HeeksObj* object, HeeksObj* prev_object)
+{
+	m_table_valid = false;
+	return(ObjList::Add(object, prev_object));
+}
+
+void CSpeedReferences::Remove(HeeksObj* object)
+{
+	m_table_valid = false;
+	ObjList::Remove(object);
+}
 
 void CSpeedReferences::CopyFrom(const HeeksObj* object)
 {
@@ -11,12 +11,16 @@
 #include "HeeksCNCTypes.h"
 #include "CNCConfig.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 class CSpeedReferences: public ObjList{
 public:
 	bool m_estimate_when_possible;	// flag to turn feeds and speeds estimation on and off.
 	static wxString ConfigScope(void) {return _T("SpeedReferences");}
 
-	CSpeedReferences()
+	CSpeedReferences() : m_table_valid(false)
 	{
 		CNCConfig config(ConfigScope());
                 int value;
@@ -44,9 +48,13 @@ public:
 	void GetProperties(std::list<Property *> *list);
 	void GetTools(std::list<Tool*>* t_list, const wxPoint* p);
 	void CopyFrom(const HeeksObj* object);
+	bool Add(HeeksObj* object, HeeksObj* prev_object);
+	void Remove(HeeksObj* object);
 
 	static HeeksObj* ReadFromXMLElement(TiXmlElement* pElem);
 
+	void InvalidateTable() { m_table_valid = false; }
+
 	static std::set< wxString > GetMaterials();
 	static std::set< double > GetHardnessForMaterial( const wxString & material_name );
 	static std::set< double > GetAllHardnessValues();
@@ -54,5 +62,27 @@ public:
 	static double GetSurfaceSpeed( const wxString & material_name,
 					const int tool_material,
 					const double brinell_hardness_of_raw_material );
+
+private:
+	/**
+		The speed references are indexed by raw material name and tool material.  Each
+		entry holds its (hardness, surface speed) pairs sorted by hardness so that
+		the surface speed for a hardness that lies between two references can be
+		interpolated.  The table is rebuilt the next time it's needed after any
+		change to the references.
+	 */
+	typedef std::pair< wxString, int > TableKey_t;
+	typedef std::vector< std::pair< double, double > > HardnessAxis_t;
+	typedef std::map< TableKey_t, HardnessAxis_t > Table_t;
+
+	const Table_t & Table();
+	double SurfaceSpeed( const wxString & material_name, const int tool_material, const double brinell_hardness_of_raw_material );
+
+	Table_t m_table;
+	std::set< wxString > m_materials;
+	std::map< wxString, std::set< double > > m_hardness_for_material;
+	std::set< double > m_all_hardness_values;
+	bool m_table_valid;
+	int m_table_num_children;
 };
 
@@ -0,0 +1,129 @@
+// SplineBiarcs.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "SplineBiarcs.h"
+#include "interface/HeeksObj.h"
+#include "interface/Box.h"
+
+CSplineBiarcs::CObserver CSplineBiarcs::m_observer;
+CSplineBiarcs::Entries_t CSplineBiarcs::m_entries;
+
+void CSplineBiarcs::CObserver::OnChanged(const std::list<HeeksObj*>* added, const std::list<HeeksObj*>* removed, const std::list<HeeksObj*>* modified)
+{
+	if (removed != NULL)
+	{
+		for (std::list<HeeksObj*>::const_iterator l_itObject = removed->begin(); l_itObject != removed->end(); l_itObject++)
+		{
+			CSplineBiarcs::Invalidate( *l_itObject );
+		}
+	}
+
+	if (modified != NULL)
+	{
+		for (std::list<HeeksObj*>::const_iterator l_itObject = modified->begin(); l_itObject != modified->end(); l_itObject++)
+		{
+			CSplineBiarcs::Invalidate( *l_itObject );
+		}
+	}
+} // End OnChanged() method
+
+void CSplineBiarcs::CObserver::Clear()
+{
+	// The document has been emptied.  The ids will be reused by whatever is loaded next.
+	CSplineBiarcs::Clear();
+}
+
+/* static */ std::vector<double> CSplineBiarcs::Fingerprint( HeeksObj *spline )
+{
+	std::vector<double> fingerprint;
+
+	double pos[3];
+	if (spline->GetStartPoint( pos )) fingerprint.insert( fingerprint.end(), pos, pos + 3 );
+	if (spline->GetEndPoint( pos )) fingerprint.insert( fingerprint.end(), pos, pos + 3 );
+
+	CBox box;
+	spline->GetBox( box );
+	fingerprint.insert( fingerprint.end(), box.m_x, box.m_x + 6 );
+
+	return(fingerprint);
+} // End Fingerprint() method
+
+/**
+	Append copies of the lines and arcs that approximate this spline to within the deviation given.
+	The spans appended belong to the caller.
+ */
+/* static */ void CSplineBiarcs::Biarcs( HeeksObj *spline, const double deviation, std::list<HeeksObj *> & spans )
+{
+	if (spline->m_id == 0)
+	{
+		// Without an id we can't tell this spline from any other so don't cache it.
+		heeksCAD->SplineToBiarcs( spline, spans, deviation );
+		return;
+	}
+
+	Key_t key( spline->m_id, deviation );
+	std::vector<double> fingerprint = Fingerprint( spline );
+
+	Entries_t::iterator l_itEntry = m_entries.find( key );
+	if ((l_itEntry != m_entries.end()) && (l_itEntry->second.m_fingerprint != fingerprint))
+	{
+		Erase( l_itEntry );
+		l_itEntry = m_entries.end();
+	}
+
+	if (l_itEntry == m_entries.end())
+	{
+		l_itEntry = m_entries.insert( std::make_pair( key, CEntry() ) ).first;
+		l_itEntry->second.m_fingerprint = fingerprint;
+		heeksCAD->SplineToBiarcs( spline, l_itEntry->second.m_spans, deviation );
+	}
+
+	for (std::list<HeeksObj *>::const_iterator l_itSpan = l_itEntry->second.m_spans.begin(); l_itSpan != l_itEntry->second.m_spans.end(); l_itSpan++)
+	{
+		spans.push_back( (*l_itSpan)->MakeACopy() );
+	}
+} // End Biarcs() method
+
+/* static */ void CSplineBiarcs::Erase( Entries_t::iterator itEntry )
+{
+	for (std::list<HeeksObj *>::iterator l_itSpan = itEntry->second.m_spans.begin(); l_itSpan != itEntry->second.m_spans.end(); l_itSpan++)
+	{
+		delete *l_itSpan;
+	}
+
+	m_entries.erase( itEntry );
+} // End Erase() method
+
+/**
+	Discard any biarcs fitted to this spline.  If it's a sketch then do the same for each of its splines.
+ */
+/* static */ void CSplineBiarcs::Invalidate( HeeksObj *object )
+{
+	if (object == NULL) return;
+
+	if (object->GetType() == SplineType)
+	{
+		for (Entries_t::iterator l_itEntry = m_entries.begin(); l_itEntry != m_entries.end(); /* increment within loop */ )
+		{
+			if (l_itEntry->first.first == object->m_id) Erase( l_itEntry++ );
+			else l_itEntry++;
+		}
+	}
+	else if (object->GetType() == SketchType)
+	{
+		for (HeeksObj *child = object->GetFirstChild(); child != NULL; child = object->GetNextChild())
+		{
+			Invalidate( child );
+		}
+	}
+} // End Invalidate() method
+
+/* static */ void CSplineBiarcs::Clear()
+{
+	while (m_entries.size() > 0)
+	{
+		Erase( m_entries.begin() );
+	}
+} // End Clear() method
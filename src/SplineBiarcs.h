@@ -0,0 +1,61 @@
+// SplineBiarcs.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include "interface/Observer.h"
+
+#include <list>
+#include <map>
+#include <vector>
+#include <utility>
+
+class HeeksObj;
+
+/**
+	The CSplineBiarcs class holds the lines and arcs that HeeksCAD's SplineToBiarcs() fits to each spline
+	so that a spline is only fitted once for any one deviation rather than every time an operation
+	that uses it writes its Python.
+
+	Entries are keyed by the spline's id and the deviation.  The Observer discards a spline's entries
+	when HeeksCAD reports it (or the sketch holding it) as modified or removed.  The spline's end
+	points and bounding box are also kept with each entry and checked before it is reused.
+
+	Biarcs() appends copies of the cached spans to the caller's list.  The caller owns (and must delete)
+	them so that a later call, which may refit and so free the cached ones, can't leave it holding
+	dangling pointers.  Splines that have not been given an id (m_id == 0), such as temporary copies,
+	can't be told apart so they are fitted every time and never cached.
+ */
+class CSplineBiarcs
+{
+public:
+	class CObserver : public Observer
+	{
+	public:
+		void OnChanged(const std::list<HeeksObj*>* added, const std::list<HeeksObj*>* removed, const std::list<HeeksObj*>* modified);
+		void Clear();
+	}; // End CObserver class definition.
+
+	static void Biarcs( HeeksObj *spline, const double deviation, std::list<HeeksObj *> & spans );
+	static void Invalidate( HeeksObj *object );
+	static void Clear();
+
+	static CObserver m_observer;
+
+private:
+	class CEntry
+	{
+	public:
+		std::vector<double> m_fingerprint;	// start, end, bounding box
+		std::list<HeeksObj *> m_spans;
+	}; // End CEntry class definition.
+
+	typedef std::pair<int, double> Key_t;	// spline id, deviation
+	typedef std::map<Key_t, CEntry> Entries_t;
+
+	static std::vector<double> Fingerprint( HeeksObj *spline );
+	static void Erase( Entries_t::iterator itEntry );
+
+	static Entries_t m_entries;
+}; // End CSplineBiarcs class definition.
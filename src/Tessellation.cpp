@@ -0,0 +1,315 @@
+// Tessellation.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "Tessellation.h"
+#include "Fixture.h"
+#include "interface/Box.h"
+
+#include <wx/stdpaths.h>
+#include <wx/filename.h>
+
+#include <stdio.h>
+#include <math.h>
+
+CTessellation::CObserver CTessellation::m_observer;
+CTessellation::Meshes_t CTessellation::m_meshes;
+CTessellation::Order_t CTessellation::m_order;
+size_t CTessellation::m_bytes = 0;
+size_t CTessellation::m_memory_limit = 256 * 1024 * 1024;
+std::map< std::pair<int, int>, unsigned int > CTessellation::m_revisions;
+CTessellation::Files_t CTessellation::m_files;
+int CTessellation::m_number_for_stl_file = 1;
+
+// The mesh that AddTriangle() appends to while HeeksObj::GetTriangles() runs along with
+// the index of each vertex already added to it.
+typedef std::pair< float, std::pair< float, float > > Vertex_t;
+static CTessellation::CMesh *pTarget = NULL;
+static std::map< Vertex_t, unsigned int > vertex_indices;
+
+CTessellation::CSolidKey::CSolidKey( HeeksObj *solid, const unsigned int revision, const double tolerance )
+	: m_object( solid->GetType(), solid->m_id ), m_revision( revision ), m_tolerance( tolerance )
+{
+	CBox box;
+	solid->GetBox( box );
+	m_box.assign( box.m_x, box.m_x + 6 );
+}
+
+bool CTessellation::CSolidKey::operator< ( const CSolidKey & rhs ) const
+{
+	if (m_object != rhs.m_object) return(m_object < rhs.m_object);
+	if (m_revision != rhs.m_revision) return(m_revision < rhs.m_revision);
+	if (m_tolerance != rhs.m_tolerance) return(m_tolerance < rhs.m_tolerance);
+	return(m_box < rhs.m_box);
+}
+
+void CTessellation::CObserver::OnChanged(const std::list<HeeksObj*>* added, const std::list<HeeksObj*>* removed, const std::list<HeeksObj*>* modified)
+{
+	if (removed != NULL)
+	{
+		for (std::list<HeeksObj*>::const_iterator l_itObject = removed->begin(); l_itObject != removed->end(); l_itObject++)
+		{
+			CTessellation::Invalidate( *l_itObject );
+		}
+	}
+
+	if (modified != NULL)
+	{
+		for (std::list<HeeksObj*>::const_iterator l_itObject = modified->begin(); l_itObject != modified->end(); l_itObject++)
+		{
+			CTessellation::Invalidate( *l_itObject );
+		}
+	}
+} // End OnChanged() method
+
+void CTessellation::CObserver::Clear()
+{
+	// The document has been emptied.  The ids will be reused by whatever is loaded next.
+	CTessellation::Clear();
+}
+
+/* static */ CTessellation::CSolidKey CTessellation::Key( HeeksObj *solid, const double tolerance )
+{
+	return(CSolidKey( solid, m_revisions[ std::make_pair( solid->GetType(), solid->m_id ) ], tolerance ));
+}
+
+/* static */ void CTessellation::AddTriangle( const double *x, const double *n )
+{
+	for (int i=0; i<3; i++)
+	{
+		Vertex_t vertex( float(x[i*3]), std::make_pair( float(x[i*3+1]), float(x[i*3+2]) ) );
+
+		std::map< Vertex_t, unsigned int >::iterator l_itVertex = vertex_indices.find( vertex );
+		if (l_itVertex == vertex_indices.end())
+		{
+			l_itVertex = vertex_indices.insert( std::make_pair( vertex, (unsigned int) (pTarget->m_vertices.size() / 3) ) ).first;
+			pTarget->m_vertices.push_back( vertex.first );
+			pTarget->m_vertices.push_back( vertex.second.first );
+			pTarget->m_vertices.push_back( vertex.second.second );
+		}
+
+		pTarget->m_indices.push_back( l_itVertex->second );
+	} // End for
+} // End AddTriangle() method
+
+/**
+	Discard the least recently used meshes until we're back under the memory limit.  The
+	most recently used mesh is always kept, however large it is.
+ */
+/* static */ void CTessellation::Evict()
+{
+	while ((m_bytes > m_memory_limit) && (m_order.size() > 1))
+	{
+		Meshes_t::iterator l_itMesh = m_meshes.find( m_order.back() );
+		m_bytes -= l_itMesh->second.first.Bytes();
+		m_meshes.erase( l_itMesh );
+		m_order.pop_back();
+	} // End while
+} // End Evict() method
+
+/**
+	Return the mesh for this solid at this tolerance.  It's generated the first time it's asked
+	for and the same mesh is handed back until the solid changes or the mesh is evicted.
+	The reference is only good until the next call.
+ */
+/* static */ const CTessellation::CMesh & CTessellation::Mesh( HeeksObj *solid, const double tolerance )
+{
+	CSolidKey key = Key( solid, tolerance );
+
+	Meshes_t::iterator l_itMesh = m_meshes.find( key );
+	if (l_itMesh != m_meshes.end())
+	{
+		m_order.splice( m_order.begin(), m_order, l_itMesh->second.second );
+		return(l_itMesh->second.first);
+	}
+
+	m_order.push_front( key );
+	l_itMesh = m_meshes.insert( std::make_pair( key, Entry_t( CMesh(), m_order.begin() ) ) ).first;
+
+	pTarget = &(l_itMesh->second.first);
+	solid->GetTriangles( AddTriangle, tolerance );
+	pTarget = NULL;
+	vertex_indices.clear();
+
+	m_bytes += l_itMesh->second.first.Bytes();
+	Evict();
+
+	return(l_itMesh->second.first);
+} // End Mesh() method
+
+/**
+	Combine the fixture's three rotations into the one matrix.  They're applied in the
+	same YZ, XZ, XY order that the operations used to apply them to copies of the solids.
+ */
+/* static */ gp_Trsf CTessellation::FixtureMatrix( const CFixture & fixture )
+{
+	gp_Trsf matrix = fixture.GetMatrix(CFixture::XY);
+	matrix.Multiply( fixture.GetMatrix(CFixture::XZ) );
+	matrix.Multiply( fixture.GetMatrix(CFixture::YZ) );
+	return(matrix);
+} // End FixtureMatrix() method
+
+/**
+	Write the triangles as an ASCII STL file.  This is the format that OpenCAMLib's STLReader
+	expects (see ocl_funcs.STLSurfFromFile())
+ */
+/* static */ bool CTessellation::Write( const std::vector<float> & vertices, const std::vector<unsigned int> & indices, const wxString & file_name )
+{
+	FILE *fp = fopen(Ttc(file_name.c_str()), "w");
+	if (fp == NULL) return(false);
+
+	fprintf(fp, "solid\n");
+	for (std::vector<unsigned int>::size_type i=0; i + 2 < indices.size(); i += 3)
+	{
+		const float *p[3] = { &vertices[indices[i] * 3], &vertices[indices[i+1] * 3], &vertices[indices[i+2] * 3] };
+
+		double a[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+		double b[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+		double n[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length > 0.0)
+		{
+			n[0] /= length;
+			n[1] /= length;
+			n[2] /= length;
+		}
+
+		fprintf(fp, " facet normal %.7g %.7g %.7g\n  outer loop\n", n[0], n[1], n[2]);
+		for (int j=0; j<3; j++)
+		{
+			fprintf(fp, "   vertex %.7g %.7g %.7g\n", p[j][0], p[j][1], p[j][2]);
+		}
+		fprintf(fp, "  endloop\n endfacet\n");
+	} // End for
+	fprintf(fp, "endsolid\n");
+
+	return(fclose(fp) == 0);
+} // End Write() method
+
+/**
+	Return the name of an STL file containing these solids, tessellated to this tolerance and
+	moved by this matrix.  If an earlier operation has already asked for the same combination
+	(and none of the solids have changed since) then its file is reused rather than written again.
+ */
+/* static */ wxString CTessellation::STLFile( const std::list<HeeksObj *> & solids, const double tolerance, const gp_Trsf & matrix )
+{
+	FileKey_t key;
+	for (std::list<HeeksObj *>::const_iterator l_itSolid = solids.begin(); l_itSolid != solids.end(); l_itSolid++)
+	{
+		key.first.push_back( Key( *l_itSolid, tolerance ) );
+	}
+
+	double m[16];
+	CFixture::extract( matrix, m );
+	key.second.assign( m, m + 12 );
+
+	Files_t::iterator l_itFile = m_files.find( key );
+	if ((l_itFile != m_files.end()) && (wxFileExists(l_itFile->second))) return(l_itFile->second);
+
+	// Gather the meshes into one, moving each vertex by the matrix as it's copied.  Each mesh is
+	// finished with before the next one is asked for.
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	for (std::list<HeeksObj *>::const_iterator l_itSolid = solids.begin(); l_itSolid != solids.end(); l_itSolid++)
+	{
+		const CMesh & mesh = Mesh( *l_itSolid, tolerance );
+		unsigned int offset = (unsigned int) (vertices.size() / 3);
+
+		vertices.reserve( vertices.size() + mesh.m_vertices.size() );
+		for (std::vector<float>::size_type i=0; i + 2 < mesh.m_vertices.size(); i += 3)
+		{
+			double x = mesh.m_vertices[i];
+			double y = mesh.m_vertices[i+1];
+			double z = mesh.m_vertices[i+2];
+
+			vertices.push_back( float(m[0] * x + m[1] * y + m[2]  * z + m[3]) );
+			vertices.push_back( float(m[4] * x + m[5] * y + m[6]  * z + m[7]) );
+			vertices.push_back( float(m[8] * x + m[9] * y + m[10] * z + m[11]) );
+		}
+
+		indices.reserve( indices.size() + mesh.m_indices.size() );
+		for (std::vector<unsigned int>::const_iterator l_itIndex = mesh.m_indices.begin(); l_itIndex != mesh.m_indices.end(); l_itIndex++)
+		{
+			indices.push_back( *l_itIndex + offset );
+		}
+	} // End for
+
+	wxStandardPaths standard_paths;
+	wxFileName filepath( standard_paths.GetTempDir().c_str(), wxString::Format(_T("surface_triangles%d.stl"), m_number_for_stl_file).c_str() );
+	m_number_for_stl_file++;
+
+	if (! Write( vertices, indices, filepath.GetFullPath() ))
+	{
+		wxString error;
+		error << _T("Could not open ") << filepath.GetFullPath() << _T(" for writing");
+		wxMessageBox(error);
+	}
+
+	m_files[key] = filepath.GetFullPath();
+	return(filepath.GetFullPath());
+} // End STLFile() method
+
+/**
+	Forget everything we know about this solid.  Its meshes are discarded and any STL files
+	that include it are deleted.
+ */
+/* static */ void CTessellation::Invalidate( HeeksObj *solid )
+{
+	if ((solid == NULL) || (solid->GetType() != SolidType && solid->GetType() != StlSolidType)) return;
+
+	std::pair<int, int> object( solid->GetType(), solid->m_id );
+	m_revisions[object]++;
+
+	for (Meshes_t::iterator l_itMesh = m_meshes.begin(); l_itMesh != m_meshes.end(); /* increment within loop */ )
+	{
+		if (l_itMesh->first.m_object == object)
+		{
+			m_bytes -= l_itMesh->second.first.Bytes();
+			m_order.erase( l_itMesh->second.second );
+			m_meshes.erase( l_itMesh++ );
+		}
+		else
+		{
+			l_itMesh++;
+		}
+	} // End for
+
+	for (Files_t::iterator l_itFile = m_files.begin(); l_itFile != m_files.end(); /* increment within loop */ )
+	{
+		bool includes_solid = false;
+		for (std::vector<CSolidKey>::const_iterator l_itKey = l_itFile->first.first.begin(); l_itKey != l_itFile->first.first.end(); l_itKey++)
+		{
+			if (l_itKey->m_object == object) includes_solid = true;
+		}
+
+		if (includes_solid)
+		{
+			if (wxFileExists(l_itFile->second)) wxRemoveFile(l_itFile->second);
+			m_files.erase( l_itFile++ );
+		}
+		else
+		{
+			l_itFile++;
+		}
+	} // End for
+} // End Invalidate() method
+
+/* static */ void CTessellation::Clear()
+{
+	for (Files_t::iterator l_itFile = m_files.begin(); l_itFile != m_files.end(); l_itFile++)
+	{
+		if (wxFileExists(l_itFile->second)) wxRemoveFile(l_itFile->second);
+	}
+
+	m_meshes.clear();
+	m_order.clear();
+	m_bytes = 0;
+	m_files.clear();
+} // End Clear() method
+
+/* static */ void CTessellation::SetMemoryLimit( const size_t bytes )
+{
+	m_memory_limit = bytes;
+	Evict();
+} // End SetMemoryLimit() method
@@ -0,0 +1,96 @@
+// Tessellation.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include "interface/Observer.h"
+
+#include <gp_Trsf.hxx>
+
+#include <list>
+#include <map>
+#include <vector>
+#include <utility>
+
+class HeeksObj;
+class CFixture;
+
+/**
+	The CTessellation class holds the triangles that the OpenCAMLib based operations (ZigZag, Waterline,
+	AttachOp) hand over to the ocl_funcs Python module.  The fixture's rotation is applied to the
+	triangles rather than to a copy of the solid so that the document is never changed (and no undo
+	point is needed) just to generate the Python program.
+
+	Each solid's mesh is kept for the life of the process, keyed by the solid's type and id, its
+	revision, its bounding box and the tolerance used.  The revision is bumped by the Observer
+	whenever HeeksCAD reports the solid as modified or removed.  The meshes are indexed (unique
+	vertices plus three indices per triangle) and the least recently used ones are discarded
+	once their total size goes over the memory limit.
+
+	The post-processor runs as a separate Python process so the triangles still have to reach OpenCAMLib
+	through a file.  The STL file for any one set of solids, tolerance and fixture is written once and
+	then shared by every operation (and every program rewrite) that refers to it.
+ */
+class CTessellation
+{
+public:
+	class CMesh
+	{
+	public:
+		std::vector<float> m_vertices;			// x,y,z for each unique vertex.
+		std::vector<unsigned int> m_indices;	// Three vertex indices for each triangle.
+
+		size_t Bytes() const { return((m_vertices.size() * sizeof(float)) + (m_indices.size() * sizeof(unsigned int))); }
+	}; // End CMesh class definition.
+
+	class CObserver : public Observer
+	{
+	public:
+		void OnChanged(const std::list<HeeksObj*>* added, const std::list<HeeksObj*>* removed, const std::list<HeeksObj*>* modified);
+		void Clear();
+	}; // End CObserver class definition.
+
+	static const CMesh & Mesh( HeeksObj *solid, const double tolerance );
+	static gp_Trsf FixtureMatrix( const CFixture & fixture );
+	static wxString STLFile( const std::list<HeeksObj *> & solids, const double tolerance, const gp_Trsf & matrix );
+	static void Invalidate( HeeksObj *solid );
+	static void Clear();
+	static void SetMemoryLimit( const size_t bytes );
+
+	static CObserver m_observer;
+
+private:
+	class CSolidKey
+	{
+	public:
+		CSolidKey( HeeksObj *solid, const unsigned int revision, const double tolerance );
+
+		bool operator< ( const CSolidKey & rhs ) const;
+
+		std::pair<int, int> m_object;	// type, id
+		unsigned int m_revision;
+		std::vector<double> m_box;
+		double m_tolerance;
+	}; // End CSolidKey class definition.
+
+	typedef std::list<CSolidKey> Order_t;	// Most recently used at the front.
+	typedef std::pair<CMesh, Order_t::iterator> Entry_t;
+	typedef std::map<CSolidKey, Entry_t> Meshes_t;
+
+	typedef std::pair< std::vector<CSolidKey>, std::vector<double> > FileKey_t;	// solids, matrix
+	typedef std::map< FileKey_t, wxString > Files_t;
+
+	static CSolidKey Key( HeeksObj *solid, const double tolerance );
+	static void AddTriangle( const double *x, const double *n );
+	static void Evict();
+	static bool Write( const std::vector<float> & vertices, const std::vector<unsigned int> & indices, const wxString & file_name );
+
+	static Meshes_t m_meshes;
+	static Order_t m_order;
+	static size_t m_bytes;
+	static size_t m_memory_limit;
+	static std::map< std::pair<int, int>, unsigned int > m_revisions;
+	static Files_t m_files;
+	static int m_number_for_stl_file;
+}; // End CTessellation class definition.
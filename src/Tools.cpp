@@ -27,6 +27,7 @@ HeeksObj *CTools::MakeACopy(void) const
 
 CTools::CTools()
 {
+    m_index_valid = false;
     CNCConfig config(CTools::ConfigScope());
 	config.Read(_T("title_format"), (int *) (&m_title_format), int(eGuageReplacesSize) );
 }
@@ -35,6 +36,7 @@ CTools::CTools()
 CTools::CTools( const CTools & rhs ) : ObjList(rhs)
 {
     m_title_format = rhs.m_title_format;
+    m_index_valid = false;
 }
 
 CTools & CTools::operator= ( const CTools & rhs )
@@ -43,6 +45,7 @@ CTools & CTools::operator= ( const CTools & rhs )
     {
         ObjList::operator=( rhs );
         m_title_format = rhs.m_title_format;
+        m_index_valid = false;
     }
     return(*this);
 }
@@ -76,6 +79,82 @@ void CTools::CopyFrom(const HeeksObj* object)
     */
 }
 
+bool CTools::Add(HeeksObj* object, HeeksObj* prev_object)
+{
+    m_index_valid = false;
+    return(ObjList::Add(object, prev_object));
+}
+
+void CTools::Remove(HeeksObj* object)
+{
+    m_index_valid = false;
+    ObjList::Remove(object);
+}
+
+/**
+	The index is only trusted while it still describes the same number of
+	children.  This catches children that were added or removed without
+	going through our own Add() and Remove() methods.
+ */
+bool CTools::IndexIsValid()
+{
+    return((m_index_valid) && (m_tools_in_order.size() == (unsigned int) GetNumChildren()));
+}
+
+void CTools::RebuildIndex()
+{
+    m_tool_number_index.clear();
+    m_tool_type_index.clear();
+    m_tools_in_order.clear();
+
+    for (std::list<HeeksObj*>::iterator l_itObject = m_objects.begin(); l_itObject != m_objects.end(); l_itObject++)
+    {
+        if ((*l_itObject == NULL) || ((*l_itObject)->GetType() != ToolType)) continue;
+
+        CTool *pTool = (CTool *) *l_itObject;
+        m_tools_in_order.push_back( pTool );
+
+        // Only keep the first of any duplicates so that we return the same tool as a scan of the list would.
+        m_tool_number_index.insert( std::make_pair( pTool->m_tool_number, pTool ) );
+        m_tool_type_index.insert( std::make_pair( pTool->m_params.m_type, pTool->m_tool_number ) );
+    } // End for
+
+    m_index_valid = true;
+}
+
+CTool *CTools::Find( const CTool::ToolNumber_t tool_number )
+{
+    if (! IndexIsValid()) RebuildIndex();
+
+    ToolNumberIndex_t::const_iterator l_itTool = m_tool_number_index.find( tool_number );
+    if (l_itTool == m_tool_number_index.end()) return(NULL);
+
+    if (l_itTool->second->m_tool_number != tool_number)
+    {
+        // It's been renumbered behind our back.
+        RebuildIndex();
+        l_itTool = m_tool_number_index.find( tool_number );
+        if (l_itTool == m_tool_number_index.end()) return(NULL);
+    }
+
+    return(l_itTool->second);
+}
+
+CTool::ToolNumber_t CTools::FindFirstByType( const CToolParams::eToolType type )
+{
+    if (! IndexIsValid()) RebuildIndex();
+
+    ToolTypeIndex_t::const_iterator l_itTool = m_tool_type_index.find( type );
+    if (l_itTool == m_tool_type_index.end()) return(-1);
+    return(l_itTool->second);
+}
+
+const std::vector< CTool * > & CTools::AllTools()
+{
+    if (! IndexIsValid()) RebuildIndex();
+    return(m_tools_in_order);
+}
+
 void CTools::WriteXML(TiXmlNode *root)
 {
 	TiXmlElement * element;
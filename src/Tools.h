@@ -4,6 +4,10 @@
 
 #include "interface/ObjList.h"
 #include "HeeksCNCTypes.h"
+#include "CTool.h"
+
+#include <map>
+#include <vector>
 
 #pragma once
 
@@ -38,6 +42,8 @@ public:
 	bool CanAddTo(HeeksObj* owner){return owner->GetType() == ProgramType;}
 	bool CanAdd(HeeksObj* object);
 	bool CanBeRemoved(){return false;}
+	bool Add(HeeksObj* object, HeeksObj* prev_object);
+	void Remove(HeeksObj* object);
 	void WriteXML(TiXmlNode *root);
 	bool UsesID() { return(false); }
 	void CopyFrom(const HeeksObj* object);
@@ -51,5 +57,27 @@ public:
 
 	static wxString ConfigScope() { return(_("Tools")); }
 
+	CTool *Find( const CTool::ToolNumber_t tool_number );
+	CTool::ToolNumber_t FindFirstByType( const CToolParams::eToolType type );
+	const std::vector< CTool * > & AllTools();
+	void InvalidateIndex() { m_index_valid = false; }
+
+private:
+	/**
+		The tools are indexed by tool number (and by type) so that the many calls
+		to CTool::Find() made while generating or drawing operations don't have
+		to scan the whole tool table.  Any change to the list or to a tool's
+		number invalidates the index and it's rebuilt the next time it's needed.
+	 */
+	void RebuildIndex();
+	bool IndexIsValid();
+
+	typedef std::map< CTool::ToolNumber_t, CTool * > ToolNumberIndex_t;
+	typedef std::map< CToolParams::eToolType, CTool::ToolNumber_t > ToolTypeIndex_t;
+
+	ToolNumberIndex_t m_tool_number_index;
+	ToolTypeIndex_t m_tool_type_index;
+	std::vector< CTool * > m_tools_in_order;
+	bool m_index_valid;
 };
 
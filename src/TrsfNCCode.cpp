@@ -12,14 +12,70 @@
 
 using namespace std;
 
-CTrsfNCCode::CTrsfNCCode():m_x(0),m_y(0)
+CTrsfNCCode::CTrsfNCCode():m_x(0),m_y(0),m_angle(0),m_source(NULL)
 {
 	Add(new CNCCode(),NULL);
 }
 
+CTrsfNCCode::CTrsfNCCode(CTrsfNCCode *source):m_x(0),m_y(0),m_angle(0),m_source(source)
+{
+	if (m_source->m_source != NULL) m_source = m_source->m_source;
+	m_source->m_instances.push_back(this);
+}
+
+CTrsfNCCode::CTrsfNCCode(const CTrsfNCCode & rhs):ObjList(rhs),m_x(rhs.m_x),m_y(rhs.m_y),m_angle(rhs.m_angle),m_source(rhs.m_source)
+{
+	// A copy of the source gets its own copy of the code.  A copy of an instance shares the same source.
+	if (m_source != NULL) m_source->m_instances.push_back(this);
+}
+
 CTrsfNCCode::~CTrsfNCCode()
 {
+	if (m_source != NULL)
+	{
+		m_source->m_instances.remove(this);
+	}
+	else if (m_instances.size() > 0)
+	{
+		// Hand the code on to the first copy that shares it.
+		CTrsfNCCode *heir = m_instances.front();
+		m_instances.pop_front();
+
+		for (HeeksObj *child = GetFirstChild(); child != NULL; child = GetFirstChild())
+		{
+			Remove(child);
+			heir->Add(child, NULL);
+		}
+
+		heir->m_source = NULL;
+		heir->m_instances = m_instances;
+		for (std::list<CTrsfNCCode *>::iterator l_itInstance = heir->m_instances.begin(); l_itInstance != heir->m_instances.end(); l_itInstance++)
+		{
+			(*l_itInstance)->m_source = heir;
+		}
+	}
+}
+
+/**
+	Share the source's NC code from now on.  Only for copies that don't hold any code of their own.
+ */
+void CTrsfNCCode::SetSource(CTrsfNCCode *source)
+{
+	if ((source == NULL) || (source == this) || (source == m_source)) return;
+	if (source->m_source != NULL) source = source->m_source;
 
+	if (m_source != NULL) m_source->m_instances.remove(this);
+	m_source = source;
+	m_source->m_instances.push_back(this);
+}
+
+/**
+	The NC code to use for this copy, whether it's held here or by the source.
+ */
+CNCCode *CTrsfNCCode::Code()
+{
+	if (m_source != NULL) return(m_source->Code());
+	return((CNCCode *) GetFirstChild());
 }
 
 const wxBitmap &CTrsfNCCode::GetIcon()
@@ -55,7 +111,17 @@ void CTrsfNCCode::glCommands(bool select, bool marked, bool no_color)
 	glPushMatrix();
 	
 	glTranslated(m_x,m_y,0);
-	ObjList::glCommands(select,marked,no_color);
+	glRotated(m_angle,0,0,1);
+	if (m_source != NULL)
+	{
+		// Draw the source's code again.  Its display list is reused.
+		CNCCode *code = Code();
+		if (code != NULL) code->glCommands(select,marked,no_color);
+	}
+	else
+	{
+		ObjList::glCommands(select,marked,no_color);
+	}
 
 	glPopMatrix();
 }
@@ -67,17 +133,58 @@ void CTrsfNCCode::ModifyByMatrix(const double *m)
 	pos.Transform(mat);
 	m_x = pos.X();
 	m_y = pos.Y();
+
+	// Only the matrix's rotation about Z is kept.
+	gp_Vec direction(cos(m_angle * PI/180),sin(m_angle * PI/180),0);
+	direction.Transform(mat);
+	m_angle = atan2(direction.Y(),direction.X()) * 180/PI;
+}
+
+void CTrsfNCCode::GetBox(CBox &box)
+{
+	// The box is that of the code once it's turned but before it's translated.
+	CBox code_box;
+	if (m_source != NULL)
+	{
+		CNCCode *code = Code();
+		if (code != NULL) code->GetBox(code_box);
+	}
+	else
+	{
+		ObjList::GetBox(code_box);
+	}
+
+	if (!code_box.m_valid) return;
+	if (m_angle == 0.0)
+	{
+		box.Insert(code_box);
+		return;
+	}
+
+	double c = cos(m_angle * PI/180);
+	double s = sin(m_angle * PI/180);
+	for (int corner = 0; corner < 4; corner++)
+	{
+		double x = (corner & 1)?code_box.MaxX():code_box.MinX();
+		double y = (corner & 2)?code_box.MaxY():code_box.MinY();
+		double p[3] = {x * c - y * s, x * s + y * c, code_box.MinZ()};
+		box.Insert(p);
+		p[2] = code_box.MaxZ();
+		box.Insert(p);
+	}
 }
 
 void CTrsfNCCode::WriteCode(wxTextFile &f)
 {
-	CNCCode* code = (CNCCode*)GetFirstChild();
+	CNCCode* code = Code();
+	if (code == NULL) return;
 
+	double position[2] = {0, 0};	// where the code has got to before it's turned
 	std::list<CNCCodeBlock*>::iterator it;
 	for(it = code->m_blocks.begin(); it != code->m_blocks.end(); it++)
 	{
 		CNCCodeBlock* block = *it;
-		block->WriteNCCode(f,m_x,m_y);
+		block->WriteNCCode(f,m_x,m_y,m_angle,position);
 	}
 }
 
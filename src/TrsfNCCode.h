@@ -8,15 +8,36 @@
 #include "HeeksCNCTypes.h"
 #include "HeeksCNC.h"
 
+#include <list>
+
+class CNCCode;
+
+/**
+	A block of NC code turned by m_angle (degrees, anti-clockwise about its origin) and then
+	translated to (m_x, m_y).  A BOM holds one of these for each copy of each
+	part.  Only the first copy of a part holds the NC code (as its child).  The others are
+	made with the CTrsfNCCode(source) constructor and use the source's code, so memory and
+	backplotting time depend on the number of different parts rather than the number of copies.
+	If the source is deleted, its code is handed on to one of the copies that share it.
+
+	Copies of a shared copy share the same source.  Whoever copies a whole set of them (i.e. CBOM)
+	must point the copies at the copy of their source with SetSource().  They can't be assigned.
+ */
 class CTrsfNCCode:public ObjList
 {
 public:
 	double m_x;
 	double m_y;
+	double m_angle;
 
 	CTrsfNCCode();
+	CTrsfNCCode(CTrsfNCCode *source);
+	CTrsfNCCode(const CTrsfNCCode & rhs);
 	~CTrsfNCCode();
 
+	CNCCode *Code();
+	CTrsfNCCode *Source() const { return(m_source); }
+	void SetSource(CTrsfNCCode *source);
 	void WriteCode(wxTextFile &f);
 
 	// HeeksObj's virtual functions
@@ -32,4 +53,11 @@ public:
 	static HeeksObj* ReadFromXMLElement(TiXmlElement* pElem);
 	void glCommands(bool select, bool marked, bool no_color);
 	void ModifyByMatrix(const double *m);
+	void GetBox(CBox &box);
+
+private:
+	CTrsfNCCode & operator= (const CTrsfNCCode & rhs);	// Not implemented.  The sharing can't be sorted out by assignment.
+
+	CTrsfNCCode *m_source;		// the copy holding the NC code (NULL if this one holds it)
+	std::list<CTrsfNCCode *> m_instances;	// copies sharing this one's NC code
 };
@@ -20,11 +20,10 @@
 #include "CTool.h"
 #include "MachineState.h"
 #include "Program.h"
+#include "Tessellation.h"
 
 #include <sstream>
 
-int CWaterline::number_for_stl_file = 1;
-
 static void on_set_minx(double value, HeeksObj* object){((CWaterline*)object)->m_params.m_box.m_x[0] = value; heeksCAD->Changed();}
 static void on_set_maxx(double value, HeeksObj* object){((CWaterline*)object)->m_params.m_box.m_x[3] = value;heeksCAD->Changed();}
 static void on_set_miny(double value, HeeksObj* object){((CWaterline*)object)->m_params.m_box.m_x[1] = value;heeksCAD->Changed();}
@@ -201,8 +200,6 @@ Python CWaterline::AppendTextToProgram(CMachineState *pMachineState)
 	if(cr<0)cr = 0.0;
 	python << ( cr / theApp.m_program->m_units ) << _T(")\n");
 
-	heeksCAD->CreateUndoPoint();
-
 	//write stl file
 	std::list<HeeksObj*> solids;
 	for (HeeksObj *object = GetFirstChild(); object != NULL; object = GetNextChild())
@@ -212,42 +209,13 @@ Python CWaterline::AppendTextToProgram(CMachineState *pMachineState)
 	        continue;
 	    }
 
-		if (object != NULL)
-		{
-			// Need to rotate a COPY of the solid by the fixture settings.
-			HeeksObj* copy = object->MakeACopy();
-			if (copy != NULL)
-			{
-				double m[16];	// A different form of the transformation matrix.
-				CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::YZ), m );
-                copy->ModifyByMatrix(m);
-
-                CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::XZ), m );
-                copy->ModifyByMatrix(m);
-
-                CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::XY), m );
-                copy->ModifyByMatrix(m);
-
-                solids.push_back(copy);
-            } // End if - then
-        } // End if - then
+		solids.push_back(object);
 	} // End for
 
+	// The triangles are rotated by the fixture settings rather than copies of the solids.
+	wxString filepath = CTessellation::STLFile( solids, m_params.m_tolerance, CTessellation::FixtureMatrix( pMachineState->Fixture() ) );
 
-    wxStandardPaths standard_paths;
-    wxFileName filepath( standard_paths.GetTempDir().c_str(), wxString::Format(_T("waterline%d.stl"), number_for_stl_file).c_str() );
-	number_for_stl_file++;
-
-	heeksCAD->SaveSTLFile(solids, filepath.GetFullPath(), m_params.m_tolerance);
-
-	// We don't need the duplicate solids any more.  Delete them.
-	for (std::list<HeeksObj*>::iterator l_itSolid = solids.begin(); l_itSolid != solids.end(); l_itSolid++)
-	{
-		heeksCAD->Remove( *l_itSolid );
-	} // End for
-	heeksCAD->Changed();
-
-    python << _T("ocl_funcs.waterline( filepath = ") << PythonString(filepath.GetFullPath()) << _T(", ")
+    python << _T("ocl_funcs.waterline( filepath = ") << PythonString(filepath) << _T(", ")
             << _T("tool_diameter = ") << pTool->CuttingRadius() * 2.0 << _T(", ")
             << _T("corner_radius = ") << pTool->m_params.m_corner_radius / theApp.m_program->m_units << _T(", ")
             << _T("step_over = ") << m_params.m_step_over / theApp.m_program->m_units << _T(", ")
@@ -28,7 +28,6 @@ class CWaterline: public CDepthOp{
 public:
 	std::list<int> m_solids;
 	CWaterlineParams m_params;
-	static int number_for_stl_file;
 
 	CWaterline():CDepthOp(GetTypeString(), 0, WaterlineType){}
 	CWaterline(const std::list<int> &solids, const int tool_number = -1);
@@ -0,0 +1,64 @@
+// WorkerThreads.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#include "stdafx.h"
+#include "WorkerThreads.h"
+
+#include <wx/thread.h>
+
+class CWorkerThread : public wxThread
+{
+public:
+	CWorkerThread( CWorkerJob *job ) : wxThread(wxTHREAD_JOINABLE), m_job(job) { }
+
+protected:
+	virtual ExitCode Entry()
+	{
+		m_job->Run();
+		return(0);
+	}
+
+private:
+	CWorkerJob *m_job;
+};
+
+/* static */ unsigned int CWorkerThreads::Count()
+{
+	int count = wxThread::GetCPUCount();
+	if (count < 1) return(1);
+	return((unsigned int) count);
+} // End Count() method
+
+/* static */ void CWorkerThreads::Run( std::vector<CWorkerJob *> & jobs )
+{
+	// Joinable threads must be deleted by us once we've waited for them.
+	std::vector<CWorkerThread *> threads;
+	std::vector<CWorkerJob *> left_over;
+
+	for (std::vector<CWorkerJob *>::size_type i = 1; i < jobs.size(); i++)
+	{
+		CWorkerThread *thread = new CWorkerThread( jobs[i] );
+		if ((thread->Create() == wxTHREAD_NO_ERROR) && (thread->Run() == wxTHREAD_NO_ERROR))
+		{
+			threads.push_back( thread );
+		}
+		else
+		{
+			delete thread;
+			left_over.push_back( jobs[i] );
+		}
+	}
+
+	if (jobs.size() > 0) jobs[0]->Run();
+	for (std::vector<CWorkerJob *>::iterator l_itJob = left_over.begin(); l_itJob != left_over.end(); l_itJob++)
+	{
+		(*l_itJob)->Run();
+	}
+
+	for (std::vector<CWorkerThread *>::iterator l_itThread = threads.begin(); l_itThread != threads.end(); l_itThread++)
+	{
+		(*l_itThread)->Wait();
+		delete *l_itThread;
+	}
+} // End Run() method
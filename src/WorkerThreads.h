@@ -0,0 +1,43 @@
+// WorkerThreads.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+#pragma once
+
+#include <vector>
+
+/**
+	One piece of a calculation that's been split up so that the pieces can run on
+	separate processors at the same time.  A job must only change its own data
+	(and read data that nothing changes while the jobs are running).  In particular
+	it mustn't call OpenCASCADE, Python or anything in HeeksCAD, none of which
+	are thread safe.
+ */
+class CWorkerJob
+{
+public:
+	virtual ~CWorkerJob() { }
+	virtual void Run() = 0;
+};
+
+/**
+	Runs a set of CWorkerJob objects on wxThreads, one thread per job, and waits
+	for them all to finish.  The caller splits its work into about Count() jobs.
+ */
+class CWorkerThreads
+{
+public:
+	/**
+		The number of jobs worth splitting a calculation into, i.e. the number of
+		processors.  It's always at least one.
+	 */
+	static unsigned int Count();
+
+	/**
+		Runs all the jobs and returns once they've finished.  The first job is run on
+		the calling thread while the others run on their own threads.  If a thread
+		can't be started, its job is run on the calling thread instead, so every
+		job is always run exactly once.
+	 */
+	static void Run( std::vector<CWorkerJob *> & jobs );
+};
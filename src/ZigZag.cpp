@@ -20,11 +20,10 @@
 #include "CTool.h"
 #include "MachineState.h"
 #include "Program.h"
+#include "Tessellation.h"
 
 #include <sstream>
 
-int CZigZag::number_for_stl_file = 1;
-
 static void on_set_minx(double value, HeeksObj* object){((CZigZag*)object)->m_params.m_box.m_x[0] = value;}
 static void on_set_maxx(double value, HeeksObj* object){((CZigZag*)object)->m_params.m_box.m_x[3] = value;}
 static void on_set_miny(double value, HeeksObj* object){((CZigZag*)object)->m_params.m_box.m_x[1] = value;}
@@ -215,8 +214,6 @@ Python CZigZag::AppendTextToProgram(CMachineState *pMachineState)
 	if(cr<0)cr = 0.0;
 	python << ( cr / theApp.m_program->m_units ) << _T(")\n");
 
-	heeksCAD->CreateUndoPoint();
-
 	//write stl file
 	std::list<HeeksObj*> solids;
 	for (HeeksObj *object = GetFirstChild(); object != NULL; object = GetNextChild())
@@ -226,47 +223,18 @@ Python CZigZag::AppendTextToProgram(CMachineState *pMachineState)
 	        continue;
 	    }
 
-		if (object != NULL)
-		{
-			// Need to rotate a COPY of the solid by the fixture settings.
-			HeeksObj* copy = object->MakeACopy();
-			if (copy != NULL)
-			{
-				double m[16];	// A different form of the transformation matrix.
-				CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::YZ), m );
-                copy->ModifyByMatrix(m);
-
-                CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::XZ), m );
-                copy->ModifyByMatrix(m);
-
-                CFixture::extract( pMachineState->Fixture().GetMatrix(CFixture::XY), m );
-                copy->ModifyByMatrix(m);
-
-                solids.push_back(copy);
-            } // End if - then
-       } // End if - then
+		solids.push_back(object);
 	} // End for
 
-
-    wxStandardPaths standard_paths;
-    wxFileName filepath( standard_paths.GetTempDir().c_str(), wxString::Format(_T("zigzag%d.stl"), number_for_stl_file).c_str() );
-	number_for_stl_file++;
-
-	heeksCAD->SaveSTLFile(solids, filepath.GetFullPath(), 0.01);
-
-	// We don't need the duplicate solids any more.  Delete them.
-	for (std::list<HeeksObj*>::iterator l_itSolid = solids.begin(); l_itSolid != solids.end(); l_itSolid++)
-	{
-		heeksCAD->Remove( *l_itSolid );
-	} // End for
-	heeksCAD->Changed();
+	// The triangles are rotated by the fixture settings rather than copies of the solids.
+	wxString filepath = CTessellation::STLFile( solids, 0.01, CTessellation::FixtureMatrix( pMachineState->Fixture() ) );
 
 
 	// Rotate the coordinates to align with the fixture.
 	gp_Pnt min = pMachineState->Fixture().Adjustment( gp_Pnt( m_params.m_box.m_x[0], m_params.m_box.m_x[1], m_params.m_box.m_x[2] ) );
 	gp_Pnt max = pMachineState->Fixture().Adjustment( gp_Pnt( m_params.m_box.m_x[3], m_params.m_box.m_x[4], m_params.m_box.m_x[5] ) );
 
-	python << _T("ocl_funcs.zigzag(") << PythonString(filepath.GetFullPath()) << _T(", tool_diameter, corner_radius, float(") << m_params.m_step_over / theApp.m_program->m_units << _T("), float(") << min.X() / theApp.m_program->m_units << _T("), float(") << max.X() / theApp.m_program->m_units << _T("), float(") << min.Y() / theApp.m_program->m_units << _T("), float(") << max.Y() / theApp.m_program->m_units << _T("), ") << ((m_params.m_direction == 0) ? _T("'X'") : _T("'Y'")) << _T(", float(") << m_params.m_material_allowance / theApp.m_program->m_units << _T("), ") << m_params.m_style << _T(", clearance, rapid_safety_space, start_depth, step_down, final_depth, ") << theApp.m_program->m_units << _T(")\n");
+	python << _T("ocl_funcs.zigzag(") << PythonString(filepath) << _T(", tool_diameter, corner_radius, float(") << m_params.m_step_over / theApp.m_program->m_units << _T("), float(") << min.X() / theApp.m_program->m_units << _T("), float(") << max.X() / theApp.m_program->m_units << _T("), float(") << min.Y() / theApp.m_program->m_units << _T("), float(") << max.Y() / theApp.m_program->m_units << _T("), ") << ((m_params.m_direction == 0) ? _T("'X'") : _T("'Y'")) << _T(", float(") << m_params.m_material_allowance / theApp.m_program->m_units << _T("), ") << m_params.m_style << _T(", clearance, rapid_safety_space, start_depth, step_down, final_depth, ") << theApp.m_program->m_units << _T(")\n");
 
 	return(python);
 }
@@ -29,7 +29,6 @@ class CZigZag: public CDepthOp{
 public:
 	std::list<int> m_solids;
 	CZigZagParams m_params;
-	static int number_for_stl_file;
 
 	CZigZag():CDepthOp(GetTypeString(), 0, ZigZagType){}
 	CZigZag(const std::list<int> &solids, const int tool_number = -1);
@@ -0,0 +1,224 @@
+// dropcutter_bench.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+// Times DropCutter::TriTest() over a std::list of triangles (one position at a time, testing
+// every triangle) against TriTest() over a TriangleGrid, one position at a time on one thread
+// and as a batch split between worker threads, on a few standard meshes and cutters.  The
+// heights from all three must be the same.  A binary STL file can be given on
+// the command line to time that as well.
+//
+//	dropcutter_bench [file.stl]
+
+#include "stdafx.h"
+#include "DropCutter.h"
+
+#include "WorkerThreads.h"
+
+#include <sys/time.h>
+#include <stdlib.h>
+
+// Wall clock time, since the batch's threads' processor times add up.
+static double Now()
+{
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	return(now.tv_sec + now.tv_usec * 1e-6);
+}
+
+static void AddTriangle( std::list<GTri> & triangles, const double *a, const double *b, const double *c )
+{
+	double x[9] = { a[0], a[1], a[2], b[0], b[1], b[2], c[0], c[1], c[2] };
+	triangles.push_back( GTri(x) );
+}
+
+/**
+	A wavy 100mm x 100mm surface, like a mould's parting face, as two triangles per 0.5mm cell.
+ */
+static void HeightField( std::list<GTri> & triangles )
+{
+	const int cells = 200;
+	const double size = 0.5;
+	for (int i = 0; i < cells; i++)
+	{
+		for (int j = 0; j < cells; j++)
+		{
+			double p[4][3];
+			for (int k = 0; k < 4; k++)
+			{
+				p[k][0] = (i + ((k == 1) || (k == 2))) * size;
+				p[k][1] = (j + (k >= 2)) * size;
+				p[k][2] = 5.0 * sin(p[k][0] * 0.1) * cos(p[k][1] * 0.13);
+			}
+			AddTriangle( triangles, p[0], p[1], p[2] );
+			AddTriangle( triangles, p[0], p[2], p[3] );
+		}
+	}
+}
+
+/**
+	A 40mm radius dome standing on a 100mm square plate.
+ */
+static void Dome( std::list<GTri> & triangles )
+{
+	const double radius = 40.0;
+	const int around = 128, up = 32;
+	const double PI = 3.14159265358979323846;
+	for (int i = 0; i < around; i++)
+	{
+		for (int j = 0; j < up; j++)
+		{
+			double p[4][3];
+			for (int k = 0; k < 4; k++)
+			{
+				double a = 2.0 * PI * (i + ((k == 1) || (k == 2))) / around;
+				double b = 0.5 * PI * (j + (k >= 2)) / up;
+				p[k][0] = 50.0 + radius * cos(b) * cos(a);
+				p[k][1] = 50.0 + radius * cos(b) * sin(a);
+				p[k][2] = radius * sin(b);
+			}
+			AddTriangle( triangles, p[0], p[1], p[2] );
+			if (j < up - 1) AddTriangle( triangles, p[0], p[2], p[3] );
+		}
+	}
+
+	double corners[4][3] = { { 0, 0, 0 }, { 100, 0, 0 }, { 100, 100, 0 }, { 0, 100, 0 } };
+	AddTriangle( triangles, corners[0], corners[1], corners[2] );
+	AddTriangle( triangles, corners[0], corners[2], corners[3] );
+}
+
+static bool ReadBinarySTL( const char *file_name, std::list<GTri> & triangles )
+{
+	FILE *fp = fopen(file_name, "rb");
+	if (fp == NULL) return(false);
+
+	char header[80];
+	unsigned int number_of_triangles = 0;
+	bool ok = (fread(header, 1, 80, fp) == 80) && (fread(&number_of_triangles, 4, 1, fp) == 1);
+	for (unsigned int i = 0; ok && (i < number_of_triangles); i++)
+	{
+		float values[12];
+		unsigned short attributes;
+		ok = (fread(values, 4, 12, fp) == 12) && (fread(&attributes, 2, 1, fp) == 1);
+		if (! ok) break;
+
+		double x[9];
+		for (int j = 0; j < 9; j++) x[j] = values[j + 3];
+		triangles.push_back( GTri(x) );
+	}
+
+	fclose(fp);
+	return(ok);
+}
+
+/**
+	Drop each cutter at a grid of positions over the triangles both ways and report the times.
+	Returns false if the two ways disagree.
+ */
+static bool Bench( const char *name, const std::list<GTri> & triangles )
+{
+	double box[4] = { 1e30, 1e30, -1e30, -1e30 };
+	for (std::list<GTri>::const_iterator l_itTri = triangles.begin(); l_itTri != triangles.end(); l_itTri++)
+	{
+		if (l_itTri->m_box[0] < box[0]) box[0] = l_itTri->m_box[0];
+		if (l_itTri->m_box[1] < box[1]) box[1] = l_itTri->m_box[1];
+		if (l_itTri->m_box[2] > box[2]) box[2] = l_itTri->m_box[2];
+		if (l_itTri->m_box[3] > box[3]) box[3] = l_itTri->m_box[3];
+	}
+
+	// Few enough positions that going through the whole list for each of them doesn't take all day.
+	const int steps = 60;
+	std::vector<double> xy;
+	for (int i = 0; i < steps; i++)
+	{
+		for (int j = 0; j < steps; j++)
+		{
+			xy.push_back( box[0] + (box[2] - box[0]) * (i + 0.5) / steps );
+			xy.push_back( box[1] + (box[3] - box[1]) * (j + 0.5) / steps );
+		}
+	}
+	const unsigned int positions = (unsigned int) (xy.size() / 2);
+
+	double start = Now();
+	TriangleGrid grid( triangles );
+	double grid_seconds = Now() - start;
+
+	printf("%s: %u triangles, %u positions, grid built in %.3fs, %u threads\n", name, (unsigned int) triangles.size(), positions, grid_seconds, CWorkerThreads::Count());
+
+	const double cutters[3][2] = { { 3.0, 0.0 }, { 3.0, 1.0 }, { 3.0, 3.0 } };
+	bool same = true;
+	for (int c = 0; c < 3; c++)
+	{
+		Cutter cutter( cutters[c][0], cutters[c][1] );
+		const double minz = -1000.0;
+
+		start = Now();
+		std::vector<double> list_z;
+		for (unsigned int i = 0; i < positions; i++)
+		{
+			double e[3] = { xy[i * 2], xy[i * 2 + 1], 0.0 };
+			list_z.push_back( DropCutter::TriTest( cutter, e, triangles, minz ) );
+		}
+		double list_seconds = Now() - start;
+
+		start = Now();
+		std::vector<double> grid_z;
+		TriangleGridScratch scratch( grid );
+		for (unsigned int i = 0; i < positions; i++)
+		{
+			double e[3] = { xy[i * 2], xy[i * 2 + 1], 0.0 };
+			grid_z.push_back( DropCutter::TriTest( cutter, e, grid, scratch, minz ) );
+		}
+		double grid_seconds = Now() - start;
+
+		start = Now();
+		std::vector<double> batch_z;
+		DropCutter::TriTest( cutter, xy, grid, minz, batch_z );
+		double batch_seconds = Now() - start;
+
+		double max_difference = 0.0;
+		for (unsigned int i = 0; i < positions; i++)
+		{
+			double difference = fabs(list_z[i] - grid_z[i]);
+			if (difference > max_difference) max_difference = difference;
+			difference = fabs(list_z[i] - batch_z[i]);
+			if (difference > max_difference) max_difference = difference;
+		}
+		if (max_difference > 1e-9) same = false;
+
+		printf("  R=%g r=%g  list %8.2f us/position  grid %8.2f us/position (%.0fx)  batch %8.2f us/position (%.0fx)  max difference %g\n",
+			cutters[c][0], cutters[c][1],
+			list_seconds * 1e6 / positions,
+			grid_seconds * 1e6 / positions, (grid_seconds > 0.0) ? (list_seconds / grid_seconds) : 0.0,
+			batch_seconds * 1e6 / positions, (batch_seconds > 0.0) ? (list_seconds / batch_seconds) : 0.0, max_difference);
+	}
+
+	return(same);
+}
+
+int main( int argc, char *argv[] )
+{
+	bool same = true;
+
+	std::list<GTri> height_field;
+	HeightField( height_field );
+	same = Bench( "height field", height_field ) && same;
+
+	std::list<GTri> dome;
+	Dome( dome );
+	same = Bench( "dome", dome ) && same;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::list<GTri> triangles;
+		if (! ReadBinarySTL( argv[i], triangles ))
+		{
+			fprintf(stderr, "Can't read %s as a binary STL file\n", argv[i]);
+			return(2);
+		}
+		same = Bench( argv[i], triangles ) && same;
+	}
+
+	if (! same) printf("FAILED: the grid, the batch and the list gave different heights\n");
+	return(same ? 0 : 1);
+}
@@ -0,0 +1,113 @@
+// edgetest_check.cpp
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+// Compares DropCutter::EdgeTest() with brute force for random bull-nose and ball cutters and
+// random edges, then times it.  The brute force samples the edge at many points and finds the
+// highest the cutter's tip can be while touching any of them.  Since the contacts at the ends
+// of the edge are the vertex tests' job, EdgeTest() is checked together with VertexTest() at
+// both ends, just as TriTest() uses them.
+//
+//	edgetest_check [number_of_edges]
+
+#include "stdafx.h"
+#include "DropCutter.h"
+
+#include <time.h>
+#include <stdlib.h>
+
+static const double no_contact = -10000000.0;
+
+static double Random( const double low, const double high )
+{
+	return(low + (high - low) * rand() / double(RAND_MAX));
+}
+
+/**
+	The highest tip height at which the cutter touches any of the samples along the edge.
+ */
+static double BruteForce( const double R, const double r, const double *e, const double *p1, const double *p2, const int samples )
+{
+	double best = no_contact;
+	for (int i = 0; i <= samples; i++)
+	{
+		double t = i / double(samples);
+		double x = p1[0] + t * (p2[0] - p1[0]) - e[0];
+		double y = p1[1] + t * (p2[1] - p1[1]) - e[1];
+		double z = p1[2] + t * (p2[2] - p1[2]);
+
+		double q = sqrt(x * x + y * y);
+		if (q > R) continue;
+
+		double d = q - (R - r);
+		double lift = (d <= 0.0) ? 0.0 : (r - sqrt(r * r - d * d));
+		if (z - lift > best) best = z - lift;
+	}
+	return(best);
+}
+
+int main( int argc, char *argv[] )
+{
+	int edges = (argc > 1) ? atoi(argv[1]) : 2000;
+	const int samples = 200000;
+	srand(1);
+
+	std::vector<Cutter> cutters;
+	std::vector<double> points;
+	double max_error = 0.0, total_error = 0.0;
+	int contacts = 0;
+	for (int i = 0; i < edges; i++)
+	{
+		double R = Random(1.0, 6.0);
+		double r = Random(0.05, 1.0) * R;
+		double e[3] = { 0.0, 0.0, 0.0 };
+		double p1[3] = { Random(-8.0, 8.0), Random(-8.0, 8.0), Random(-3.0, 3.0) };
+		double p2[3] = { Random(-8.0, 8.0), Random(-8.0, 8.0), Random(-3.0, 3.0) };
+
+		double brute_force = BruteForce(R, r, e, p1, p2, samples);
+		if (brute_force == no_contact) continue;	// The edge is nowhere under the cutter.
+
+		Cutter cutter( R, r );
+		double z = DropCutter::EdgeTest( cutter, e, p1, p2 );
+		double vertex_z = DropCutter::VertexTest( cutter, e, p1 );
+		if (vertex_z > z) z = vertex_z;
+		vertex_z = DropCutter::VertexTest( cutter, e, p2 );
+		if (vertex_z > z) z = vertex_z;
+
+		double error = fabs(z - brute_force);
+		if (error > max_error) max_error = error;
+		total_error += error;
+		contacts++;
+
+		cutters.push_back(cutter);
+		for (int j = 0; j < 3; j++) points.push_back(p1[j]);
+		for (int j = 0; j < 3; j++) points.push_back(p2[j]);
+	}
+
+	printf("%d edges under the cutter: max error %g, mean error %g\n", contacts, max_error, (contacts > 0) ? (total_error / contacts) : 0.0);
+
+	// Now just time EdgeTest() itself.
+	const int repeats = 200;
+	const double e[3] = { 0.0, 0.0, 0.0 };
+	double sum = 0.0;
+	clock_t start = clock();
+	for (int k = 0; k < repeats; k++)
+	{
+		for (unsigned int i = 0; i < cutters.size(); i++)
+		{
+			sum += DropCutter::EdgeTest( cutters[i], e, &points[i * 6], &points[i * 6 + 3] );
+		}
+	}
+	double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+	double calls = double(repeats) * cutters.size();
+	printf("EdgeTest: %.1f ns per call (checksum %g)\n", (calls > 0.0) ? (seconds * 1e9 / calls) : 0.0, sum);
+
+	// The brute force is only accurate to about the sample spacing times the edge's slope.
+	const double allowed_error = 0.0001;
+	if (max_error > allowed_error)
+	{
+		printf("FAILED: EdgeTest is more than %g from brute force\n", allowed_error);
+		return(1);
+	}
+	return(0);
+}
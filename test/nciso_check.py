@@ -0,0 +1,169 @@
+################################################################################
+# nciso_check.py
+#
+# Checks that the 'nciso' extension (src/IsoCreator.cpp) writes exactly what
+# nc/iso.py and nc/emc2.py write.  A corpus of random programs is made from the
+# calls that HeeksCNC's Python makes (moves, arcs, drilling, subroutines, CRC,
+# NURBS and awkward numbers) and each one is written by both creators and the
+# files compared.  Numbers are also formatted by both on their own, since that's
+# where most of the differences would be.
+#
+#   python2 nciso_check.py [build directory] [programs per dialect]
+#
+# The build directory is the one holding nciso.so (test/build by default).
+
+import sys
+import os
+import random
+import filecmp
+import shutil
+
+here = os.path.dirname(os.path.abspath(__file__))
+build = os.path.abspath(sys.argv[1]) if len(sys.argv) > 1 else os.path.join(here, 'build')
+count = int(sys.argv[2]) if len(sys.argv) > 2 else 500
+
+sys.path.insert(0, build)
+sys.path.insert(0, os.path.dirname(here))
+
+import nciso
+import nc.nc
+import nc.iso
+import nc.emc2
+from nc.format import Format
+
+# iso.py never defines FEEDRATE(), so its feedrate() fails.  Give it the code the
+# native creator writes.
+nc.iso.Creator.FEEDRATE = lambda self: 'F'
+
+################################################################################
+# the corpus
+
+def number(r):
+    k = r.random()
+    if k < 0.1: return r.randint(-50, 50)
+    if k < 0.2: return r.choice([0.0, -0.0, 1e-5, -1e-5, 0.0004, -0.0004, 0.0006, -0.0006, 9e-05, 1.0005, 2.5, -2.5, 123456.789012, 123456789012.5, 1.5e11])
+    if k < 0.3: return round(r.uniform(-100, 100), r.randint(0, 4))
+    return r.uniform(-200, 200)
+
+def opt(r, p = 0.6):
+    if r.random() < p: return number(r)
+    return None
+
+def program(seed, dialect):
+    # a list of (method name, arguments, keyword arguments)
+    r = random.Random(seed)
+    calls = []
+    c = calls.append
+    c(('program_begin', (r.randint(1, 9999), 'Prog (%d)' % seed), {}))
+    c((r.choice(['metric', 'metric', 'imperial']), (), {}))
+    c(('absolute', (), {}))
+    if dialect == 'emc2': c(('set_plane', (r.randint(0, 2),), {}))
+    c(('flush_nc', (), {}))
+    c(('feedrate', (r.choice([500, 99.999]),), {}))
+    tool = False
+    for i in range(r.randint(20, 400)):
+        k = r.randint(0, 27)
+        if k == 0:
+            c(('tool_change', (r.randint(1, 30),), {'description': r.choice([None, 'Drill (3mm)', 'mill'])}))
+            tool = True
+        elif k == 1: c(('spindle', (r.choice([0, 1000, -500, 12000.456, 2500]),), {'clockwise': r.choice([True, False])}))
+        elif k == 2: c(('coolant', (r.randint(0, 2),), {}))
+        elif k == 3: c(('feedrate', (r.choice([100, 250.5, 1234.5678, number(r)]),), {}))
+        elif k == 4: c(('feedrate_hv', (abs(number(r)), abs(number(r))), {}))
+        elif k in (5, 6, 7): c(('rapid', (opt(r), opt(r), opt(r)), {'machine_coordinates': r.choice([None, None, True])}))
+        elif k in (8, 9, 10, 11): c(('feed', (opt(r), opt(r), opt(r)), {}))
+        elif k == 12: c(('feed', (), {}))
+        elif k in (13, 14):
+            c((r.choice(['arc_cw', 'arc_ccw']), (number(r), number(r), opt(r, 0.3)), {'i': number(r), 'j': number(r), 'k': opt(r, 0.2), 'r': opt(r, 0.2)}))
+        elif k == 15:
+            c(('drill', (), dict(x=number(r), y=number(r), z=number(r), depth=abs(number(r)), standoff=abs(number(r)), dwell=0,
+                                 peck_depth=r.choice([0, 0, 1.5, number(r)]), retract_mode=0, spindle_mode=0, clearance_height=opt(r))))
+        elif k == 16: c(('end_canned_cycle', (), {}))
+        elif k == 17: c(('comment', (r.choice(['plain', 'with (brackets)', 'x']),), {}))
+        elif k == 18:
+            if dialect == 'emc2': c(('variable_set', (str(r.randint(1, 99)), r.choice(['1.5', '[#5 + 2]'])), {}))
+            else: c(('variable_set', (r.randint(1, 99), number(r)), {}))
+        elif k == 19: c(('set_temporary_origin', (opt(r), opt(r), opt(r)), {}))
+        elif k == 20: c(('remove_temporary_origin', (), {}))
+        elif k == 21:
+            n = r.randint(1, 99)
+            c(('sub_begin', (n, 'sub (%d)' % n), {}))
+            c(('sub_end', (), {}))
+            c(('sub_call', (n,), {}))
+        elif k == 22: c(('workplane', (r.randint(0, 10),), {}))
+        elif k == 23 and tool:
+            c(('start_CRC', (r.choice([True, False]),), {}))
+            c(('end_CRC', (), {}))
+        elif k == 24: c(('program_stop', (r.choice([True, False]),), {}))
+        elif k == 25:
+            if dialect == 'emc2':
+                c(('nurbs_begin_definition', (0,), dict(degree=3, x=number(r), y=number(r), weight=1.0)))
+                c(('nurbs_add_pole', (0,), dict(x=number(r), y=number(r), weight=number(r))))
+                c(('nurbs_end_definition', (0,), {}))
+            else:
+                c(('tool_defn', (r.randint(1, 9), 'tool', opt(r), opt(r), None), {}))
+        elif k == 26: c(('predefined_position', (r.choice(['G28', 'G30']),), {}))
+        elif k == 27:
+            c((r.choice(['incremental', 'absolute', 'polar', 'coolant']), (), {}))
+            c(('rapid', (number(r), number(r)), {}))
+            c(('absolute', (), {}))
+            c(('rapid', (number(r), number(r)), {}))
+    c(('program_end', (), {}))
+    return calls
+
+def run(calls, creator, file_name):
+    creator.file_open(file_name)
+    for name, args, kwargs in calls:
+        getattr(creator, name)(*args, **kwargs)
+    creator.file_close()
+
+################################################################################
+# the checks
+
+def check_programs():
+    failures = 0
+    python_file = os.path.join(build, 'nciso_python.tap')
+    native_file = os.path.join(build, 'nciso_native.tap')
+    for dialect, python_class, native in [('iso', nc.iso.Creator, nciso.ISO), ('emc2', nc.emc2.Creator, nciso.EMC2)]:
+        for seed in range(count):
+            calls = program(seed, dialect)
+            run(calls, python_class(), python_file)
+            run(calls, nciso.Creator(native), native_file)
+            if not filecmp.cmp(python_file, native_file, shallow=False):
+                failures += 1
+                if failures <= 3:
+                    # keep the first few for diffing
+                    suffix = '.%s%d' % (dialect, seed)
+                    shutil.copy(python_file, python_file + suffix)
+                    shutil.copy(native_file, native_file + suffix)
+                    print 'FAILED: %s program %d differs (see %s and %s)' % (dialect, seed, python_file + suffix, native_file + suffix)
+    print '%d programs per dialect: %d differ' % (count, failures)
+    return failures == 0
+
+def check_numbers():
+    r = random.Random(2)
+    numbers = []
+    for i in range(20000):
+        numbers.append(r.randint(-10**12, 10**12) / float(2**r.randint(0, 14)) * 10**r.randint(-8, 4))
+    numbers += [1e11, 99999999999.99999, 1e13, -1e13, 123456789012.5, 5e-5, -9e-05, 0.0, -0.0]
+
+    file_name = os.path.join(build, 'nciso_numbers.txt')
+    same = True
+    for decimal_places, imperial in ((3, False), (4, True)):
+        creator = nciso.Creator(nciso.ISO)
+        creator.file_open(file_name)
+        if imperial: creator.imperial()
+        for x in numbers: creator.set_temporary_origin(x)
+        creator.file_close()
+
+        written = [line.split(' X ')[1].rstrip('\n') for line in open(file_name)]
+        f = Format(decimal_places)
+        different = [(x, f.string(x), w) for x, w in zip(numbers, written) if f.string(x) != w]
+        print '%d decimal places: %d numbers, %d differ %s' % (decimal_places, len(numbers), len(different), different[:3])
+        if len(different) > 0 or len(written) != len(numbers): same = False
+    return same
+
+ok = check_numbers()
+ok = check_programs() and ok
+if not ok: print 'FAILED: nciso and the Python creators wrote different NC code'
+sys.exit(0 if ok else 1)
@@ -0,0 +1,53 @@
+// stdafx.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+// Stands in for src/stdafx.h when source files are built into the stand-alone
+// test programs in this directory.  Only the few pieces of HeeksCAD and
+// wxWidgets that those files use are provided.
+
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include <list>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+
+class CHeeksCADInterface
+{
+public:
+	double GetTolerance() const { return(0.001); }
+};
+
+static CHeeksCADInterface heeks_cad_interface;
+static CHeeksCADInterface *heeksCAD = &heeks_cad_interface;
+
+#define _T(x) x
+
+class wxString : public std::string
+{
+public:
+	wxString( const char *text = "" ) : std::string(text) { }
+
+	static wxString Format( const char *format, ... )
+	{
+		char buffer[1024];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		return(wxString(buffer));
+	}
+};
+
+// The test programs have no windows so any messages go to stderr instead.
+inline void wxMessageBox( const wxString & message )
+{
+	fprintf(stderr, "%s\n", message.c_str());
+}
@@ -0,0 +1,63 @@
+// thread.h
+// Copyright (c) 2010, Dan Heeks
+// This program is released under the BSD license. See the file COPYING for details.
+
+// Stands in for wxWidgets' wx/thread.h in the stand-alone test programs.  Only the
+// joinable threads that src/WorkerThreads.cpp uses are provided, on top of POSIX threads.
+
+#pragma once
+
+#include <pthread.h>
+#include <unistd.h>
+
+enum wxThreadKind
+{
+	wxTHREAD_DETACHED,
+	wxTHREAD_JOINABLE
+};
+
+enum wxThreadError
+{
+	wxTHREAD_NO_ERROR = 0,
+	wxTHREAD_NO_RESOURCE,
+	wxTHREAD_RUNNING,
+	wxTHREAD_NOT_RUNNING,
+	wxTHREAD_KILLED,
+	wxTHREAD_MISC_ERROR
+};
+
+class wxThread
+{
+public:
+	typedef void *ExitCode;
+
+	wxThread( wxThreadKind kind = wxTHREAD_DETACHED ) : m_started(false) { }
+	virtual ~wxThread() { }
+
+	wxThreadError Create( unsigned int stack_size = 0 ) { return(wxTHREAD_NO_ERROR); }
+
+	wxThreadError Run()
+	{
+		m_started = (pthread_create( &m_thread, NULL, Start, this ) == 0);
+		return(m_started ? wxTHREAD_NO_ERROR : wxTHREAD_NO_RESOURCE);
+	}
+
+	ExitCode Wait()
+	{
+		void *exit_code = NULL;
+		if (m_started) pthread_join( m_thread, &exit_code );
+		m_started = false;
+		return(exit_code);
+	}
+
+	static int GetCPUCount() { return((int) sysconf(_SC_NPROCESSORS_ONLN)); }
+
+protected:
+	virtual ExitCode Entry() = 0;
+
+private:
+	pthread_t m_thread;
+	bool m_started;
+
+	static void *Start( void *thread ) { return(((wxThread *) thread)->Entry()); }
+};